@@ -41,8 +41,9 @@ app.post('/upload', upload.single('pseudocodeFile'), (req, res) => {
     const binaryFilePath = path.join(__dirname, './a.exe'); // Path to the pre-compiled binary
     const outputFilePath = path.join(__dirname, '../uploads/code.cpp'); // Output C++ file path
 
-    // Execute the pre-compiled binary
-    exec(`"${binaryFilePath}" "${pseudocodeFile}"`, { cwd: path.join(__dirname, '../uploads') }, (error, stdout, stderr) => {
+    // Execute the pre-compiled binary. Each upload is translated once, so skip the
+    // AST cache rather than leave a .ast file next to every upload
+    exec(`"${binaryFilePath}" --no-cache "${pseudocodeFile}"`, { cwd: path.join(__dirname, '../uploads') }, (error, stdout, stderr) => {
         if (error) {
             console.error(`Execution error: ${error}`);
             res.status(500).send('Error running compiled program');
@@ -0,0 +1,201 @@
+#include "../../src/codeGenerator/codeGenerator.cpp"
+#include <chrono>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+using namespace std;
+
+// Live and peak heap bytes, tracked by the replaced operator new and delete below
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+
+void* operator new(size_t size) {
+    if (void* ptr = malloc(size)) {
+        liveBytes += malloc_usable_size(ptr);
+        peakBytes = max(peakBytes, liveBytes);
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) {
+        liveBytes -= malloc_usable_size(ptr);
+        free(ptr);
+    }
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// Read a whole file into a string
+string readFile(const string& path) {
+    ifstream inputFile(path);
+    if (!inputFile) {
+        cerr << "Failed to open " << path << endl;
+        exit(1);
+    }
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    return buffer.str();
+}
+
+// Repeat the sample program until the input reaches the requested size
+string scaleInput(const string& sample, size_t targetBytes) {
+    string input;
+    input.reserve(targetBytes + sample.size() + 1);
+    while (input.size() < targetBytes) {
+        input += sample;
+        input += '\n';
+    }
+    return input;
+}
+
+double millisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Typical analysis walk: count identifier nodes and sum their lexeme lengths
+void visitTree(const Node& node, size_t& identifiers, size_t& lexemeBytes) {
+    if (node.type == NodeType::IDENTIFIER) {
+        identifiers++;
+        lexemeBytes += node.token.lexeme.size();
+    }
+    for (const Node& child : node.children) {
+        visitTree(child, identifiers, lexemeBytes);
+    }
+}
+
+// Same walk over the flat form: pre-order is array order, so it is one loop
+void visitFlat(const FlatAst& ast, size_t& identifiers, size_t& lexemeBytes) {
+    for (size_t index = 0; index < ast.size(); index++) {
+        if (ast.node(index).type == NodeType::IDENTIFIER) {
+            identifiers++;
+            lexemeBytes += ast.token(index).lexeme.size();
+        }
+    }
+}
+
+// Walk and generate code from the tree and from the flat encoding
+void benchTraversal(const string& input, int rounds) {
+    vector<Token> tokens = Tokenizer(input).tokenize();
+    Parser parser(tokens);
+    Node ast = parser.parse();
+    auto start = chrono::steady_clock::now();
+    FlatAst flat = FlatAst::fromTree(ast);
+    double flattenMs = millisecondsSince(start);
+    cout << "nodes: " << flat.size() << ", flatten " << flattenMs << " ms" << endl;
+
+    size_t treeIdentifiers = 0, treeBytes = 0;
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        visitTree(ast, treeIdentifiers, treeBytes);
+    }
+    double treeMs = millisecondsSince(start) / rounds;
+
+    size_t flatIdentifiers = 0, flatBytes = 0;
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        visitFlat(flat, flatIdentifiers, flatBytes);
+    }
+    double flatMs = millisecondsSince(start) / rounds;
+
+    cout << "walk: tree " << treeMs << " ms, flat " << flatMs << " ms, speedup " << treeMs / flatMs
+         << "x (" << treeIdentifiers / rounds << "/" << flatIdentifiers / rounds << " identifiers)" << endl;
+
+    CodeGenerator generator;
+    start = chrono::steady_clock::now();
+    size_t treeCode = generator.generateCode(ast).size();
+    double treeCodeMs = millisecondsSince(start);
+    start = chrono::steady_clock::now();
+    size_t flatCode = generator.generateCode(flat).size();
+    double flatCodeMs = millisecondsSince(start);
+
+    cout << "generateCode: tree " << treeCodeMs << " ms, flat " << flatCodeMs << " ms ("
+         << treeCode << "/" << flatCode << " bytes)" << endl;
+}
+
+// Source to output file both ways: tokenize, parse, generateCode and write the string,
+// against translate() streaming into the file. Peak heap is measured above what was
+// live before each run; the source itself is not counted.
+void benchDirect(const string& input, const string& outputPath) {
+    for (bool direct : { false, true }) {
+        size_t baseline = liveBytes;
+        peakBytes = liveBytes;
+        auto start = chrono::steady_clock::now();
+        {
+            ofstream output(outputPath);
+            Tokenizer tokenizer(input);
+            Parser parser(tokenizer);
+            CodeGenerator generator;
+            if (direct) {
+                generator.translate(parser, output);
+            } else {
+                output << generator.generateCode(parser.parse());
+            }
+        }
+        double ms = millisecondsSince(start);
+        cout << (direct ? "translate:    " : "generateCode: ") << ms << " ms, peak heap "
+             << (peakBytes - baseline) / 1024 << " KB" << endl;
+    }
+}
+
+// `depth` While loops nested inside each other, each with one statement
+string nestedLoops(int depth) {
+    string input;
+    for (int level = 0; level < depth; level++) {
+        input += "While x > " + to_string(level) + " Do\nAssign x = x - 1\n";
+    }
+    for (int level = 0; level < depth; level++) {
+        input += "End While\n";
+    }
+    return input;
+}
+
+// Parse, print and generate code for deeply nested input; the rounds keep the
+// total work about the same at every depth
+void benchNesting(int depth) {
+    string input = nestedLoops(depth);
+    vector<Token> tokens = Tokenizer(input).tokenize();
+    int rounds = max(1, 100000 / depth);
+    cout << "depth " << depth << " (" << rounds << " rounds):" << flush;
+
+    double parseMs = 0, printMs = 0, generateMs = 0;
+    size_t codeBytes = 0;
+    for (int round = 0; round < rounds; round++) {
+        auto start = chrono::steady_clock::now();
+        Parser parser(tokens);
+        Node ast = parser.parse();
+        parseMs += millisecondsSince(start);
+
+        // Print to a stream with no buffer, which discards the output
+        streambuf* console = cout.rdbuf(nullptr);
+        start = chrono::steady_clock::now();
+        printAST(ast);
+        printMs += millisecondsSince(start);
+        cout.rdbuf(console);
+        cout.clear();
+
+        CodeGenerator generator;
+        start = chrono::steady_clock::now();
+        codeBytes += generator.generateCode(ast).size();
+        generateMs += millisecondsSince(start);
+    }
+    cout << " parse " << parseMs / rounds << " ms, printAST " << printMs / rounds << " ms, generateCode "
+         << generateMs / rounds << " ms (" << codeBytes / rounds << " bytes)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string samplePath = argc > 1 ? argv[1] : "../../src/pseudocode/pseudocode.txt";
+    size_t targetMegabytes = argc > 2 ? atoi(argv[2]) : 20;
+
+    string input = scaleInput(readFile(samplePath), targetMegabytes * 1024 * 1024);
+    benchTraversal(input, 10);
+    benchDirect(input, "/tmp/bench_codeGenerator.cpp");
+    for (int depth : { 10, 1000, 100000 }) {
+        benchNesting(depth);
+    }
+
+    return 0;
+}
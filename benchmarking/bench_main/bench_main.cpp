@@ -0,0 +1,166 @@
+#include "../../src/codeGenerator/codeGenerator.cpp"
+#include "../../src/main/sourceBuffer.cpp"
+#include "../../src/main/astCache.cpp"
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+// Write the sample program repeatedly until the file reaches the requested size
+void writeScaledFile(const string& samplePath, const string& outputPath, size_t targetBytes) {
+    ifstream sampleFile(samplePath);
+    if (!sampleFile) {
+        cerr << "Failed to open " << samplePath << endl;
+        exit(1);
+    }
+    stringstream sample;
+    sample << sampleFile.rdbuf();
+
+    ofstream outputFile(outputPath, ios::binary);
+    for (size_t written = 0; written < targetBytes; written += sample.str().size() + 1) {
+        outputFile << sample.str() << '\n';
+    }
+}
+
+// Old driver path: ifstream -> stringstream -> string, then a by-value copy into the tokenizer
+double firstTokenViaStream(const string& path) {
+    auto start = chrono::steady_clock::now();
+
+    ifstream inputFile(path);
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    string pseudocode = buffer.str();
+    string tokenizerCopy = pseudocode;
+    Tokenizer tokenizer(tokenizerCopy);
+    Token token = tokenizer.nextToken();
+
+    auto end = chrono::steady_clock::now();
+    if (token.type == TokenType::END_OF_FILE) {
+        cerr << "empty input" << endl;
+    }
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+// Current driver path: map the file and tokenize the mapping in place
+double firstTokenViaMapping(const string& path) {
+    auto start = chrono::steady_clock::now();
+
+    SourceBuffer source(path);
+    Tokenizer tokenizer(source.view());
+    Token token = tokenizer.nextToken();
+
+    auto end = chrono::steady_clock::now();
+    if (token.type == TokenType::END_OF_FILE || !source.isMapped()) {
+        cerr << "input was not mapped" << endl;
+    }
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+// Best of a few runs of `run`, in milliseconds
+template <typename Run>
+double bestMs(Run run, int repeats = 5) {
+    double best = 1e300;
+    for (int repeat = 0; repeat < repeats; repeat++) {
+        auto start = chrono::steady_clock::now();
+        run();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// Driver start-up with and without the AST cache: map the input, then either tokenize
+// and parse it or map its cache, hash the input and check the header
+void benchAstCache(const string& samplePath, const string& scratchDir, size_t targetStatements) {
+    SourceBuffer sample(samplePath);
+    size_t sampleStatements = 0;
+    {
+        Tokenizer tokenizer(sample.view());
+        Parser parser(tokenizer);
+        sampleStatements = parser.parse().children.size();
+    }
+    string path = scratchDir + "/bench_main_cache.txt";
+    {
+        ofstream outputFile(path, ios::binary);
+        for (size_t statements = 0; statements < targetStatements; statements += sampleStatements) {
+            outputFile << sample.view() << '\n';
+        }
+    }
+    string cachePath = path + ".ast";
+
+    SourceBuffer source(path);
+    size_t nodes = 0;
+    string parsedCode;
+    {
+        Tokenizer tokenizer(source.view());
+        Parser parser(tokenizer);
+        Node ast = parser.parse();
+        FlatAst flat = FlatAst::fromTree(ast);
+        nodes = flat.size();
+        if (!AstCache::write(cachePath, flat, source.view())) {
+            cerr << "Failed to write " << cachePath << endl;
+            exit(1);
+        }
+        parsedCode = CodeGenerator().generateCode(ast);
+    }
+    unique_ptr<AstCache> cache = AstCache::load(cachePath, source.view());
+    if (!cache || CodeGenerator().generateProgram(cache->root()) != parsedCode) {
+        cerr << "AST cache does not reproduce the parse" << endl;
+        exit(1);
+    }
+
+    double parseMs = bestMs([&] {
+        SourceBuffer input(path);
+        Tokenizer tokenizer(input.view());
+        Parser parser(tokenizer);
+        if (parser.parse().children.empty()) {
+            cerr << "empty parse" << endl;
+        }
+    });
+    double loadMs = bestMs([&] {
+        SourceBuffer input(path);
+        if (!AstCache::load(cachePath, input.view())) {
+            cerr << "cache miss" << endl;
+        }
+    });
+    double parseGenerateMs = bestMs([&] {
+        SourceBuffer input(path);
+        Tokenizer tokenizer(input.view());
+        Parser parser(tokenizer);
+        CodeGenerator().generateCode(parser.parse());
+    });
+    double loadGenerateMs = bestMs([&] {
+        SourceBuffer input(path);
+        unique_ptr<AstCache> loaded = AstCache::load(cachePath, input.view());
+        CodeGenerator().generateProgram(loaded->root());
+    });
+
+    ifstream cacheFile(cachePath, ios::binary | ios::ate);
+    cout << "AST cache, " << (targetStatements + sampleStatements - 1) / sampleStatements * sampleStatements
+         << " top-level statements, " << nodes << " nodes, " << cacheFile.tellg() / 1024 << " KB cache:" << endl;
+    cout << "  tokenize+parse " << parseMs << " ms, cache load " << loadMs << " ms ("
+         << parseMs / loadMs << "x)" << endl;
+    cout << "  with code generation: " << parseGenerateMs << " ms vs " << loadGenerateMs << " ms" << endl;
+    remove(path.c_str());
+    remove(cachePath.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    string samplePath = argc > 1 ? argv[1] : "../../src/pseudocode/pseudocode_final.txt";
+    string scratchDir = argc > 2 ? argv[2] : "/tmp";
+
+    // The cache needs a sample that parses; pseudocode_final.txt has a syntax error
+    benchAstCache("../../src/pseudocode/pseudocode.txt", scratchDir, 100000);
+
+    for (size_t megabytes : { 1, 100 }) {
+        string path = scratchDir + "/bench_main_" + to_string(megabytes) + "mb.txt";
+        writeScaledFile(samplePath, path, megabytes * 1024 * 1024);
+
+        // Warm the page cache once so both paths read from memory
+        firstTokenViaMapping(path);
+
+        cout << megabytes << " MB startup-to-first-token: ifstream+copies "
+             << firstTokenViaStream(path) << " ms, mmap " << firstTokenViaMapping(path) << " ms" << endl;
+        remove(path.c_str());
+    }
+
+    return 0;
+}
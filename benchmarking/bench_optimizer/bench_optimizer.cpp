@@ -0,0 +1,202 @@
+#include "../../src/codeGenerator/codeGenerator.cpp"
+#include "../../src/optimizer/optimizer.cpp"
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+// Read a whole file into a string
+string readFile(const string& path) {
+    ifstream inputFile(path);
+    if (!inputFile) {
+        cerr << "Failed to open " << path << endl;
+        exit(1);
+    }
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    return buffer.str();
+}
+
+// Repeat the sample program until the input has at least the requested number of lines.
+// Each copy goes in its own If block so its declarations do not clash with the others.
+string scaleScoped(const string& sample, size_t targetLines) {
+    size_t sampleLines = count(sample.begin(), sample.end(), '\n') + 3;
+    string input = "Declare copy As Integer\nRead copy\n";
+    for (size_t lines = 0; lines < targetLines; lines += sampleLines) {
+        input += "If copy = 0 Then\n";
+        input += sample;
+        input += "\nEnd If\n";
+    }
+    return input;
+}
+
+double microsecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// Best of `rounds` optimizer runs, each on a fresh parse of `input`
+double bestOptimizeUs(const string& input, uint32_t passes, int rounds) {
+    double best = 1e100;
+    for (int round = 0; round < rounds; round++) {
+        Tokenizer tokenizer(input);
+        Parser parser(tokenizer);
+        Node ast = parser.parse();
+        Optimizer optimizer(passes);
+        auto start = chrono::steady_clock::now();
+        optimizer.optimize(ast, tokenizer.identifierTable());
+        best = min(best, microsecondsSince(start));
+    }
+    return best;
+}
+
+// Cost of each pass on a large program, next to the parse it follows
+void benchLargeProgram(const string& sample) {
+    string input = scaleScoped(sample, 100000);
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    auto start = chrono::steady_clock::now();
+    Node ast = parser.parse();
+    double parseUs = microsecondsSince(start);
+
+    double foldUs = bestOptimizeUs(input, Optimizer::FOLD_CONSTANTS, 3);
+    double allUs = bestOptimizeUs(input, Optimizer::allPasses, 3);
+    cout << count(input.begin(), input.end(), '\n') << " lines, " << ast.children.size()
+         << " top-level statements: parse " << parseUs / 1000 << " ms, folding "
+         << foldUs / 1000 << " ms, folding + dead code " << allUs / 1000 << " ms" << endl;
+}
+
+// C++ for `input` with the given optimizer passes
+string translate(const string& input, uint32_t passes, OptimizerStats* stats = nullptr) {
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    Optimizer optimizer(passes);
+    optimizer.optimize(ast, tokenizer.identifierTable());
+    if (stats) {
+        *stats = optimizer.stats();
+    }
+    CodeGenerator generator;
+    return generator.generateCode(ast);
+}
+
+// Translate `input` with `passes`, then time g++ on the result and measure the binary
+void compileWith(const string& input, uint32_t passes, const string& label, const string& scratchDirectory) {
+    OptimizerStats stats;
+    string code = translate(input, passes, &stats);
+
+    string cppPath = scratchDirectory + "/bench_optimizer.cpp";
+    string binaryPath = scratchDirectory + "/bench_optimizer.out";
+    ofstream(cppPath) << code;
+    auto start = chrono::steady_clock::now();
+    int status = system(("g++ -std=c++17 -O0 " + cppPath + " -o " + binaryPath + " 2> /dev/null").c_str());
+    double compileUs = microsecondsSince(start);
+    ifstream binary(binaryPath, ios::binary | ios::ate);
+    long long binaryBytes = binary ? static_cast<long long>(binary.tellg()) : -1;
+    remove(cppPath.c_str());
+    remove(binaryPath.c_str());
+
+    cout << label << ": " << count(code.begin(), code.end(), '\n') << " lines of C++, g++ -O0 "
+         << compileUs / 1000 << " ms (exit status " << status << "), binary " << binaryBytes << " bytes";
+    if (passes & Optimizer::ELIMINATE_DEAD_CODE) {
+        cout << "; removed " << stats.removedBranches << " branches, " << stats.deadStores << " stores, "
+             << stats.unusedDeclarations << " declarations";
+    }
+    cout << endl;
+}
+
+// What dead code elimination saves the C++ compiler on an array-heavy program
+void benchCompile(const string& sample, const string& scratchDirectory) {
+    string input = scaleScoped(sample, 5000);
+    compileWith(input, Optimizer::FOLD_CONSTANTS, "folding only", scratchDirectory);
+    compileWith(input, Optimizer::allPasses, "folding + dead code", scratchDirectory);
+}
+
+// Numeric kernels as a code generator would write them: a 2D fill and reduction with
+// the row offset computed from the loop variable, and a 1D scaled update
+const string gridKernel = "Declare m As Integer\n"
+                          "Declare total As Integer\n"
+                          "Declare grid As Array Of Integer[200][300]\n"
+                          "Declare sums As Array Of Integer[300]\n"
+                          "Read m\n"
+                          "Assign total = 0\n"
+                          "For j = 0 To 299 Do\n"
+                          "    Assign sums[j] = 0\n"
+                          "End For\n"
+                          "For r = 1 To 100 Do\n"
+                          "    For i = 0 To 199 Do\n"
+                          "        For j = 0 To 299 Do\n"
+                          "            Assign grid[i][j] = i * m + j * 3 + r\n"
+                          "            Assign sums[j] = sums[j] + grid[i][j] - i * 2\n"
+                          "        End For\n"
+                          "    End For\n"
+                          "End For\n"
+                          "For j = 0 To 299 Do\n"
+                          "    Assign total = total + sums[j] / 1000\n"
+                          "End For\n"
+                          "Print total\n";
+const string scaleKernel = "Declare k As Integer\n"
+                           "Declare total As Integer\n"
+                           "Declare values As Array Of Integer[1000]\n"
+                           "Read k\n"
+                           "Assign total = 0\n"
+                           "For i = 0 To 999 Do\n"
+                           "    Assign values[i] = 0\n"
+                           "End For\n"
+                           "For r = 1 To 20000 Do\n"
+                           "    For i = 0 To 999 Do\n"
+                           "        Assign values[i] = values[i] + i * k - r\n"
+                           "    End For\n"
+                           "End For\n"
+                           "For i = 0 To 999 Do\n"
+                           "    Assign total = total + values[i] / 1000\n"
+                           "End For\n"
+                           "Print total\n";
+
+// Best of `rounds` runs of a compiled kernel, in milliseconds
+double bestRunMs(const string& command, int rounds) {
+    double best = 1e100;
+    for (int round = 0; round < rounds; round++) {
+        auto start = chrono::steady_clock::now();
+        if (system(command.c_str()) != 0) {
+            return -1;
+        }
+        best = min(best, microsecondsSince(start) / 1000);
+    }
+    return best;
+}
+
+// Run time of each kernel at -O0 and -O2, with and without strength reduction
+void benchKernels(const string& scratchDirectory) {
+    const pair<string, const string*> kernels[] = { { "grid kernel", &gridKernel }, { "scale kernel", &scaleKernel } };
+    for (const auto& [label, kernel] : kernels) {
+        for (const string level : { "-O0", "-O2" }) {
+            double milliseconds[2];
+            for (int reduced = 0; reduced < 2; reduced++) {
+                uint32_t passes = reduced ? Optimizer::allPasses : Optimizer::defaultPasses;
+                string cppPath = scratchDirectory + "/bench_optimizer_kernel.cpp";
+                string binaryPath = scratchDirectory + "/bench_optimizer_kernel.out";
+                ofstream(cppPath) << translate(*kernel, passes);
+                if (system(("g++ -std=c++17 " + level + " " + cppPath + " -o " + binaryPath).c_str()) != 0) {
+                    cerr << "Failed to compile the " << label << endl;
+                    exit(1);
+                }
+                milliseconds[reduced] = bestRunMs("echo 7 | " + binaryPath + " > /dev/null", 3);
+                remove(cppPath.c_str());
+                remove(binaryPath.c_str());
+            }
+            cout << label << " " << level << ": " << milliseconds[0] << " ms, with strength reduction "
+                 << milliseconds[1] << " ms (" << milliseconds[0] / milliseconds[1] << "x)" << endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    string samplePath = argc > 1 ? argv[1] : "../../src/pseudocode/pseudocode.txt";
+    string scratchDirectory = argc > 2 ? argv[2] : "/tmp";
+
+    string sample = readFile(samplePath);
+    benchLargeProgram(sample);
+    benchCompile(sample, scratchDirectory);
+    benchKernels(scratchDirectory);
+
+    return 0;
+}
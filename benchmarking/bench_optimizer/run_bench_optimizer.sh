@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# Ensure the script stops on any error
+set -e
+
+# Define paths for source files and the output executable
+BENCH_OPTIMIZER_SRC="bench_optimizer.cpp"
+OUTPUT_EXEC="optimizer_bench"
+
+# Step 1: Compile the benchmark with optimizations
+echo "Compiling optimizer benchmark..."
+g++ -std=c++17 -O2 -pthread $BENCH_OPTIMIZER_SRC -o $OUTPUT_EXEC
+
+# Step 2: Run the benchmark (optional args: sample file, scratch directory)
+echo "Running benchmark..."
+./$OUTPUT_EXEC "$@"
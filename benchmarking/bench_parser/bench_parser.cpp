@@ -0,0 +1,195 @@
+#include "../../src/parser/parser.cpp"
+#include <chrono>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+// Global allocation counter, bumped by the replaced operator new below
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+// Read a whole file into a string
+string readFile(const string& path) {
+    ifstream inputFile(path);
+    if (!inputFile) {
+        cerr << "Failed to open " << path << endl;
+        exit(1);
+    }
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    return buffer.str();
+}
+
+// Repeat the sample program until the input reaches the requested size
+string scaleInput(const string& sample, size_t targetBytes) {
+    string input;
+    input.reserve(targetBytes + sample.size() + 1);
+    while (input.size() < targetBytes) {
+        input += sample;
+        input += '\n';
+    }
+    return input;
+}
+
+// Repeat the sample program until the input has at least the requested number of lines
+string scaleLines(const string& sample, size_t targetLines) {
+    size_t sampleLines = count(sample.begin(), sample.end(), '\n') + 1;
+    string input;
+    for (size_t lines = 0; lines < targetLines; lines += sampleLines) {
+        input += sample;
+        input += '\n';
+    }
+    return input;
+}
+
+double millisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Parse from a token vector versus compact struct-of-arrays storage
+void benchTokenStorage(const string& input) {
+    vector<Token> tokens = Tokenizer(input).tokenize();
+    Tokenizer compactTokenizer(input);
+    TokenStore store = compactTokenizer.tokenizeCompact();
+
+    cout << "token memory: vector " << tokens.size() * sizeof(Token) / (1024 * 1024) << " MB ("
+         << sizeof(Token) << " B/token), store " << store.memoryBytes() / (1024 * 1024) << " MB ("
+         << store.memoryBytes() / double(store.size()) << " B/token)" << endl;
+
+    auto start = chrono::steady_clock::now();
+    size_t vectorStatements = Parser(tokens).parse().children.size();
+    double vectorMs = millisecondsSince(start);
+
+    start = chrono::steady_clock::now();
+    size_t storeStatements = Parser(store).parse().children.size();
+    double storeMs = millisecondsSince(start);
+
+    cout << "parse: vector " << vectorMs << " ms, store " << storeMs << " ms ("
+         << vectorStatements << "/" << storeStatements << " statements)" << endl;
+}
+
+// Heap allocations and time spent building and freeing the AST, tokens already in hand
+void benchAstAllocation(const string& input) {
+    vector<Token> tokens = Tokenizer(input).tokenize();
+    Parser parser(tokens);
+
+    size_t allocationsBefore = allocationCount;
+    auto start = chrono::steady_clock::now();
+    Node ast = parser.parse();
+    double parseMs = millisecondsSince(start);
+    size_t allocations = allocationCount - allocationsBefore;
+
+    AstArena arena = parser.takeArena();
+    size_t nodes = arena.nodeCount();
+    size_t blocks = arena.blockCount();
+    start = chrono::steady_clock::now();
+    arena = AstArena();
+    double freeMs = millisecondsSince(start);
+
+    cout << "AST: " << count(input.begin(), input.end(), '\n') << " lines, " << ast.children.size()
+         << " statements, " << nodes << " nodes in " << blocks << " arena blocks, " << allocations
+         << " heap allocations, parse " << parseMs << " ms, free " << freeMs << " ms" << endl;
+}
+
+// Insert a broken statement after every `interval`-th line
+string injectErrors(const string& input, size_t interval) {
+    const char* broken[] = { "Assign = 1\n", "Declare As Integer\n", "Print x +\n" };
+    string output;
+    size_t lineNumber = 0, errors = 0;
+    for (size_t start = 0; start < input.size();) {
+        size_t end = input.find('\n', start);
+        end = end == string::npos ? input.size() : end + 1;
+        output.append(input, start, end - start);
+        if (++lineNumber % interval == 0) {
+            output += broken[errors++ % 3];
+        }
+        start = end;
+    }
+    return output;
+}
+
+// Best of `rounds` parses, with or without error recovery
+double bestParseMs(const vector<Token>& tokens, bool recover, int rounds, size_t& diagnosticCount) {
+    double best = 1e100;
+    for (int round = 0; round < rounds; round++) {
+        Parser parser(tokens);
+        vector<Diagnostic> diagnostics;
+        auto start = chrono::steady_clock::now();
+        try {
+            if (recover) {
+                parser.parse(diagnostics);
+            } else {
+                parser.parse();
+            }
+        } catch (const ParseError&) {
+            diagnostics.push_back({});
+        }
+        best = min(best, millisecondsSince(start));
+        diagnosticCount = diagnostics.size();
+    }
+    return best;
+}
+
+// Cost of recovery on valid input, and one recovering pass over input full of errors
+// against the first-error parse a user would otherwise repeat once per error
+void benchRecovery(const string& input) {
+    size_t diagnostics = 0;
+    vector<Token> tokens = Tokenizer(input).tokenize();
+    double throwingMs = bestParseMs(tokens, false, 5, diagnostics);
+    double recoveringMs = bestParseMs(tokens, true, 5, diagnostics);
+    cout << "valid input: parse " << throwingMs << " ms, with recovery " << recoveringMs << " ms ("
+         << diagnostics << " diagnostics)" << endl;
+
+    string broken = injectErrors(input, 20);
+    vector<Token> brokenTokens = Tokenizer(broken).tokenize();
+    double firstErrorMs = bestParseMs(brokenTokens, false, 5, diagnostics);
+    recoveringMs = bestParseMs(brokenTokens, true, 5, diagnostics);
+    cout << "one error per 20 lines: " << diagnostics << " diagnostics in one pass " << recoveringMs
+         << " ms; stopping at the first error " << firstErrorMs << " ms per run" << endl;
+}
+
+// Serial parse against parseParallel() at growing thread counts, tokens already in hand
+void benchParallelParse(const string& input) {
+    vector<Token> tokens = Tokenizer(input).tokenize();
+    auto start = chrono::steady_clock::now();
+    size_t serialStatements = Parser(tokens).parse().children.size();
+    double serialMs = millisecondsSince(start);
+    cout << "parse serial: " << serialMs << " ms (" << serialStatements << " statements, "
+         << thread::hardware_concurrency() << " hardware threads)" << endl;
+
+    for (size_t threads : { 1, 2, 4, 8 }) {
+        start = chrono::steady_clock::now();
+        size_t statements = Parser(tokens).parseParallel(threads).children.size();
+        double ms = millisecondsSince(start);
+        cout << "parseParallel " << threads << " threads: " << ms << " ms, speedup " << serialMs / ms
+             << "x (" << statements << " statements)" << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    string samplePath = argc > 1 ? argv[1] : "../../src/pseudocode/pseudocode.txt";
+    size_t targetMegabytes = argc > 2 ? atoi(argv[2]) : 20;
+
+    string input = scaleInput(readFile(samplePath), targetMegabytes * 1024 * 1024);
+    benchTokenStorage(input);
+    benchParallelParse(input);
+    benchAstAllocation(scaleLines(readFile(samplePath), 100000));
+    benchRecovery(scaleLines(readFile(samplePath), 100000));
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# Ensure the script stops on any error
+set -e
+
+# Define paths for source files and the output executable
+BENCH_PARSER_SRC="bench_parser.cpp"
+OUTPUT_EXEC="parser_bench"
+
+# Step 1: Compile the benchmark with optimizations
+echo "Compiling Parser benchmark..."
+g++ -std=c++17 -O2 -pthread $BENCH_PARSER_SRC -o $OUTPUT_EXEC
+
+# Step 2: Run the benchmark (optional args: sample file, target size in MB)
+echo "Running benchmark..."
+./$OUTPUT_EXEC "$@"
@@ -0,0 +1,96 @@
+#include "../../src/codeGenerator/codeGenerator.cpp"
+#include "../../src/semantic/semantic.cpp"
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+// Read a whole file into a string
+string readFile(const string& path) {
+    ifstream inputFile(path);
+    if (!inputFile) {
+        cerr << "Failed to open " << path << endl;
+        exit(1);
+    }
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    return buffer.str();
+}
+
+// Repeat the sample program until the input has at least the requested number of lines.
+// Each copy goes in its own If block so its declarations do not clash with the others.
+string scaleScoped(const string& sample, size_t targetLines) {
+    size_t sampleLines = count(sample.begin(), sample.end(), '\n') + 3;
+    string input = "Declare copy As Integer\n";
+    for (size_t lines = 0; lines < targetLines; lines += sampleLines) {
+        input += "If copy = 0 Then\n";
+        input += sample;
+        input += "\nEnd If\n";
+    }
+    return input;
+}
+
+double microsecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// Best of `rounds` semantic passes over an already parsed program
+double bestAnalyzeUs(const string& input, const Node& ast, int rounds, size_t& errorCount) {
+    double best = 1e100;
+    SemanticAnalyzer analyzer(input);
+    for (int round = 0; round < rounds; round++) {
+        auto start = chrono::steady_clock::now();
+        errorCount = analyzer.analyze(ast).size();
+        best = min(best, microsecondsSince(start));
+    }
+    return best;
+}
+
+// Cost of the pass on a large valid program, next to the parse it follows
+void benchLargeProgram(const string& sample) {
+    string input = scaleScoped(sample, 100000);
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    auto start = chrono::steady_clock::now();
+    Node ast = parser.parse();
+    double parseUs = microsecondsSince(start);
+
+    size_t errors = 0;
+    double analyzeUs = bestAnalyzeUs(input, ast, 5, errors);
+    cout << count(input.begin(), input.end(), '\n') << " lines: parse " << parseUs / 1000 << " ms, semantic check "
+         << analyzeUs / 1000 << " ms (" << errors << " errors)" << endl;
+}
+
+// Rejecting a broken program in the translator against finding out from the C++ compiler
+void benchRejection(const string& sample, const string& scratchDirectory) {
+    string input = sample + "\nAssign concatResult = x + 1\nPrint undeclaredName\n";
+    auto start = chrono::steady_clock::now();
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    SemanticAnalyzer analyzer(input);
+    size_t errors = analyzer.analyze(ast).size();
+    double rejectUs = microsecondsSince(start);
+    cout << "reject broken sample: parse + check " << rejectUs << " us (" << errors << " errors)" << endl;
+
+    // Without the pass the program is translated and handed to g++
+    CodeGenerator generator;
+    string cppPath = scratchDirectory + "/bench_semantic_broken.cpp";
+    ofstream(cppPath) << generator.generateCode(ast);
+    start = chrono::steady_clock::now();
+    int status = system(("g++ -std=c++17 -fsyntax-only " + cppPath + " 2> /dev/null").c_str());
+    double compileUs = microsecondsSince(start);
+    remove(cppPath.c_str());
+    cout << "same program through g++ -fsyntax-only: " << compileUs / 1000 << " ms (exit status " << status
+         << "), " << compileUs / rejectUs << "x slower" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string samplePath = argc > 1 ? argv[1] : "../../src/pseudocode/pseudocode.txt";
+    string scratchDirectory = argc > 2 ? argv[2] : "/tmp";
+
+    string sample = readFile(samplePath);
+    benchLargeProgram(sample);
+    benchRejection(sample, scratchDirectory);
+
+    return 0;
+}
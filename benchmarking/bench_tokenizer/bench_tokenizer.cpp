@@ -0,0 +1,192 @@
+#include "../../src/tokenizer/tokenizer.cpp"
+#include <chrono>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+// Global allocation counter, bumped by the replaced operator new below
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+// Read a whole file into a string
+string readFile(const string& path) {
+    ifstream inputFile(path);
+    if (!inputFile) {
+        cerr << "Failed to open " << path << endl;
+        exit(1);
+    }
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    return buffer.str();
+}
+
+// Repeat the sample program until the input reaches the requested size
+string scaleInput(const string& sample, size_t targetBytes) {
+    string input;
+    input.reserve(targetBytes + sample.size() + 1);
+    while (input.size() < targetBytes) {
+        input += sample;
+        input += '\n';
+    }
+    return input;
+}
+
+// Tokenize the input once and report allocations and throughput
+void benchTokenize(const string& label, const string& input, bool ignoreKeywordCase) {
+    size_t allocationsBefore = allocationCount;
+    auto start = chrono::steady_clock::now();
+
+    Tokenizer tokenizer(input, ignoreKeywordCase);
+    vector<Token> tokens = tokenizer.tokenize();
+
+    auto end = chrono::steady_clock::now();
+    size_t allocations = allocationCount - allocationsBefore;
+    double seconds = chrono::duration<double>(end - start).count();
+    double megabytes = input.size() / (1024.0 * 1024.0);
+
+    cout << label << ": " << megabytes << " MB, " << tokens.size() << " tokens, "
+         << allocations << " allocations, " << seconds * 1000 << " ms, "
+         << megabytes / seconds << " MB/s" << endl;
+}
+
+// Pull every token through nextToken() without keeping them
+void benchStream(const string& input) {
+    size_t allocationsBefore = allocationCount;
+    auto start = chrono::steady_clock::now();
+
+    Tokenizer tokenizer(input);
+    size_t tokenCount = 0;
+    while (tokenizer.nextToken().type != TokenType::END_OF_FILE) {
+        tokenCount++;
+    }
+
+    auto end = chrono::steady_clock::now();
+    size_t allocations = allocationCount - allocationsBefore;
+    double seconds = chrono::duration<double>(end - start).count();
+    double megabytes = input.size() / (1024.0 * 1024.0);
+
+    cout << "nextToken stream: " << megabytes << " MB, " << tokenCount + 1 << " tokens, "
+         << allocations << " allocations, " << seconds * 1000 << " ms, "
+         << megabytes / seconds << " MB/s" << endl;
+
+    const IdentifierTable& identifiers = tokenizer.identifierTable();
+    cout << "identifiers: " << identifiers.distinctCount() << " distinct of "
+         << identifiers.totalCount() << " total" << endl;
+}
+
+// Build deeply indented nested For/If blocks, mostly whitespace like our generated inputs
+string nestedInput(size_t targetBytes, int depth) {
+    string block;
+    for (int level = 0; level < depth; level++) {
+        string pad(4 * level, ' ');
+        block += pad + "For i" + to_string(level) + "=0 To 10 Do\n";
+        block += pad + "    If i" + to_string(level) + " > 5 Then\n";
+        block += pad + "        Print \"nested level " + to_string(level) + " reached\"\n";
+        block += pad + "    End If\n";
+    }
+    for (int level = depth - 1; level >= 0; level--) {
+        block += string(4 * level, ' ') + "End For\n";
+    }
+    return scaleInput(block, targetBytes);
+}
+
+// Time one scanner over the whole buffer, restarting after every stop character
+double timeScanner(size_t (*scan)(const char*, size_t, size_t), const string& input) {
+    auto start = chrono::steady_clock::now();
+    size_t stops = 0;
+    for (size_t pos = 0; pos < input.size(); pos++) {
+        pos = scan(input.data(), input.size(), pos);
+        stops++;
+    }
+    auto end = chrono::steady_clock::now();
+    if (stops == 0) {
+        cerr << "no stops" << endl;
+    }
+    return chrono::duration<double>(end - start).count() * 1000;
+}
+
+// Compare the scalar and SIMD scanners, both in isolation and inside tokenize()
+void benchScanPaths(const string& input) {
+    ScanFunctions simdScan = selectScanFunctions();
+    cout << "skipWhitespace: scalar " << timeScanner(scalarScan.skipWhitespace, input)
+         << " ms, simd " << timeScanner(simdScan.skipWhitespace, input) << " ms" << endl;
+    cout << "findIdentifierEnd: scalar " << timeScanner(scalarScan.findIdentifierEnd, input)
+         << " ms, simd " << timeScanner(simdScan.findIdentifierEnd, input) << " ms" << endl;
+    cout << "findQuote: scalar " << timeScanner(scalarScan.findQuote, input)
+         << " ms, simd " << timeScanner(simdScan.findQuote, input) << " ms" << endl;
+
+    activeScan = scalarScan;
+    benchTokenize("tokenize nested (scalar scan)", input, false);
+    activeScan = simdScan;
+    benchTokenize("tokenize nested (simd scan)", input, false);
+}
+
+// Cost of turning token offsets into line/column, paid only when locations are asked for
+void benchLocations(const string& input) {
+    Tokenizer tokenizer(input);
+    vector<Token> tokens = tokenizer.tokenize();
+
+    auto start = chrono::steady_clock::now();
+    LineTable lines(input);
+    int lastLine = lines.lineOf(input.size());  // first lookup builds the table
+    auto built = chrono::steady_clock::now();
+    long long columnSum = 0;
+    for (const Token& token : tokens) {
+        columnSum += lines.locate(token.offset).column;
+    }
+    auto end = chrono::steady_clock::now();
+
+    cout << "line table: " << lastLine << " lines, build "
+         << chrono::duration<double>(built - start).count() * 1000 << " ms, locate "
+         << tokens.size() << " tokens " << chrono::duration<double>(end - built).count() * 1000
+         << " ms (column sum " << columnSum << ")" << endl;
+}
+
+// Tokenize the same input on 1-16 threads; speedup is bounded by the cores available
+void benchParallel(const string& input) {
+    cout << "hardware threads: " << thread::hardware_concurrency() << endl;
+    double baseline = 0;
+    for (size_t threads : { 1, 2, 4, 8, 16 }) {
+        auto start = chrono::steady_clock::now();
+        Tokenizer tokenizer(input);
+        vector<Token> tokens = tokenizer.tokenizeParallel(threads);
+        auto end = chrono::steady_clock::now();
+        double seconds = chrono::duration<double>(end - start).count();
+        if (threads == 1) {
+            baseline = seconds;
+        }
+        cout << "tokenizeParallel " << threads << " threads: " << tokens.size() << " tokens, "
+             << seconds * 1000 << " ms, speedup " << baseline / seconds << "x" << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    string samplePath = argc > 1 ? argv[1] : "../../src/pseudocode/pseudocode_final.txt";
+    size_t targetMegabytes = argc > 2 ? atoi(argv[2]) : 50;
+
+    string input = scaleInput(readFile(samplePath), targetMegabytes * 1024 * 1024);
+    benchTokenize("tokenize", input, false);
+    benchTokenize("tokenize (ignore keyword case)", input, true);
+    benchStream(input);
+    benchLocations(input);
+    benchParallel(input);
+
+    benchScanPaths(nestedInput(targetMegabytes * 1024 * 1024, 12));
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# Ensure the script stops on any error
+set -e
+
+# Define paths for source files and the output executable
+BENCH_TOKENIZER_SRC="bench_tokenizer.cpp"
+OUTPUT_EXEC="tokenizer_bench"
+
+# Step 1: Compile the benchmark with optimizations
+echo "Compiling Tokenizer benchmark..."
+g++ -std=c++17 -O2 -pthread $BENCH_TOKENIZER_SRC -o $OUTPUT_EXEC
+
+# Step 2: Run the benchmark (optional args: sample file, target size in MB)
+echo "Running benchmark..."
+./$OUTPUT_EXEC "$@"
@@ -19,7 +19,7 @@ fi
 # Step 1: Compile the source and test files with clang-12 and Mull
 clang-12 -fexperimental-new-pass-manager \
          -fpass-plugin=/usr/lib/mull-ir-frontend-12 \
-         -stdlib=libstdc++ \
+         -std=c++17 -stdlib=libstdc++ \
          -g -grecord-command-line \
          $TEST_CODEGENERATOR_SRC -o $OUTPUT_EXEC -lstdc++ -lm
 
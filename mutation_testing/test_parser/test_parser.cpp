@@ -15,7 +15,11 @@ Node parseInput(const string& pseudocode) {
     Tokenizer tokenizer(pseudocode);
     vector<Token> tokens = tokenizer.tokenize();
     Parser parser(tokens);
-    return parser.parse();
+    Node ast = parser.parse();
+    // The nodes live in the parser's arena; keep it alive for the rest of the run
+    static vector<AstArena> arenas;
+    arenas.push_back(parser.takeArena());
+    return ast;
 }
 
 int main() {
@@ -1,3 +1,4 @@
+#include <climits>
 #include <iostream>
 #include "codeGenerator.h"
 #include "../parser/parser.cpp"
@@ -6,26 +7,120 @@ using namespace std;
 
 // CodeGenerator class to generate code from AST
 string CodeGenerator::generateCode(const Node& ast) {
+    return generateProgram(ast);
+}
+
+string CodeGenerator::generateCode(const FlatAst& ast) {
+    return generateProgram(ast.root());
+}
+
+// Streams C++ for the statements the parser hands over, see translate(). Output goes
+// through a small buffer that is passed on to the caller's stream in chunks.
+class CodeGenerator::DirectSink : public StatementSink {
+public:
+    DirectSink(CodeGenerator& generator, ostream& out) : generator(generator), out(out), level(1) {}
+
+    void statement(const Node& node) override {
+        generator.generateNodeCode(node, code, level);
+        flushIfFull();
+    }
+
+    void open(const Node& header) override {
+        switch (header.type) {
+            case NodeType::IF_STATEMENT:
+                generator.generateIfHeader(header, code, level);
+                break;
+            case NodeType::FOR_LOOP:
+                generator.generateForHeader(header, code, level);
+                break;
+            case NodeType::DO_WHILE_LOOP:
+                generator.indent(code, level); code << "do {" << endl;
+                break;
+            default:
+                generator.generateWhileHeader(header, code, level);
+        }
+        level++;
+    }
+
+    void elseBranch(const Node&) override {
+        generator.indent(code, level - 1); code << "}" << endl;
+        generator.indent(code, level - 1); code << "else {" << endl;
+    }
+
+    // Same closing lines as the tree walk: an If without Else gets no blank line
+    void close(const Node& statement, bool hasElse) override {
+        level--;
+        if (statement.type == NodeType::DO_WHILE_LOOP) {
+            generator.generateDoWhileEnd(statement, code, level);
+            flushIfFull();
+            return;
+        }
+        generator.indent(code, level); code << "}" << endl;
+        if (statement.type != NodeType::IF_STATEMENT || hasElse) {
+            code << endl;
+        }
+        flushIfFull();
+    }
+
+    stringstream code;  // output not yet passed on to `out`
+
+    void flush() {
+        out << code.str();
+        code.str("");
+    }
+
+private:
+    static constexpr streamoff chunkBytes = 1 << 16;
+
+    void flushIfFull() {
+        if (code.tellp() >= chunkBytes) {
+            flush();
+        }
+    }
+
+    CodeGenerator& generator;
+    ostream& out;
+    int level;
+};
+
+void CodeGenerator::translate(Parser& parser, ostream& out) {
+    DirectSink sink(*this, out);
+    generatePrologue(sink.code);
+    parser.parse(sink);
+    generateEpilogue(sink.code);
+    sink.flush();
+}
+
+template <typename AstNode>
+string CodeGenerator::generateProgram(const AstNode& ast) {
     stringstream code;
+    generatePrologue(code);
+
+    int level = 1;
+    WorkStack<AstNode> work;
+    pushStatements(ast, level, work);
+    generateWork(work, code);
+
+    generateEpilogue(code);
+    return code.str();
+}
+
+void CodeGenerator::generatePrologue(stringstream& code) {
     code<<"#include <bits/stdc++.h>"<<endl;
     code<<"using namespace std;"<<endl;
     code<<endl;
     code<<"int main() {"<<endl;
     code<<endl;
+}
 
-    int level = 1;
-    for(const Node& child : ast.children){
-        generateNodeCode(child, code, level);
-    }
-
+void CodeGenerator::generateEpilogue(stringstream& code) {
     code<<endl;
     code<<"return 0;"<<endl;
     code<<"}"<<endl;
-
-    return code.str();
 }
 
-void CodeGenerator::generateNodeCode(const Node& node, stringstream& code, int level) {
+template <typename AstNode>
+void CodeGenerator::generateNodeCode(const AstNode& node, stringstream& code, int level) {
     switch (node.type) {
         case NodeType::DECLARATION:
             generateDeclaration(node, code, level);
@@ -42,190 +137,351 @@ void CodeGenerator::generateNodeCode(const Node& node, stringstream& code, int l
         case NodeType::PRINT:
             generatePrint(node, code, level);
             break;
-        case NodeType::IF_STATEMENT:
-            generateIfStatement(node, code, level);
+        case NodeType::READ:
+            generateRead(node, code, level);
             break;
+        case NodeType::IF_STATEMENT:
         case NodeType::FOR_LOOP:
-            generateForLoop(node, code, level);
-            break;
         case NodeType::WHILE_LOOP:
-            generateWhileLoop(node, code, level);
-            break;
-        case NodeType::DO_WHILE_LOOP:
-            generateDoWhileLoop(node, code, level);
+        case NodeType::DO_WHILE_LOOP: {
+            WorkStack<AstNode> work;
+            work.push_back({ node, level, nullptr });
+            generateWork(work, code);
             break;
+        }
         case NodeType::IDENTIFIER:
-            generateIdentifier(node, code, level);
+            generateIdentifier(node, code);
+            break;
+        case NodeType::BINARY_EXPRESSION:
+        case NodeType::UNARY_EXPRESSION:
+        case NodeType::INDEX_EXPRESSION:
+        case NodeType::CALL_EXPRESSION:
+            generateOperand(node, code);
             break;
         default:
             throw runtime_error("Unknown node type encountered.");
     }
 }
 
-void CodeGenerator::generateDeclaration(const Node& node, stringstream& code, int level) {
-    string lexType = node.children[1].token.lexeme;
+// Drains the walk stack; compound statements push their closing lines and bodies
+// back onto it, everything else is generated directly.
+template <typename AstNode>
+void CodeGenerator::generateWork(WorkStack<AstNode>& work, stringstream& code) {
+    while(!work.empty()){
+        CodeWork<AstNode> item = move(work.back());
+        work.pop_back();
+        if(item.text){
+            indent(code, item.level); code << item.text;
+            continue;
+        }
+        if(item.doWhileEnd){
+            generateDoWhileEnd(item.node, code, item.level);
+            continue;
+        }
+        switch (item.node.type) {
+            case NodeType::IF_STATEMENT:
+                generateIfStatement(item.node, code, item.level, work);
+                break;
+            case NodeType::FOR_LOOP:
+                generateForLoop(item.node, code, item.level, work);
+                break;
+            case NodeType::WHILE_LOOP:
+                generateWhileLoop(item.node, code, item.level, work);
+                break;
+            case NodeType::DO_WHILE_LOOP:
+                generateDoWhileLoop(item.node, code, item.level, work);
+                break;
+            default:
+                generateNodeCode(item.node, code, item.level);
+        }
+    }
+}
+
+// Pushes a block's statements so that the first one is popped first
+template <typename AstNode>
+void CodeGenerator::pushStatements(const AstNode& block, int level, WorkStack<AstNode>& work) {
+    vector<AstNode> statements;
+    for(const auto& child : block.children){
+        statements.push_back(child);
+    }
+    for(size_t ind = statements.size(); ind > 0; --ind){
+        work.push_back({ statements[ind - 1], level, nullptr });
+    }
+}
+
+template <typename AstNode>
+void CodeGenerator::generateDeclaration(const AstNode& node, stringstream& code, int level) {
+    string_view lexType = node.children[1].token.lexeme;
     indent(code, level); 
     if(lexType == "Integer"){
         code << "int ";
-        generateIdentifier(node.children[0], code, level+1);
+        generateIdentifier(node.children[0], code);
         code << ";" << endl;
     }
     else if(lexType == "String"){
         code << "string ";
-        generateIdentifier(node.children[0], code, level+1);
+        generateIdentifier(node.children[0], code);
+        code << ";" << endl;
+    }
+    else if(lexType == "Boolean"){
+        code << "bool ";
+        generateIdentifier(node.children[0], code);
         code << ";" << endl;
     }
     else if(lexType == "Array"){
-        string dataType = node.children[2].token.lexeme;
+        string_view dataType = node.children[2].token.lexeme;
         if(dataType == "Integer"){
             code << "int ";
-            generateIdentifier(node.children[0], code, level+1);
+            generateIdentifier(node.children[0], code);
             code << "[";
-            generateIdentifier(node.children[3], code, level+1);
+            generateIdentifier(node.children[3], code);
             code << "]";
             if(node.children.size() > 4){
                 // 2D array
                 code << "[";
-                generateIdentifier(node.children[4], code, level+1);
+                generateIdentifier(node.children[4], code);
                 code << "]";
             }
             code << ";" << endl;
         }
     }
+    else if(node.children[1].token.type == TokenType::KEYWORD){
+        // A C++ type only the optimizer declares, such as int* to step through an array
+        code << lexType << " ";
+        generateIdentifier(node.children[0], code);
+        code << ";" << endl;
+    }
 }
 
-void CodeGenerator::generateFunctionDeclaration(const Node& node, stringstream& code, int level) {
+template <typename AstNode>
+void CodeGenerator::generateFunctionDeclaration(const AstNode& node, stringstream& code, int level) {
     code << "void " << node.children[0].token.lexeme << "() {" << endl;
     // Generate function body (not implemented in this example)
     code << "    // Function body" << endl;
     code << "}" << endl;
 }
 
-void CodeGenerator::generateAssignment(const Node& node, stringstream& code, int level) {
+template <typename AstNode>
+void CodeGenerator::generateAssignment(const AstNode& node, stringstream& code, int level) {
     indent(code, level); 
     int opertInd = 1;
     if(node.children[1].token.type == TokenType::OPERATOR){
         // single variable
-        generateIdentifier(node.children[0], code, level+1);
+        generateIdentifier(node.children[0], code);
         opertInd = 1;
     }
     else if(node.children[2].token.type == TokenType::OPERATOR){
         // array variable : arr[i]
-        generateIdentifier(node.children[0], code, level+1);
-        code<<"["; generateIdentifier(node.children[1], code, level+1); code<<"]";
+        generateIdentifier(node.children[0], code);
+        code<<"["; generateIdentifier(node.children[1], code); code<<"]";
         opertInd = 2;
     }
     else if(node.children[3].token.type == TokenType::OPERATOR){
         // matrix variable : mat[i][j]
-        generateIdentifier(node.children[0], code, level+1);
-        code<<"["; generateIdentifier(node.children[1], code, level+1); code<<"]";
-        code<<"["; generateIdentifier(node.children[2], code, level+1); code<<"]";
+        generateIdentifier(node.children[0], code);
+        code<<"["; generateIdentifier(node.children[1], code); code<<"]";
+        code<<"["; generateIdentifier(node.children[2], code); code<<"]";
         opertInd = 3;
     }
      
-    code << " "; generateIdentifier(node.children[opertInd], code, level+1); code << " ";
+    code << " "; generateIdentifier(node.children[opertInd], code); code << " ";
     generateNodeCode(node.children[opertInd+1], code, level+1);
     code << ";" << endl;
 }
 
-void CodeGenerator::generateExpression(const Node& node, stringstream& code, int level) {
-    for(const Node& child : node.children){
-        generateIdentifier(child, code, level+1);
+template <typename AstNode>
+void CodeGenerator::generateExpression(const AstNode& node, stringstream& code, int) {
+    // The EXPRESSION node is a slot around one expression tree
+    for(const auto& child : node.children){
+        generateOperand(child, code);
         code << " ";
     }
 }
 
-void CodeGenerator::generatePrint(const Node& node, stringstream& code, int level) {
+// Binding strength of a binary operator in C++. The pseudocode puts all comparisons on
+// one level; C++ binds == and != looser than < <= > >=, so a = b < c, which parses as
+// (a = b) < c, needs its parentheses back.
+static int cppPrecedence(string_view op) {
+    if (op == "==" || op == "!=") {
+        return 3;
+    }
+    return binaryPrecedence(op);
+}
+
+template <typename AstNode>
+void CodeGenerator::generateOperand(const AstNode& node, stringstream& code) {
+    switch (node.type) {
+        case NodeType::BINARY_EXPRESSION: {
+            // Left-associative: a right operand of equal precedence needs parentheses
+            int precedence = cppPrecedence(node.token.lexeme);
+            generateSubexpression(node.children[0], precedence, code);
+            code << " " << node.token.lexeme << " ";
+            generateSubexpression(node.children[1], precedence + 1, code);
+            break;
+        }
+        case NodeType::UNARY_EXPRESSION:
+            // C++ unary operators bind tighter than any binary one
+            code << node.token.lexeme;
+            generateSubexpression(node.children[0], INT_MAX, code);
+            break;
+        case NodeType::INDEX_EXPRESSION:
+            generateOperand(node.children[0], code);
+            code << "[";
+            generateOperand(node.children[1], code);
+            code << "]";
+            break;
+        case NodeType::CALL_EXPRESSION: {
+            // The callee, then the arguments; walked once, since indexing flat or
+            // cached children steps through every sibling before it
+            size_t ind = 0;
+            for(const auto& child : node.children){
+                if(ind > 0) code << (ind == 1 ? "(" : ", ");
+                generateOperand(child, code);
+                ind++;
+            }
+            if(ind < 2) code << "(";
+            code << ")";
+            break;
+        }
+        default:
+            generateIdentifier(node, code);
+    }
+}
+
+template <typename AstNode>
+void CodeGenerator::generateSubexpression(const AstNode& node, int minPrecedence, stringstream& code) {
+    bool parenthesize = node.type == NodeType::UNARY_EXPRESSION ? minPrecedence == INT_MAX :
+                        node.type == NodeType::BINARY_EXPRESSION && cppPrecedence(node.token.lexeme) < minPrecedence;
+    if(parenthesize) code << "(";
+    generateOperand(node, code);
+    if(parenthesize) code << ")";
+}
+
+template <typename AstNode>
+void CodeGenerator::generatePrint(const AstNode& node, stringstream& code, int level) {
     indent(code, level); code << "cout << ";
-    for(size_t ind = 0; ind < node.children.size(); ++ind){
-        const Node& child = node.children[ind];
+    // Iterate rather than index: flat and cached children are found by walking siblings
+    bool first = true;
+    for(const auto& child : node.children){
+        if(!first) code << " << \" \" << ";
+        first = false;
         // if(child.token.type == TokenType::STRINGVAL){
         //     code << "\"";
         //     generateIdentifier(child, code, level+1);
         //     code << "\"";
         // }
         // else generateIdentifier(child, code, level+1);
-        generateIdentifier(child, code, level+1);
-        if(ind < node.children.size() - 1) code << " << \" \" << ";
+        generateIdentifier(child, code);
+        for(const auto& index : child.children){
+            code << "["; generateIdentifier(index, code); code << "]";
+        }
     }
     code << " << endl;" << endl;
 }
 
-void CodeGenerator::generateIfStatement(const Node& node, stringstream& code, int level) {
+template <typename AstNode>
+void CodeGenerator::generateRead(const AstNode& node, stringstream& code, int level) {
+    indent(code, level); code << "cin";
+    for(const auto& child : node.children){
+        code << " >> ";
+        generateIdentifier(child, code);
+        for(const auto& index : child.children){
+            code << "["; generateIdentifier(index, code); code << "]";
+        }
+    }
+    code << ";" << endl;
+}
+
+// The headers only read the header children, so they also serve translate()
+template <typename AstNode>
+void CodeGenerator::generateIfHeader(const AstNode& node, stringstream& code, int level) {
     indent(code, level); code << "if ( ";
     generateNodeCode(node.children[0], code, level+1);
     code << ") {" << endl;
-    Node ifBlock = node.children[1];
-    for(Node child : ifBlock.children){
-        generateNodeCode(child, code, level+1);
-    }
-    indent(code, level); code << "}" << endl;
-    
-    if(node.children.size() > 2){
-        indent(code, level); code<<"else {"<<endl;
-        Node elseBlock = node.children[2];
-        for(Node child : elseBlock.children){
-            generateNodeCode(child, code, level+1);
-        }
-        indent(code, level); code<<"}"<<endl;
-        code<<endl;
-    }
 }
 
-void CodeGenerator::generateForLoop(const Node& node, stringstream& code, int level) {
-    Node condition = node.children[0];
-    string iterator = condition.children[0].token.lexeme;
+template <typename AstNode>
+void CodeGenerator::generateForHeader(const AstNode& node, stringstream& code, int level) {
+    // children[0] is the start assignment: iterator, "=", start expression
+    const auto& start = node.children[0];
+    string_view iterator = start.children[0].token.lexeme;
 
-    indent(code, level); code << "for (int ";
-    generateNodeCode(node.children[0], code, level+1);
+    indent(code, level); code << "for (int " << iterator << " = ";
+    generateNodeCode(start.children[2], code, level+1);
     code << "; "<<iterator<<" <= ";
     generateNodeCode(node.children[1], code, level+1);
     code << "; ";
     code <<iterator<<"++) {" << std::endl;
-
-    Node forBlock = node.children[2];
-    for(Node child : forBlock.children){
-        generateNodeCode(child, code, level+1);
-    }
-
-    indent(code, level); code << "}" << endl;
-    code<<endl;
 }
 
-void CodeGenerator::generateWhileLoop(const Node& node, stringstream& code, int level) {
+template <typename AstNode>
+void CodeGenerator::generateWhileHeader(const AstNode& node, stringstream& code, int level) {
     indent(code, level); code << "while (";
     generateNodeCode(node.children[0], code, level+1);
     code << ") {" << endl;
-    
-    Node whileBlock = node.children[1];
-    for(Node child : whileBlock.children){
-        generateNodeCode(child, code, level+1);
+}
+
+template <typename AstNode>
+void CodeGenerator::generateIfStatement(const AstNode& node, stringstream& code, int level, WorkStack<AstNode>& work) {
+    generateIfHeader(node, code, level);
+
+    // Pushed in reverse: if block, "}", then the optional else block
+    if(node.children.size() > 2){
+        work.push_back({ node, level, "}\n\n" });
+        pushStatements(node.children[2], level+1, work);
+        work.push_back({ node, level, "else {\n" });
     }
+    work.push_back({ node, level, "}\n" });
+    pushStatements(node.children[1], level+1, work);
+}
 
-    indent(code, level); code << "}" << endl;
-    code<<endl;
+template <typename AstNode>
+void CodeGenerator::generateForLoop(const AstNode& node, stringstream& code, int level, WorkStack<AstNode>& work) {
+    generateForHeader(node, code, level);
+    work.push_back({ node, level, "}\n\n" });
+    pushStatements(node.children[2], level+1, work);
 }
 
-void CodeGenerator::generateDoWhileLoop(const Node& node, stringstream& code, int level) {
-    code << "do {" << endl;
-    // Generate do-while loop body (not implemented in this example)
-    code << "    // Do-while loop body" << endl;
-    code << "} while (";
-    generateNodeCode(node.children[0], code, level);
+template <typename AstNode>
+void CodeGenerator::generateWhileLoop(const AstNode& node, stringstream& code, int level, WorkStack<AstNode>& work) {
+    generateWhileHeader(node, code, level);
+    work.push_back({ node, level, "}\n\n" });
+    pushStatements(node.children[1], level+1, work);
+}
+
+// children[0] is the condition, children[1] the body, as in a While
+template <typename AstNode>
+void CodeGenerator::generateDoWhileLoop(const AstNode& node, stringstream& code, int level, WorkStack<AstNode>& work) {
+    indent(code, level); code << "do {" << endl;
+    work.push_back({ node, level, nullptr, true });
+    pushStatements(node.children[1], level+1, work);
+}
+
+// Only reads the condition, so it also serves translate()
+template <typename AstNode>
+void CodeGenerator::generateDoWhileEnd(const AstNode& node, stringstream& code, int level) {
+    indent(code, level); code << "} while (";
+    generateNodeCode(node.children[0], code, level+1);
     code << ");" << endl;
+    code << endl;
 }
 
-void CodeGenerator::generateIdentifier(const Node& node, stringstream& code, int level) {
+template <typename AstNode>
+void CodeGenerator::generateIdentifier(const AstNode& node, stringstream& code) {
     if(node.token.type == TokenType::STRINGVAL){
         code <<"\""<<node.token.lexeme<<"\"";
     }
+    else if(node.token.lexeme == "True" || node.token.lexeme == "False"){
+        // The pseudocode Booleans, as written or folded by the optimizer
+        code << (node.token.lexeme == "True" ? "true" : "false");
+    }
     else{
         code << node.token.lexeme;
     }
 }
 
 void CodeGenerator::indent(stringstream& code, int level){
-    for(int ind=0; ind<level; ind++){
+    for(int ind=0; ind<min(level, maxIndentLevel); ind++){
         code<<"\t";
     }
 }
@@ -2,25 +2,65 @@
 #define CODEGENERATOR_H
 
 #include <sstream>
+#include <vector>
 #include "../parser/parser.h" // Make sure to include parser.h to access Node and NodeType
 
 // CodeGenerator class to generate code from AST
+// The walkers are templates over the node type, so the same code runs on a Node
+// tree and on a FlatAst (through FlatNodeRef).
 class CodeGenerator {
 public:
     std::string generateCode(const Node& ast);
+    std::string generateCode(const FlatAst& ast);
+
+    // Translate straight from the parser: each statement becomes C++ as soon as it is
+    // parsed and no tree is built. The output matches generateCode(parser.parse()).
+    // Throws ParseError on the first syntax error; `out` may hold partial output then.
+    void translate(Parser& parser, std::ostream& out);
+
+    // Any other tree form with Node's members (type, token, children), such as the
+    // nodes of an AST cache
+    template <typename AstNode> std::string generateProgram(const AstNode& ast);
 
 private:
-    void generateNodeCode(const Node& node, std::stringstream& code, int level);
-    void generateDeclaration(const Node& node, std::stringstream& code, int level);
-    void generateFunctionDeclaration(const Node& node, std::stringstream& code, int level);
-    void generateAssignment(const Node& node, std::stringstream& code, int level);
-    void generateExpression(const Node& node, std::stringstream& code, int level);
-    void generatePrint(const Node& node, std::stringstream& code, int level);
-    void generateIfStatement(const Node& node, std::stringstream& code, int level);
-    void generateForLoop(const Node& node, std::stringstream& code, int level);
-    void generateWhileLoop(const Node& node, std::stringstream& code, int level);
-    void generateDoWhileLoop(const Node& node, std::stringstream& code, int level);
-    void generateIdentifier(const Node& node, std::stringstream& code, int level);
+    // A pending piece of output on the explicit walk stack: a statement to generate,
+    // or, when `text` is set, a closing line such as "}" printed at `level`; with
+    // `doWhileEnd`, the closing "} while (...);" of the Do in `node`. If, For, While
+    // and Do push their bodies here instead of recursing, so nesting depth is not
+    // limited by the call stack.
+    template <typename AstNode>
+    struct CodeWork {
+        AstNode node;
+        int level;
+        const char* text;
+        bool doWhileEnd = false;
+    };
+    template <typename AstNode> using WorkStack = std::vector<CodeWork<AstNode>>;
+
+    class DirectSink;
+
+    void generatePrologue(std::stringstream& code);
+    void generateEpilogue(std::stringstream& code);
+    template <typename AstNode> void generateNodeCode(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateWork(WorkStack<AstNode>& work, std::stringstream& code);
+    template <typename AstNode> void pushStatements(const AstNode& block, int level, WorkStack<AstNode>& work);
+    template <typename AstNode> void generateDeclaration(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateFunctionDeclaration(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateAssignment(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateExpression(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateOperand(const AstNode& node, std::stringstream& code);
+    template <typename AstNode> void generateSubexpression(const AstNode& node, int minPrecedence, std::stringstream& code);
+    template <typename AstNode> void generatePrint(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateRead(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateIfHeader(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateForHeader(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateWhileHeader(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateIfStatement(const AstNode& node, std::stringstream& code, int level, WorkStack<AstNode>& work);
+    template <typename AstNode> void generateForLoop(const AstNode& node, std::stringstream& code, int level, WorkStack<AstNode>& work);
+    template <typename AstNode> void generateWhileLoop(const AstNode& node, std::stringstream& code, int level, WorkStack<AstNode>& work);
+    template <typename AstNode> void generateDoWhileLoop(const AstNode& node, std::stringstream& code, int level, WorkStack<AstNode>& work);
+    template <typename AstNode> void generateDoWhileEnd(const AstNode& node, std::stringstream& code, int level);
+    template <typename AstNode> void generateIdentifier(const AstNode& node, std::stringstream& code);
     void indent(std::stringstream& code, int level);
 };
 
@@ -0,0 +1,34 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run body(0) ... body(count - 1) on up to threadCount worker threads.
+// Workers pull the next index from a shared counter, so uneven work items balance
+// out; the calling thread is one of the workers. Returns once every item is done.
+template <typename Body>
+void parallelFor(size_t count, size_t threadCount, Body body) {
+    threadCount = std::max<size_t>(1, std::min(threadCount, count));
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&]() {
+        for (size_t index = nextIndex++; index < count; index = nextIndex++) {
+            body(index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif // PARALLELFOR_H
@@ -0,0 +1,193 @@
+#include "astCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+static constexpr char astCacheMagic[8] = { 'P', 'S', 'E', 'U', 'D', 'A', 'S', 'T' };
+static constexpr uint32_t byteOrderMark = 0x01020304;
+
+static_assert(sizeof(AstCacheHeader) % alignof(FlatNode) == 0 && sizeof(FlatNode) % alignof(CachedToken) == 0,
+              "cache sections must stay aligned");
+
+// Eight bytes per step through a multiply-xorshift mix; the length is mixed in last,
+// so inputs that differ only in trailing zero bytes still differ
+uint64_t contentHash(string_view data) {
+    constexpr uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t pos = 0;
+    for (; pos + 8 <= data.size(); pos += 8) {
+        uint64_t word;
+        memcpy(&word, data.data() + pos, 8);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data.data() + pos, data.size() - pos);
+    hash = (hash ^ tail) * multiplier;
+    hash = (hash ^ data.size()) * multiplier;
+    return hash ^ (hash >> 29);
+}
+
+unique_ptr<AstCache> AstCache::load(const string& path, string_view source, uint32_t passes) {
+    unique_ptr<SourceBuffer> file;
+    try {
+        file = make_unique<SourceBuffer>(path);
+    } catch (const runtime_error&) {
+        return nullptr;
+    }
+    string_view bytes = file->view();
+    if (bytes.size() < sizeof(AstCacheHeader)) {
+        return nullptr;
+    }
+
+    const AstCacheHeader* header = reinterpret_cast<const AstCacheHeader*>(bytes.data());
+    if (memcmp(header->magic, astCacheMagic, sizeof(astCacheMagic)) != 0 || header->version != formatVersion ||
+        header->byteOrder != byteOrderMark || header->nodeCount == 0) {
+        return nullptr;
+    }
+    uint64_t expectedBytes = sizeof(AstCacheHeader) +
+                             uint64_t(header->nodeCount) * (sizeof(FlatNode) + sizeof(CachedToken)) + header->textBytes;
+    if (bytes.size() != expectedBytes || header->sourceBytes != source.size() || header->passes != passes ||
+        header->contentHash != contentHash(source)) {
+        return nullptr;
+    }
+
+    unique_ptr<AstCache> cache(new AstCache(move(file)));
+    cache->header = header;
+    cache->nodes = reinterpret_cast<const FlatNode*>(bytes.data() + sizeof(AstCacheHeader));
+    cache->tokens = reinterpret_cast<const CachedToken*>(cache->nodes + header->nodeCount);
+    cache->text = reinterpret_cast<const char*>(cache->tokens + header->nodeCount);
+    if (!cache->isWellFormed()) {
+        return nullptr;
+    }
+    return cache;
+}
+
+// Whether walking the cache stays inside the file: every subtree lies within its
+// parent's, and every node's token and lexeme exist. A file cut short and rewritten,
+// a flipped bit or a stale cache whose header happens to match is a miss, not a read
+// past the mapping.
+bool AstCache::isWellFormed() const {
+    uint32_t nodeCount = header->nodeCount;
+    if (nodes[0].subtreeSize != nodeCount) {
+        return false;
+    }
+    vector<uint32_t> ends;  // where each enclosing subtree ends, innermost last
+    ends.push_back(nodeCount);
+    for (uint32_t index = 0; index < nodeCount; index++) {
+        while (ends.back() <= index) {
+            ends.pop_back();
+        }
+        const FlatNode& node = nodes[index];
+        if (node.subtreeSize == 0 || node.subtreeSize > ends.back() - index || node.token >= nodeCount ||
+            static_cast<uint32_t>(node.type) > static_cast<uint32_t>(NodeType::CALL_EXPRESSION)) {
+            return false;
+        }
+        ends.push_back(index + node.subtreeSize);
+
+        const CachedToken& token = tokens[node.token];
+        if (uint64_t(token.textOffset) + token.length > header->textBytes ||
+            token.type > static_cast<uint32_t>(TokenType::END_OF_FILE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AstCache::write(const string& path, const FlatAst& ast, string_view source, uint32_t passes) {
+    // Lexemes are views into the source, except for the few the parser respells;
+    // those go after the source, once each
+    string extraText;
+    unordered_map<string_view, uint32_t> extraOffsets;
+    vector<CachedToken> tokens(ast.size());
+    vector<FlatNode> nodes(ast.size());
+    for (size_t index = 0; index < ast.size(); index++) {
+        const Token& token = ast.token(index);
+        uint32_t textOffset = 0;
+        if (token.lexeme.empty()) {
+            // Expression slots and the end of input have no text
+        } else if (token.lexeme.data() >= source.data() &&
+                   token.lexeme.data() + token.lexeme.size() <= source.data() + source.size()) {
+            textOffset = static_cast<uint32_t>(token.lexeme.data() - source.data());
+        } else {
+            auto [entry, added] = extraOffsets.emplace(token.lexeme, static_cast<uint32_t>(source.size() + extraText.size()));
+            if (added) {
+                extraText += token.lexeme;
+            }
+            textOffset = entry->second;
+        }
+        tokens[index] = { textOffset, static_cast<uint32_t>(token.lexeme.size()), token.offset, token.id,
+                          static_cast<uint32_t>(token.type) };
+        nodes[index] = ast.node(index);
+        nodes[index].token = static_cast<uint32_t>(index);
+    }
+
+    if (source.size() + extraText.size() > UINT32_MAX) {
+        return false;  // text offsets are 32-bit
+    }
+
+    AstCacheHeader header = {};
+    memcpy(header.magic, astCacheMagic, sizeof(astCacheMagic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.contentHash = contentHash(source);
+    header.sourceBytes = source.size();
+    header.nodeCount = static_cast<uint32_t>(ast.size());
+    header.textBytes = source.size() + extraText.size();
+    header.passes = passes;
+
+    string temporaryPath = path + ".tmp";
+    {
+        ofstream file(temporaryPath, ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(FlatNode));
+        file.write(reinterpret_cast<const char*>(tokens.data()), tokens.size() * sizeof(CachedToken));
+        file.write(source.data(), source.size());
+        file.write(extraText.data(), extraText.size());
+        if (!file) {
+            remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+    return rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+CachedNodeRef AstCache::at(size_t index) const {
+    const CachedToken& cached = tokens[nodes[index].token];
+    Token token = { static_cast<TokenType>(cached.type), string_view(text + cached.textOffset, cached.length),
+                    cached.offset, cached.id };
+    return { nodes[index].type, token, CachedChildren(this, static_cast<uint32_t>(index)) };
+}
+
+CachedNodeRef CachedChildren::iterator::operator*() const {
+    return cache->at(index);
+}
+
+CachedChildren::iterator& CachedChildren::iterator::operator++() {
+    index += cache->node(index).subtreeSize;
+    return *this;
+}
+
+CachedChildren::iterator CachedChildren::end() const {
+    return iterator(cache, parent + cache->node(parent).subtreeSize);
+}
+
+size_t CachedChildren::size() const {
+    size_t count = 0;
+    for (iterator child = begin(), last = end(); child != last; ++child) {
+        count++;
+    }
+    return count;
+}
+
+CachedNodeRef CachedChildren::operator[](size_t index) const {
+    iterator child = begin();
+    for (size_t ind = 0; ind < index; ind++) {
+        ++child;
+    }
+    return *child;
+}
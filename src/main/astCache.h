@@ -0,0 +1,113 @@
+#ifndef ASTCACHE_H
+#define ASTCACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "../parser/parser.h"
+#include "sourceBuffer.h"
+
+// Binary AST cache: a parsed program saved next to its input so later runs can skip
+// the tokenizer and parser. The file holds, after a fixed header,
+//   nodes   FlatNode[nodeCount]     the tree in pre-order, as in a FlatAst
+//   tokens  CachedToken[nodeCount]  node i's token; lexemes index into `text`
+//   text    char[textBytes]         the source, then lexemes not found in it ("==")
+// It is read through a memory mapping and used in place: loading checks the header,
+// hashes the input and checks that every subtree and lexeme lies inside the file, so
+// a damaged cache is a miss. Numbers are in the writer's byte
+// order; a cache from another byte order or format version is rejected. The tree is
+// stored as the optimizer left it, so the header records which passes ran.
+
+// 64-bit hash of the input a cache was written for
+uint64_t contentHash(std::string_view data);
+
+struct AstCacheHeader {
+    char magic[8];          // "PSEUDAST"
+    uint32_t version;
+    uint32_t byteOrder;     // 0x01020304 as the writer stored it
+    uint64_t contentHash;   // contentHash() of the source
+    uint64_t sourceBytes;
+    uint32_t nodeCount;
+    uint32_t passes;        // Optimizer passes applied to the tree
+    uint64_t textBytes;
+};
+
+struct CachedToken {
+    uint32_t textOffset;
+    uint32_t length;
+    uint32_t offset;  // byte offset in the source, as in Token
+    uint32_t id;
+    uint32_t type;    // TokenType
+};
+
+class AstCache;
+struct CachedNodeRef;
+
+// Children of a cached node; stepping to the next sibling skips a whole subtree
+class CachedChildren {
+public:
+    class iterator {
+    public:
+        iterator(const AstCache* cache, uint32_t index) : cache(cache), index(index) {}
+        CachedNodeRef operator*() const;
+        iterator& operator++();
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        const AstCache* cache;
+        uint32_t index;
+    };
+
+    CachedChildren(const AstCache* cache, uint32_t parent) : cache(cache), parent(parent) {}
+
+    size_t size() const;
+    bool empty() const { return !(begin() != end()); }
+    CachedNodeRef operator[](size_t index) const;  // walks past `index` siblings
+    iterator begin() const { return iterator(cache, parent + 1); }
+    iterator end() const;
+
+private:
+    const AstCache* cache;
+    uint32_t parent;
+};
+
+// One cached node with the same members as Node, so the code generator can walk it.
+// The token is rebuilt on access; its lexeme points into the mapped file.
+struct CachedNodeRef {
+    NodeType type;
+    Token token;
+    CachedChildren children;
+};
+
+class AstCache {
+public:
+    static constexpr uint32_t formatVersion = 3;
+
+    // Map the cache at `path` if it exists, is intact and was written for `source` with
+    // the same optimizer `passes`; null otherwise
+    static std::unique_ptr<AstCache> load(const std::string& path, std::string_view source, uint32_t passes = 0);
+
+    // Save `ast`, parsed from `source` and rewritten by the optimizer `passes`, to
+    // `path`. The file is written under a temporary name and renamed, so a reader never
+    // sees half of it. Returns false on I/O errors.
+    static bool write(const std::string& path, const FlatAst& ast, std::string_view source, uint32_t passes = 0);
+
+    size_t size() const { return header->nodeCount; }
+    const FlatNode& node(size_t index) const { return nodes[index]; }
+    CachedNodeRef at(size_t index) const;
+    CachedNodeRef root() const { return at(0); }
+
+private:
+    explicit AstCache(std::unique_ptr<SourceBuffer> file) : file(std::move(file)) {}
+
+    bool isWellFormed() const;
+
+    std::unique_ptr<SourceBuffer> file;
+    const AstCacheHeader* header = nullptr;
+    const FlatNode* nodes = nullptr;
+    const CachedToken* tokens = nullptr;
+    const char* text = nullptr;
+};
+
+#endif // ASTCACHE_H
@@ -3,59 +3,41 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <memory>
 
 #include "../codeGenerator/codeGenerator.cpp"
+#include "../semantic/semantic.cpp"
+#include "../optimizer/optimizer.cpp"
+#include "sourceBuffer.cpp"
+#include "astCache.cpp"
 
 using namespace std;
 
-int main() {
-    
-    // Read the pseudocode from the file
-    ifstream inputFile("../pseudocode/pseudocode.txt");
-    // ifstream inputFile("../uploads/pseudocode.txt");
-    
-    if (!inputFile) {
-        cerr << "Failed to open pseudocode.txt" << endl;
+// --direct: translate in one pass without printing tokens or building the AST. The
+// semantic checks and the optimizer need the whole tree, so this mode skips them.
+int translateDirect(string_view pseudocode) {
+    ofstream outputFile("../uploads/generatedCode.cpp");
+    if (!outputFile) {
+        cerr << "Failed to open code.cpp for writing" << endl;
         return 1;
     }
 
-    stringstream buffer;
-    buffer << inputFile.rdbuf();
-    string pseudocode = buffer.str();
-
-    // Create tokenizer instance
     Tokenizer tokenizer(pseudocode);
-
-    // Tokenize the input
-    vector<Token> tokens = tokenizer.tokenize();
-
-    // Print the tokens for verification
-    cout<<"---------------------------  TOKENS GENERATION --------------------------------------"<<endl;
-    cout<<endl;
-    for (const auto& token : tokens) {
-        cout << "Token: " << token.lexeme << "\tType: " << static_cast<int>(token.type) << endl;
-    }
-    cout<<endl;
-
-
-    // Create parser instance
-    Parser parser(tokens);
-
-    // Parse the tokens to create an AST
-    Node ast = parser.parse();
-
-    cout<<"---------------------------  ABSTRACT SYNTAX TREE (AST) GENERATION --------------------------------------"<<endl;
-    cout<<endl;
-    printAST(ast);
-    cout<<endl;
-
-    // Create CodeGenerator instance
+    Parser parser(tokenizer);
     CodeGenerator generator;
+    try {
+        generator.translate(parser, outputFile);
+    } catch (const ParseError& error) {
+        cerr << "Syntax error: " << error.what() << endl;
+        return 1;
+    }
 
-    // Generate code from AST
-    string generatedCode = generator.generateCode(ast);
+    cout << "PSEUDOCODE IS CONVERTED TO C++ SUCCESSFULLY!" << endl;
+    return 0;
+}
 
-    // Print generated code
+// Print the generated code and write it out for the web app
+int writeGeneratedCode(const string& generatedCode) {
     cout<<"---------------------------  CODE GENERATION --------------------------------------"<<endl;
     cout<<endl;
     cout << generatedCode << endl;
@@ -73,4 +55,160 @@ int main() {
 
     cout << "PSEUDOCODE IS CONVERTED TO C++ SUCCESSFULLY!" << endl;
     return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Options come before the input path:
+    //   --direct   translate in one pass, see translateDirect()
+    //   --no-fold  skip constant folding, to diff the output against the folded one
+    //   --no-dce   keep dead code: unreachable branches, dead stores, unused variables
+    //   --no-hoist leave loop-invariant expressions inside their loops
+    //   --reduce   step induction variables and row pointers instead of multiplying and
+    //              indexing by For loop variables
+    //   --no-cache neither read nor write the .ast cache, for inputs seen only once
+    //   --tokens   list the tokens first, at the cost of lexing the input twice
+    bool direct = false;
+    bool useCache = true;
+    bool printTokens = false;
+    uint32_t passes = Optimizer::defaultPasses;
+    for (; argc > 1 && string(argv[1]).rfind("--", 0) == 0; argc--, argv++) {
+        string option = argv[1];
+        if (option == "--direct") {
+            direct = true;
+        } else if (option == "--no-fold") {
+            passes &= ~Optimizer::FOLD_CONSTANTS;
+        } else if (option == "--no-dce") {
+            passes &= ~Optimizer::ELIMINATE_DEAD_CODE;
+        } else if (option == "--no-hoist") {
+            passes &= ~Optimizer::HOIST_INVARIANTS;
+        } else if (option == "--reduce") {
+            passes |= Optimizer::REDUCE_STRENGTH;
+        } else if (option == "--no-cache") {
+            useCache = false;
+        } else if (option == "--tokens") {
+            printTokens = true;
+        } else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+
+    // Map the pseudocode file (path from the command line, "-" for stdin)
+    string inputPath = argc > 1 ? argv[1] : "../pseudocode/pseudocode.txt";
+    // string inputPath = "../uploads/pseudocode.txt";
+
+    unique_ptr<SourceBuffer> source;
+    try {
+        source = make_unique<SourceBuffer>(inputPath);
+    } catch (const runtime_error& error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+    string_view pseudocode = source->view();
+    if (direct) {
+        return translateDirect(pseudocode);
+    }
+
+    // The optimized AST of the last program that parsed and passed the checks is cached
+    // next to the input; while the input and the optimizer passes are unchanged, the
+    // tokenizer, parser and optimizer are skipped
+    string cachePath = inputPath == "-" || !useCache ? "" : inputPath + ".ast";
+    unique_ptr<AstCache> cache = cachePath.empty() ? nullptr : AstCache::load(cachePath, pseudocode, passes);
+    if (cache) {
+        cout << "AST loaded from " << cachePath << " (" << cache->size() << " nodes), input unchanged" << endl;
+        cout << endl;
+        CodeGenerator generator;
+        return writeGeneratedCode(generator.generateProgram(cache->root()));
+    }
+
+    // Print the tokens for verification when asked, streaming them so no token vector is
+    // built; the parser lexes the input again
+    if (printTokens) {
+        cout<<"---------------------------  TOKENS GENERATION --------------------------------------"<<endl;
+        cout<<endl;
+        Tokenizer printTokenizer(pseudocode);
+        Token token;
+        do {
+            token = printTokenizer.nextToken();
+            cout << "Token: " << token.lexeme << "\tType: " << static_cast<int>(token.type) << endl;
+        } while (token.type != TokenType::END_OF_FILE);
+        cout<<endl;
+    }
+
+    // Create tokenizer instance
+    Tokenizer tokenizer(pseudocode);
+
+    // Create parser instance, pulling tokens from the tokenizer as it goes
+    Parser parser(tokenizer);
+
+    // Parse the tokens to create an AST, collecting every syntax error in one pass
+    vector<Diagnostic> diagnostics;
+    Node ast = parser.parse(diagnostics);
+    if (!diagnostics.empty()) {
+        for (const Diagnostic& diagnostic : diagnostics) {
+            cerr << "Syntax error: " << diagnostic.message << endl;
+        }
+        cerr << diagnostics.size() << " syntax error(s), no code generated" << endl;
+        return 1;
+    }
+
+    // Check declarations, scopes and types before generating any code
+    SemanticAnalyzer analyzer(pseudocode);
+    diagnostics = analyzer.analyze(ast);
+    if (!diagnostics.empty()) {
+        for (const Diagnostic& diagnostic : diagnostics) {
+            cerr << "Semantic error: " << diagnostic.message << endl;
+        }
+        cerr << diagnostics.size() << " semantic error(s), no code generated" << endl;
+        return 1;
+    }
+    const IdentifierTable& identifiers = tokenizer.identifierTable();
+    cout << "Identifiers: " << identifiers.distinctCount() << " distinct of "
+         << identifiers.totalCount() << " total" << endl;
+    cout << endl;
+
+    cout<<"---------------------------  ABSTRACT SYNTAX TREE (AST) GENERATION --------------------------------------"<<endl;
+    cout<<endl;
+    // Line numbers are only worked out here, after tokenizing and parsing are done
+    LineTable lines(pseudocode);
+    printAST(ast, 0, &lines);
+    cout<<endl;
+
+    // Rewrite the tree before generating code from it
+    Optimizer optimizer(passes);
+    optimizer.optimize(ast, tokenizer.identifierTable());
+    if (passes & Optimizer::FOLD_CONSTANTS) {
+        cout << "Constant folding: " << optimizer.stats().foldedExpressions << " expressions folded, "
+             << optimizer.stats().propagatedUses << " variable uses replaced by their value" << endl;
+        cout << endl;
+    }
+    if (passes & Optimizer::ELIMINATE_DEAD_CODE) {
+        cout << "Dead code: " << optimizer.stats().removedBranches << " branches or loops, "
+             << optimizer.stats().deadStores << " stores and " << optimizer.stats().unusedDeclarations
+             << " unused declarations removed" << endl;
+        cout << endl;
+    }
+    if (passes & Optimizer::HOIST_INVARIANTS) {
+        cout << "Loop-invariant code motion: " << optimizer.stats().hoistedExpressions
+             << " expressions hoisted into " << optimizer.stats().temporaries << " temporaries" << endl;
+        cout << endl;
+    }
+    if (passes & Optimizer::REDUCE_STRENGTH) {
+        const OptimizerStats& stats = optimizer.stats();
+        cout << "Strength reduction: " << stats.reducedMultiplications << " multiplications replaced by "
+             << stats.inductionVariables << " induction variables, " << stats.pointerAccesses
+             << " array accesses through " << stats.pointers << " pointers" << endl;
+        cout << endl;
+    }
+    if (!cachePath.empty() && !AstCache::write(cachePath, FlatAst::fromTree(ast), pseudocode, passes)) {
+        cerr << "Could not write the AST cache " << cachePath << endl;
+    }
+
+    // Create CodeGenerator instance
+    CodeGenerator generator;
+
+    // Generate code from AST
+    string generatedCode = generator.generateCode(ast);
+
+    return writeGeneratedCode(generatedCode);
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "sourceBuffer.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifndef _WIN32
+
+SourceBuffer::SourceBuffer(const string& path) : mappedData(nullptr), mappedSize(0) {
+    int fd = path == "-" ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Failed to open " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, info.st_size, MADV_SEQUENTIAL);
+            mappedData = static_cast<const char*>(data);
+            mappedSize = info.st_size;
+        }
+    }
+
+    // Pipes and anything else mmap refuses: read until end of input
+    if (!mappedData) {
+        char chunk[1 << 16];
+        ssize_t bytesRead;
+        while ((bytesRead = read(fd, chunk, sizeof(chunk))) > 0) {
+            contents.append(chunk, bytesRead);
+        }
+        if (bytesRead < 0) {
+            if (fd != STDIN_FILENO) {
+                close(fd);
+            }
+            throw runtime_error("Failed to read " + path);
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mappedData) {
+        munmap(const_cast<char*>(mappedData), mappedSize);
+    }
+}
+
+#else
+
+SourceBuffer::SourceBuffer(const string& path) : mappedData(nullptr), mappedSize(0) {
+    ifstream inputFile(path, ios::binary);
+    if (!inputFile) {
+        throw runtime_error("Failed to open " + path);
+    }
+    stringstream buffer;
+    buffer << inputFile.rdbuf();
+    contents = buffer.str();
+}
+
+SourceBuffer::~SourceBuffer() {}
+
+#endif
+
+string_view SourceBuffer::view() const {
+    return mappedData ? string_view(mappedData, mappedSize) : string_view(contents);
+}
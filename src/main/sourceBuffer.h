@@ -0,0 +1,29 @@
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+
+#include <string>
+#include <string_view>
+
+// Read-only contents of an input file.
+// Regular files are memory-mapped so the tokenizer reads the page cache directly;
+// pipes, terminals and platforms without mmap fall back to reading into memory.
+// Tokens produced from view() point into this buffer, so it must outlive them.
+class SourceBuffer {
+public:
+    // Open `path` ("-" for standard input); throws runtime_error if it can't be read
+    explicit SourceBuffer(const std::string& path);
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    std::string_view view() const;
+    bool isMapped() const { return mappedData != nullptr; }
+
+private:
+    const char* mappedData;
+    size_t mappedSize;
+    std::string contents;  // used when the input could not be mapped
+};
+
+#endif // SOURCEBUFFER_H
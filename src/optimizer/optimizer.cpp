@@ -0,0 +1,1762 @@
+#include "optimizer.h"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+
+using namespace std;
+
+// Calls `visit` on every statement under `block`, nested ones included; `block` may be
+// const or not, and the statements are passed the same way
+template <typename BlockNode, typename Visit>
+static void forEachStatement(BlockNode& block, Visit visit) {
+    vector<BlockNode*> blocks = { &block };
+    while (!blocks.empty()) {
+        BlockNode& current = *blocks.back();
+        blocks.pop_back();
+        for (BlockNode& statement : current.children) {
+            visit(statement);
+            switch (statement.type) {
+                case NodeType::IF_STATEMENT:
+                    for (size_t index = 1; index < statement.children.size(); index++) {
+                        blocks.push_back(&statement.children[index]);
+                    }
+                    break;
+                case NodeType::FOR_LOOP:
+                    blocks.push_back(&statement.children[2]);
+                    break;
+                case NodeType::WHILE_LOOP:
+                case NodeType::DO_WHILE_LOOP:
+                    blocks.push_back(&statement.children[1]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void Optimizer::optimize(Node& program, IdentifierTable& identifierTable) {
+    identifiers = &identifierTable;
+    booleanNamesDeclared = false;
+    forEachStatement(program, [&](const Node& statement) {
+        if (statement.type == NodeType::DECLARATION) {
+            string_view name = statement.children[0].token.lexeme;
+            booleanNamesDeclared = booleanNamesDeclared || name == "True" || name == "False";
+        }
+    });
+    if (enabled & FOLD_CONSTANTS) {
+        foldConstants(program);
+    }
+    if (enabled & ELIMINATE_DEAD_CODE) {
+        eliminateDeadCode(program);
+    }
+    if (enabled & (HOIST_INVARIANTS | REDUCE_STRENGTH)) {
+        transformLoops(program);
+    }
+}
+
+// ----------------------------------------------------------------------------------
+// Constant folding and propagation
+
+void Optimizer::foldConstants(Node& program) {
+    known.clear();
+    saved.clear();
+    blockNames.clear();
+    blockStarts.clear();
+
+    vector<Work> work;
+    for (size_t index = program.children.size(); index > 0; --index) {
+        work.push_back({ Work::STATEMENT, &program.children[index - 1] });
+    }
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        switch (item.kind) {
+            case Work::STATEMENT:
+                foldStatement(*item.node, work);
+                break;
+            case Work::OPEN_BLOCK:
+                blockStarts.push_back(blockNames.size());
+                break;
+            case Work::CLOSE_BLOCK:
+                for (size_t index = blockStarts.back(); index < blockNames.size(); index++) {
+                    known.erase(blockNames[index]);
+                }
+                blockNames.resize(blockStarts.back());
+                blockStarts.pop_back();
+                break;
+            case Work::ELSE_BRANCH:
+                // The else block starts from the values before the If; the then block's
+                // values wait in `saved`
+                swap(known, saved.back());
+                break;
+            case Work::IF_END: {
+                // `known` holds the values after the last block walked, `saved` those after
+                // the then block, or before the If when there is no else block
+                bool hasElse = item.node->children.size() > 2;
+                if (item.taken == (hasElse ? 1 : 0)) {
+                    known = move(saved.back());
+                    saved.pop_back();
+                    break;
+                }
+                if (item.taken == (hasElse ? 0 : 1)) {
+                    saved.pop_back();
+                    break;
+                }
+                // Keep what both ways through the If agree on
+                for (auto entry = known.begin(); entry != known.end();) {
+                    auto other = saved.back().find(entry->first);
+                    entry = other == saved.back().end() || other->second != entry->second ? known.erase(entry) : next(entry);
+                }
+                saved.pop_back();
+                break;
+            }
+            case Work::LOOP_END:
+                // The loop exits at its check, where only the values the body leaves alone are known
+                known = move(saved.back());
+                saved.pop_back();
+                break;
+            case Work::DO_END:
+                foldExpression(item.node->children[0]);
+                break;
+        }
+    }
+}
+
+// Pushes a block's statements between OPEN_BLOCK and CLOSE_BLOCK, first statement on top
+void Optimizer::pushBlock(Node& block, vector<Work>& work) {
+    work.push_back({ Work::CLOSE_BLOCK, &block });
+    for (size_t index = block.children.size(); index > 0; --index) {
+        work.push_back({ Work::STATEMENT, &block.children[index - 1] });
+    }
+    work.push_back({ Work::OPEN_BLOCK, &block });
+}
+
+void Optimizer::foldStatement(Node& node, vector<Work>& work) {
+    switch (node.type) {
+        case NodeType::DECLARATION:
+            declare(node.children[0].token.id);
+            break;
+        case NodeType::ASSIGNMENT:
+            foldAssignment(node);
+            break;
+        case NodeType::PRINT:
+            foldItems(node, false);
+            break;
+        case NodeType::READ:
+            foldItems(node, true);
+            break;
+        case NodeType::IF_STATEMENT: {
+            ConstantValue condition = foldExpression(node.children[0]);
+            saved.push_back(known);
+            // Pushed in reverse: then block, then the optional else block. Both are walked
+            // even when the condition is known, but only the taken one's values carry on.
+            int8_t taken = condition.kind == ConstantValue::BOOLEAN ? static_cast<int8_t>(condition.value) : -1;
+            work.push_back({ Work::IF_END, &node, taken });
+            if (node.children.size() > 2) {
+                pushBlock(node.children[2], work);
+                work.push_back({ Work::ELSE_BRANCH, &node });
+            }
+            pushBlock(node.children[1], work);
+            break;
+        }
+        case NodeType::FOR_LOOP: {
+            // The loop variable lives in a block around the body; the start is evaluated
+            // once, the end before every iteration
+            Node& start = node.children[0];
+            blockStarts.push_back(blockNames.size());
+            declare(start.children[0].token.id);
+            foldExpression(start.children[2]);
+            forgetAssigned(node.children[2]);
+            foldExpression(node.children[1]);
+            saved.push_back(known);
+            work.push_back({ Work::LOOP_END, &node });
+            work.push_back({ Work::CLOSE_BLOCK, &node });
+            pushBlock(node.children[2], work);
+            break;
+        }
+        case NodeType::WHILE_LOOP:
+            forgetAssigned(node.children[1]);
+            foldExpression(node.children[0]);
+            saved.push_back(known);
+            work.push_back({ Work::LOOP_END, &node });
+            pushBlock(node.children[1], work);
+            break;
+        case NodeType::DO_WHILE_LOOP:
+            // The condition sees what the body leaves behind on any iteration
+            forgetAssigned(node.children[1]);
+            work.push_back({ Work::DO_END, &node });
+            pushBlock(node.children[1], work);
+            break;
+        default:
+            break;
+    }
+}
+
+// children: target, its indices, the "=" operator and the value expression
+void Optimizer::foldAssignment(Node& node) {
+    size_t operatorIndex = 1;
+    while (node.children[operatorIndex].token.type != TokenType::OPERATOR) {
+        substitute(node.children[operatorIndex]);
+        operatorIndex++;
+    }
+    ConstantValue value = foldExpression(node.children[operatorIndex + 1]);
+    if (operatorIndex == 1) {
+        uint32_t name = node.children[0].token.id;
+        if (value.kind != ConstantValue::NONE) {
+            known[name] = value;
+        } else {
+            known.erase(name);
+        }
+    }
+}
+
+// Print and Read items are single tokens with their indices as children
+void Optimizer::foldItems(Node& node, bool isRead) {
+    for (Node& item : node.children) {
+        for (Node& index : item.children) {
+            substitute(index);
+        }
+        if (item.token.type != TokenType::IDENTIFIER || !item.children.empty()) {
+            continue;
+        }
+        if (isRead) {
+            known.erase(item.token.id);
+        } else {
+            substitute(item);
+        }
+    }
+}
+
+// A name declared in the current block hides any outer value until the block closes
+void Optimizer::declare(uint32_t name) {
+    known.erase(name);
+    if (!blockStarts.empty()) {
+        blockNames.push_back(name);
+    }
+}
+
+// Forget the variables a loop body may store to: they differ between iterations
+void Optimizer::forgetAssigned(const Node& body) {
+    vector<const Node*> blocks = { &body };
+    while (!blocks.empty() && !known.empty()) {
+        const Node& block = *blocks.back();
+        blocks.pop_back();
+        for (const Node& statement : block.children) {
+            switch (statement.type) {
+                case NodeType::ASSIGNMENT:
+                    known.erase(statement.children[0].token.id);
+                    break;
+                case NodeType::READ:
+                    for (const Node& item : statement.children) {
+                        known.erase(item.token.id);
+                    }
+                    break;
+                case NodeType::IF_STATEMENT:
+                    for (size_t index = 1; index < statement.children.size(); index++) {
+                        blocks.push_back(&statement.children[index]);
+                    }
+                    break;
+                case NodeType::FOR_LOOP:
+                    blocks.push_back(&statement.children[2]);
+                    break;
+                case NodeType::WHILE_LOOP:
+                case NodeType::DO_WHILE_LOOP:
+                    blocks.push_back(&statement.children[1]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// Folds bottom-up with an explicit stack like SemanticAnalyzer::expressionType. A
+// constant operator node is replaced by its literal; a non-constant one keeps its
+// operands, folded as far as they go.
+ConstantValue Optimizer::foldExpression(Node& expression) {
+    Node& root = expression.type == NodeType::EXPRESSION ? expression.children[0] : expression;
+    vector<pair<Node*, bool>> stack = { { &root, false } };
+    vector<ConstantValue> values;  // values of the operands finished so far
+    while (!stack.empty()) {
+        auto [node, visited] = stack.back();
+        stack.pop_back();
+        // A call's callee is a function name, not an operand
+        size_t firstOperand = node->type == NodeType::CALL_EXPRESSION ? 1 : 0;
+        if (!visited && node->children.size() > firstOperand) {
+            stack.push_back({ node, true });
+            for (size_t index = node->children.size(); index > firstOperand; --index) {
+                stack.push_back({ &node->children[index - 1], false });
+            }
+            continue;
+        }
+
+        size_t operandCount = node->children.size() - firstOperand;
+        ConstantValue value;
+        if (node->type == NodeType::IDENTIFIER) {
+            value = literalValue(*node);
+            auto entry = value.kind == ConstantValue::NONE && node->token.type == TokenType::IDENTIFIER
+                             ? known.find(node->token.id) : known.end();
+            if (entry != known.end()) {
+                value = entry->second;
+                uint32_t offset = node->token.offset;
+                *node = value.kind == ConstantValue::INTEGER ? integerLiteral(value.value, offset)
+                                                             : booleanLiteral(value.value, offset);
+                counts.propagatedUses++;
+            }
+        } else {
+            value = evaluate(*node, values.data() + values.size() - operandCount);
+            // -5 already is the literal form of a negative number
+            bool isLiteral = node->type == NodeType::UNARY_EXPRESSION && node->children[0].token.type == TokenType::NUMBER;
+            if (value.kind != ConstantValue::NONE && !isLiteral) {
+                uint32_t offset = node->token.offset;
+                *node = value.kind == ConstantValue::INTEGER ? integerLiteral(value.value, offset)
+                                                             : booleanLiteral(value.value, offset);
+                counts.foldedExpressions++;
+            }
+        }
+        values.resize(values.size() - operandCount);
+        values.push_back(value);
+    }
+    return values.back();
+}
+
+// Value of one operator node given its operands' values, when C++ would compute it
+// without overflow or division by zero
+ConstantValue Optimizer::evaluate(const Node& node, const ConstantValue* operands) const {
+    constexpr ConstantValue unknown = { ConstantValue::NONE, 0 };
+    string_view op = node.token.lexeme;
+    auto integer = [](int64_t value) {
+        // INT_MIN has no literal: the C++ literal 2147483648 is not an int
+        return value > INT_MIN && value <= INT_MAX ? ConstantValue{ ConstantValue::INTEGER, static_cast<int32_t>(value) }
+                                                   : ConstantValue{ ConstantValue::NONE, 0 };
+    };
+    auto boolean = [](bool value) { return ConstantValue{ ConstantValue::BOOLEAN, value }; };
+
+    if (node.type == NodeType::UNARY_EXPRESSION) {
+        const ConstantValue& operand = operands[0];
+        if (op == "-" && operand.kind == ConstantValue::INTEGER) {
+            return integer(-int64_t(operand.value));
+        }
+        if (op == "!" && operand.kind == ConstantValue::BOOLEAN) {
+            return boolean(!operand.value);
+        }
+        return unknown;
+    }
+    if (node.type != NodeType::BINARY_EXPRESSION) {
+        return unknown;
+    }
+
+    const ConstantValue& left = operands[0];
+    const ConstantValue& right = operands[1];
+    if (op == "&&" || op == "||") {
+        // Short-circuit: a deciding left operand settles it, as the right one is
+        // never evaluated in C++ either
+        if (left.kind != ConstantValue::BOOLEAN) {
+            return unknown;
+        }
+        if (bool(left.value) == (op == "||")) {
+            return left;
+        }
+        return right.kind == ConstantValue::BOOLEAN ? right : unknown;
+    }
+    if (left.kind != right.kind || left.kind == ConstantValue::NONE) {
+        return unknown;
+    }
+    if (op == "==") {
+        return boolean(left.value == right.value);
+    }
+    if (op == "!=") {
+        return boolean(left.value != right.value);
+    }
+    if (left.kind != ConstantValue::INTEGER) {
+        return unknown;
+    }
+    int64_t a = left.value, b = right.value;
+    if (op == "+") return integer(a + b);
+    if (op == "-") return integer(a - b);
+    if (op == "*") return integer(a * b);
+    if (op == "/") return b == 0 ? unknown : integer(a / b);  // truncates toward zero, as in C++
+    if (op == "<") return boolean(a < b);
+    if (op == ">") return boolean(a > b);
+    if (op == "<=") return boolean(a <= b);
+    if (op == ">=") return boolean(a >= b);
+    return unknown;
+}
+
+// Replace a single-token operand (a Print item or an index) by the variable's known
+// value; only values that are a single token themselves qualify
+bool Optimizer::substitute(Node& operand) {
+    if (operand.token.type != TokenType::IDENTIFIER || !operand.children.empty()) {
+        return false;
+    }
+    auto entry = known.find(operand.token.id);
+    if (entry == known.end() || (entry->second.kind == ConstantValue::INTEGER && entry->second.value < 0)) {
+        return false;
+    }
+    const ConstantValue& value = entry->second;
+    operand = value.kind == ConstantValue::INTEGER ? integerLiteral(value.value, operand.token.offset)
+                                                   : booleanLiteral(value.value, operand.token.offset);
+    counts.propagatedUses++;
+    return true;
+}
+
+Node Optimizer::integerLiteral(int32_t value, uint32_t offset) {
+    if (value < 0) {
+        Node magnitude = integerLiteral(-value, offset);
+        Node negation(NodeType::UNARY_EXPRESSION, { TokenType::OPERATOR, "-", offset });
+        negation.children = arena.copy(&magnitude, 1);
+        return negation;
+    }
+    string_view text = numberText.try_emplace(value, to_string(value)).first->second;
+    return Node(NodeType::IDENTIFIER, { TokenType::NUMBER, text, offset });
+}
+
+// Folded Booleans are spelled as in the source; the code generator writes them for C++
+Node Optimizer::booleanLiteral(bool value, uint32_t offset) {
+    return nameNode(identifiers->intern(value ? "True" : "False"), offset);
+}
+
+// A number that fits in an int, or a Boolean, True or False, unless a variable takes
+// one of those names
+ConstantValue Optimizer::literalValue(const Node& node) const {
+    string_view text = node.token.lexeme;
+    if (node.token.type == TokenType::NUMBER) {
+        int32_t value = 0;
+        auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+        if (error == errc() && end == text.data() + text.size()) {
+            return { ConstantValue::INTEGER, value };
+        }
+    } else if (node.token.type == TokenType::IDENTIFIER && !booleanNamesDeclared &&
+               (text == "True" || text == "False")) {
+        return { ConstantValue::BOOLEAN, text == "True" };
+    }
+    return { ConstantValue::NONE, 0 };
+}
+
+// Value of an expression that is a single literal, a negative number included
+ConstantValue Optimizer::expressionValue(const Node& expression) const {
+    const Node& root = expression.type == NodeType::EXPRESSION ? expression.children[0] : expression;
+    if (root.type == NodeType::UNARY_EXPRESSION && root.token.lexeme == "-") {
+        ConstantValue magnitude = literalValue(root.children[0]);
+        return magnitude.kind == ConstantValue::INTEGER ? ConstantValue{ ConstantValue::INTEGER, -magnitude.value }
+                                                        : ConstantValue{ ConstantValue::NONE, 0 };
+    }
+    return root.type == NodeType::IDENTIFIER ? literalValue(root) : ConstantValue{ ConstantValue::NONE, 0 };
+}
+
+// ----------------------------------------------------------------------------------
+// Dead code elimination
+
+void Optimizer::NameSet::add(uint32_t name) {
+    if (name / 64 >= words.size()) {
+        words.resize(name / 64 + 1);
+    }
+    words[name / 64] |= uint64_t(1) << (name % 64);
+}
+
+void Optimizer::NameSet::remove(uint32_t name) {
+    if (name / 64 < words.size()) {
+        words[name / 64] &= ~(uint64_t(1) << (name % 64));
+    }
+}
+
+void Optimizer::NameSet::merge(const NameSet& other) {
+    if (other.words.size() > words.size()) {
+        words.resize(other.words.size());
+    }
+    for (size_t index = 0; index < other.words.size(); index++) {
+        words[index] |= other.words[index];
+    }
+}
+
+// Branches that never run go first, so the liveness walk only sees code that does.
+// Removing stores can leave other stores and whole loops dead, so marking and
+// rebuilding repeat until nothing changes.
+void Optimizer::eliminateDeadCode(Node& program) {
+    dead.clear();
+    rebuildBlocks(program);
+    do {
+        dead.clear();
+        markDeadStores(program);
+        markUnusedDeclarations(program);
+    } while (rebuildBlocks(program));
+    dead.clear();
+}
+
+// Walks the program backward keeping the set of names that may be read later. A loop
+// body starts from everything read anywhere in the loop, which covers what the next
+// iteration reads without iterating to a fixed point. Names a block declares are not
+// live at its end; the outer names they hide come back at the declaration.
+void Optimizer::markDeadStores(Node& program) {
+    NameSet live;
+    liveSaved.clear();
+    hidden.clear();
+    hiddenStarts.clear();
+    vector<LiveWork> work;
+    pushLiveBlock(program, work);
+    while (!work.empty()) {
+        LiveWork item = work.back();
+        work.pop_back();
+        switch (item.kind) {
+            case LiveWork::STATEMENT:
+                markLiveStatement(*item.node, live, work);
+                break;
+            case LiveWork::BLOCK_END:
+                hiddenStarts.push_back(hidden.size());
+                for (const Node& statement : item.node->children) {
+                    if (statement.type == NodeType::DECLARATION) {
+                        uint32_t name = statement.children[0].token.id;
+                        hidden.push_back({ name, live.has(name) });
+                        live.remove(name);
+                    }
+                }
+                break;
+            case LiveWork::BLOCK_START:
+                hidden.resize(hiddenStarts.back());
+                hiddenStarts.pop_back();
+                break;
+            case LiveWork::IF_ELSE:
+                // The else block also starts from the names live after the If; the then
+                // block's result waits in `liveSaved`
+                swap(live, liveSaved.back());
+                break;
+            case LiveWork::IF_START:
+                live.merge(liveSaved.back());
+                liveSaved.pop_back();
+                addUses(item.node->children[0], live);
+                break;
+            case LiveWork::LOOP_START:
+                live = move(liveSaved.back());
+                liveSaved.pop_back();
+                break;
+            case LiveWork::FOR_START: {
+                live = move(liveSaved.back());
+                liveSaved.pop_back();
+                const Node& start = item.node->children[0];
+                uint32_t name = start.children[0].token.id;
+                if (item.outerLive) {
+                    live.add(name);
+                } else {
+                    live.remove(name);
+                }
+                addUses(start.children[2], live);
+                break;
+            }
+        }
+    }
+}
+
+// Pushes a block so that its statements are popped last to first
+void Optimizer::pushLiveBlock(Node& block, vector<LiveWork>& work) {
+    work.push_back({ LiveWork::BLOCK_START, &block });
+    for (Node& statement : block.children) {
+        work.push_back({ LiveWork::STATEMENT, &statement });
+    }
+    work.push_back({ LiveWork::BLOCK_END, &block });
+}
+
+void Optimizer::markLiveStatement(Node& node, NameSet& live, vector<LiveWork>& work) {
+    switch (node.type) {
+        case NodeType::DECLARATION: {
+            // Before the declaration the name means the outer variable again
+            uint32_t name = node.children[0].token.id;
+            for (size_t index = hiddenStarts.back(); index < hidden.size(); index++) {
+                if (hidden[index].first != name) {
+                    continue;
+                }
+                if (hidden[index].second) {
+                    live.add(name);
+                } else {
+                    live.remove(name);
+                }
+            }
+            break;
+        }
+        case NodeType::ASSIGNMENT: {
+            size_t operatorIndex = 1;
+            while (node.children[operatorIndex].token.type != TokenType::OPERATOR) {
+                addUses(node.children[operatorIndex], live);
+                operatorIndex++;
+            }
+            const Node& value = node.children[operatorIndex + 1];
+            if (operatorIndex == 1) {
+                uint32_t name = node.children[0].token.id;
+                if (!live.has(name) && isPure(value)) {
+                    dead.insert(&node);
+                    counts.deadStores++;
+                    break;
+                }
+                live.remove(name);
+            }
+            addUses(value, live);
+            break;
+        }
+        case NodeType::PRINT:
+            addUses(node, live);
+            break;
+        case NodeType::READ:
+            for (const Node& item : node.children) {
+                if (item.children.empty()) {
+                    live.remove(item.token.id);
+                }
+                addUses(item, live);
+            }
+            break;
+        case NodeType::IF_STATEMENT:
+            liveSaved.push_back(live);
+            work.push_back({ LiveWork::IF_START, &node });
+            if (node.children.size() > 2) {
+                pushLiveBlock(node.children[2], work);
+                work.push_back({ LiveWork::IF_ELSE, &node });
+            }
+            pushLiveBlock(node.children[1], work);
+            break;
+        case NodeType::FOR_LOOP: {
+            // The loop variable is read by the loop itself, and hides any outer variable
+            // of its name until the loop ends
+            uint32_t name = node.children[0].children[0].token.id;
+            bool outerLive = live.has(name);
+            addUses(node.children[1], live);
+            addReads(node.children[2], live);
+            live.add(name);
+            liveSaved.push_back(live);
+            work.push_back({ LiveWork::FOR_START, &node, outerLive });
+            pushLiveBlock(node.children[2], work);
+            break;
+        }
+        case NodeType::WHILE_LOOP:
+            addUses(node.children[0], live);
+            addReads(node.children[1], live);
+            liveSaved.push_back(live);
+            work.push_back({ LiveWork::LOOP_START, &node });
+            pushLiveBlock(node.children[1], work);
+            break;
+        case NodeType::DO_WHILE_LOOP:
+            // The body runs at least once, so what it needs is what the loop needs
+            addUses(node.children[0], live);
+            addReads(node.children[1], live);
+            pushLiveBlock(node.children[1], work);
+            break;
+        default:
+            break;
+    }
+}
+
+// Counts the reads of each declared variable, resolving names through the block scopes.
+// Read counts as a use, as do stores whose value calls a function; a variable with no
+// uses loses its declaration and its remaining stores.
+void Optimizer::markUnusedDeclarations(Node& program) {
+    struct Declared {
+        Node* statement;  // null for a For loop variable
+        size_t uses;
+        vector<Node*> stores;
+    };
+    vector<Declared> declared;
+    unordered_map<uint32_t, vector<size_t>> visible;  // each name's declarations, innermost last
+    vector<uint32_t> names;                           // names declared by the open blocks
+    vector<size_t> starts;
+
+    auto declareName = [&](uint32_t name, Node* statement) {
+        visible[name].push_back(declared.size());
+        declared.push_back({ statement, 0, {} });
+        names.push_back(name);
+    };
+    auto countUses = [&](const Node& root) {
+        vector<const Node*> stack = { &root };
+        while (!stack.empty()) {
+            const Node& node = *stack.back();
+            stack.pop_back();
+            auto entry = node.token.type == TokenType::IDENTIFIER ? visible.find(node.token.id) : visible.end();
+            if (entry != visible.end() && !entry->second.empty()) {
+                declared[entry->second.back()].uses++;
+            }
+            for (const Node& child : node.children) {
+                stack.push_back(&child);
+            }
+        }
+    };
+    auto target = [&](uint32_t name) -> Declared* {
+        auto entry = visible.find(name);
+        return entry == visible.end() || entry->second.empty() ? nullptr : &declared[entry->second.back()];
+    };
+
+    vector<Work> work;
+    pushBlock(program, work);
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        Node& node = *item.node;
+        if (item.kind == Work::OPEN_BLOCK) {
+            starts.push_back(names.size());
+            continue;
+        }
+        if (item.kind == Work::CLOSE_BLOCK) {
+            for (size_t index = starts.back(); index < names.size(); index++) {
+                visible[names[index]].pop_back();
+            }
+            names.resize(starts.back());
+            starts.pop_back();
+            continue;
+        }
+        if (dead.count(&node)) {
+            continue;
+        }
+        switch (node.type) {
+            case NodeType::DECLARATION:
+                declareName(node.children[0].token.id, &node);
+                break;
+            case NodeType::ASSIGNMENT: {
+                size_t valueIndex = node.children.size() - 1;
+                for (size_t index = 1; index <= valueIndex; index++) {
+                    countUses(node.children[index]);
+                }
+                if (Declared* variable = target(node.children[0].token.id)) {
+                    if (isPure(node.children[valueIndex])) {
+                        variable->stores.push_back(&node);
+                    } else {
+                        variable->uses++;
+                    }
+                }
+                break;
+            }
+            case NodeType::PRINT:
+                countUses(node);
+                break;
+            case NodeType::READ:
+                // Input is consumed into the variable either way
+                countUses(node);
+                break;
+            case NodeType::IF_STATEMENT:
+                countUses(node.children[0]);
+                if (node.children.size() > 2) {
+                    pushBlock(node.children[2], work);
+                }
+                pushBlock(node.children[1], work);
+                break;
+            case NodeType::FOR_LOOP: {
+                const Node& start = node.children[0];
+                countUses(start.children[2]);
+                countUses(node.children[1]);
+                work.push_back({ Work::CLOSE_BLOCK, &node });
+                pushBlock(node.children[2], work);
+                starts.push_back(names.size());
+                declareName(start.children[0].token.id, nullptr);
+                break;
+            }
+            case NodeType::WHILE_LOOP:
+            case NodeType::DO_WHILE_LOOP:
+                countUses(node.children[0]);
+                pushBlock(node.children[1], work);
+                break;
+            default:
+                break;
+        }
+    }
+
+    for (const Declared& variable : declared) {
+        if (variable.statement && variable.uses == 0) {
+            dead.insert(variable.statement);
+            counts.unusedDeclarations++;
+            for (Node* store : variable.stores) {
+                dead.insert(store);
+                counts.deadStores++;
+            }
+        }
+    }
+}
+
+// Rebuilds every block without its dead statements and with the decided branches in
+// place of their If, innermost blocks first so emptied loops can go too. Returns
+// whether anything changed.
+bool Optimizer::rebuildBlocks(Node& program) {
+    bool changed = false;
+    vector<pair<Node*, bool>> stack = { { &program, false } };
+    while (!stack.empty()) {
+        auto [block, visited] = stack.back();
+        stack.pop_back();
+        if (!visited) {
+            stack.push_back({ block, true });
+            for (Node& statement : block->children) {
+                if (dead.count(&statement)) {
+                    continue;
+                }
+                switch (statement.type) {
+                    case NodeType::IF_STATEMENT:
+                        for (size_t index = 1; index < statement.children.size(); index++) {
+                            stack.push_back({ &statement.children[index], false });
+                        }
+                        break;
+                    case NodeType::FOR_LOOP:
+                        stack.push_back({ &statement.children[2], false });
+                        break;
+                    case NodeType::WHILE_LOOP:
+                    case NodeType::DO_WHILE_LOOP:
+                        stack.push_back({ &statement.children[1], false });
+                        break;
+                    default:
+                        break;
+                }
+            }
+            continue;
+        }
+
+        vector<Node> kept;
+        bool blockChanged = false;
+        for (Node& statement : block->children) {
+            blockChanged = keepStatement(statement, kept) || blockChanged;
+        }
+        if (blockChanged) {
+            block->children = arena.copy(kept.data(), kept.size());
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Appends what remains of `statement` to `kept`: nothing, the statement, or the
+// statements of the block that always runs. Returns whether that differs from the
+// statement as it was.
+bool Optimizer::keepStatement(Node& statement, vector<Node>& kept) {
+    if (dead.count(&statement)) {
+        return true;
+    }
+    auto splice = [&](const Node& block) {
+        for (const Node& inner : block.children) {
+            kept.push_back(inner);
+        }
+    };
+
+    switch (statement.type) {
+        case NodeType::IF_STATEMENT: {
+            ConstantValue condition = expressionValue(statement.children[0]);
+            bool hasElse = statement.children.size() > 2;
+            Node rewritten = statement;
+            // An If on true with no Else is what a decided block that declares names
+            // becomes, and stays
+            bool scope = condition.kind == ConstantValue::BOOLEAN && condition.value && !hasElse &&
+                         declaresNames(statement.children[1]);
+            if (condition.kind == ConstantValue::BOOLEAN && !scope) {
+                counts.removedBranches++;
+                if (!condition.value && !hasElse) {
+                    return true;
+                }
+                const Node& taken = statement.children[condition.value ? 1 : 2];
+                if (!declaresNames(taken)) {
+                    splice(taken);
+                    return true;
+                }
+                // A block that declares names stays a scope of its own
+                if (condition.value) {
+                    rewritten.children = NodeList(&statement.children[0], 2);
+                } else {
+                    Node literal = booleanLiteral(true, statement.children[0].token.offset);
+                    Node children[] = { Node(NodeType::EXPRESSION, statement.children[0].token), taken };
+                    children[0].children = arena.copy(&literal, 1);
+                    rewritten.children = arena.copy(children, 2);
+                }
+                kept.push_back(rewritten);
+                return true;
+            }
+            bool thenEmpty = statement.children[1].children.empty();
+            if (hasElse && statement.children[2].children.empty()) {
+                rewritten.children = NodeList(&statement.children[0], 2);
+                hasElse = false;
+            }
+            if (thenEmpty && !hasElse && isPure(statement.children[0])) {
+                counts.removedBranches++;
+                return true;
+            }
+            kept.push_back(rewritten);
+            return rewritten.children.size() != statement.children.size();
+        }
+        case NodeType::FOR_LOOP: {
+            const Node& start = statement.children[0];
+            ConstantValue first = expressionValue(start.children[2]);
+            ConstantValue last = expressionValue(statement.children[1]);
+            bool neverRuns = first.kind == ConstantValue::INTEGER && last.kind == ConstantValue::INTEGER &&
+                             first.value > last.value;
+            bool empty = statement.children[2].children.empty() && isPure(start.children[2]) &&
+                         isPure(statement.children[1]);
+            if (neverRuns || empty) {
+                counts.removedBranches++;
+                return true;
+            }
+            break;
+        }
+        case NodeType::WHILE_LOOP: {
+            // An empty loop on a literal true never stops, and stays
+            ConstantValue condition = expressionValue(statement.children[0]);
+            bool empty = statement.children[1].children.empty() && isPure(statement.children[0]) &&
+                         condition.kind != ConstantValue::BOOLEAN;
+            if ((condition.kind == ConstantValue::BOOLEAN && !condition.value) || empty) {
+                counts.removedBranches++;
+                return true;
+            }
+            break;
+        }
+        case NodeType::DO_WHILE_LOOP: {
+            ConstantValue condition = expressionValue(statement.children[0]);
+            bool once = condition.kind == ConstantValue::BOOLEAN && !condition.value;
+            bool empty = statement.children[1].children.empty() && isPure(statement.children[0]) &&
+                         !(condition.kind == ConstantValue::BOOLEAN && condition.value);
+            if (empty || (once && !declaresNames(statement.children[1]))) {
+                counts.removedBranches++;
+                splice(statement.children[1]);
+                return true;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    kept.push_back(statement);
+    return false;
+}
+
+// Names read by an expression, a Print or an index
+void Optimizer::addUses(const Node& node, NameSet& live) {
+    vector<const Node*> stack = { &node };
+    while (!stack.empty()) {
+        const Node& current = *stack.back();
+        stack.pop_back();
+        if (current.token.type == TokenType::IDENTIFIER) {
+            live.add(current.token.id);
+        }
+        for (const Node& child : current.children) {
+            stack.push_back(&child);
+        }
+    }
+}
+
+// Names read anywhere under `block`
+void Optimizer::addReads(const Node& block, NameSet& live) {
+    forEachStatement(block, [&](const Node& statement) {
+        switch (statement.type) {
+            case NodeType::ASSIGNMENT:
+                // Skip the target; its indices and the value are read
+                for (size_t index = 1; index < statement.children.size(); index++) {
+                    addUses(statement.children[index], live);
+                }
+                break;
+            case NodeType::PRINT:
+                addUses(statement, live);
+                break;
+            case NodeType::READ:
+                for (const Node& item : statement.children) {
+                    for (const Node& index : item.children) {
+                        addUses(index, live);
+                    }
+                }
+                break;
+            case NodeType::IF_STATEMENT:
+            case NodeType::WHILE_LOOP:
+            case NodeType::DO_WHILE_LOOP:
+                addUses(statement.children[0], live);
+                break;
+            case NodeType::FOR_LOOP:
+                addUses(statement.children[0].children[2], live);
+                addUses(statement.children[1], live);
+                break;
+            default:
+                break;
+        }
+    });
+}
+
+// No function calls and nothing that can fault, so evaluating it or not changes nothing:
+// array reads are left out, as they may be out of bounds, and so is division unless by a
+// nonzero literal. With `mayFault`, only calls count, for an expression that is evaluated
+// anyway.
+bool Optimizer::isPure(const Node& expression, bool mayFault) const {
+    vector<const Node*> stack = { &expression };
+    while (!stack.empty()) {
+        const Node& node = *stack.back();
+        stack.pop_back();
+        if (node.type == NodeType::CALL_EXPRESSION ||
+            (node.type == NodeType::INDEX_EXPRESSION && !mayFault)) {
+            return false;
+        }
+        if (!mayFault && node.type == NodeType::BINARY_EXPRESSION && node.token.lexeme == "/") {
+            ConstantValue divisor = expressionValue(node.children[1]);
+            if (divisor.kind != ConstantValue::INTEGER || divisor.value == 0) {
+                return false;
+            }
+        }
+        for (const Node& child : node.children) {
+            stack.push_back(&child);
+        }
+    }
+    return true;
+}
+
+bool Optimizer::declaresNames(const Node& block) {
+    for (const Node& statement : block.children) {
+        if (statement.type == NodeType::DECLARATION) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------------
+// Loop-invariant code motion and strength reduction
+
+// Walks the program with its scopes, transforming each loop as it is reached, then puts
+// the new statements in place. A loop is done before the loops in its body, so an
+// expression goes out as far as it can.
+void Optimizer::transformLoops(Node& program) {
+    variables.clear();
+    blockNames.clear();
+    blockStarts.clear();
+    hoistedBefore.clear();
+    loopUpdates.clear();
+    loopRanges.clear();
+    vector<Work> work;
+    pushBlock(program, work);
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        Node& node = *item.node;
+        if (item.kind == Work::OPEN_BLOCK) {
+            blockStarts.push_back(blockNames.size());
+            continue;
+        }
+        if (item.kind == Work::CLOSE_BLOCK) {
+            for (size_t index = blockStarts.back(); index < blockNames.size(); index++) {
+                variables[blockNames[index]].pop_back();
+            }
+            blockNames.resize(blockStarts.back());
+            blockStarts.pop_back();
+            if (node.type == NodeType::FOR_LOOP) {
+                loopRanges.pop_back();
+            }
+            continue;
+        }
+        switch (node.type) {
+            case NodeType::DECLARATION: {
+                string_view type = node.children[1].token.lexeme;
+                bool isArray = type == "Array";
+                Variable variable = { (isArray ? node.children[2].token.lexeme : type) == "Integer", 0, { 0, 0 } };
+                for (size_t index = 3; isArray && index < node.children.size(); index++) {
+                    variable.extents[variable.dimensions++] = literalValue(node.children[index]).value;
+                }
+                declareVariable(node.children[0].token.id, variable);
+                break;
+            }
+            case NodeType::IF_STATEMENT:
+                if (node.children.size() > 2) {
+                    pushBlock(node.children[2], work);
+                }
+                pushBlock(node.children[1], work);
+                break;
+            case NodeType::FOR_LOOP: {
+                uint32_t iterator = node.children[0].children[0].token.id;
+                collectWritten(node.children[2]);
+                bool iteratorWritten = written.count(iterator) > 0;
+                written.insert(iterator);
+                if (enabled & HOIST_INVARIANTS) {
+                    hoistFromLoop(node);
+                }
+                // Below, the loop variable runs through the bounds only if the body
+                // leaves it alone
+                LoopRange range = { iterator, { ConstantValue::NONE, 0 }, { ConstantValue::NONE, 0 },
+                                    variables[iterator].size() + 1 };
+                if (!iteratorWritten) {
+                    range.first = expressionValue(node.children[0].children[2]);
+                    range.last = expressionValue(node.children[1]);
+                    if (enabled & REDUCE_STRENGTH) {
+                        reduceStrength(node, range);
+                    }
+                }
+                loopRanges.push_back(range);
+                work.push_back({ Work::CLOSE_BLOCK, &node });
+                pushBlock(node.children[2], work);
+                blockStarts.push_back(blockNames.size());
+                declareVariable(iterator, { true, 0, { 0, 0 } });
+                break;
+            }
+            case NodeType::WHILE_LOOP:
+                if (enabled & HOIST_INVARIANTS) {
+                    collectWritten(node.children[1]);
+                    hoistFromLoop(node);
+                }
+                pushBlock(node.children[1], work);
+                break;
+            case NodeType::DO_WHILE_LOOP:
+                pushBlock(node.children[1], work);
+                break;
+            default:
+                break;
+        }
+    }
+    insertLoopStatements(program);
+}
+
+void Optimizer::declareVariable(uint32_t name, Variable variable) {
+    variables[name].push_back(variable);
+    blockNames.push_back(name);
+}
+
+// Names assigned, read into or declared in `body`. A name declared there counts as
+// written: there it means another variable.
+void Optimizer::collectWritten(const Node& body) {
+    written.clear();
+    declaredInLoop.clear();
+    forEachStatement(body, [&](const Node& statement) {
+        switch (statement.type) {
+            case NodeType::DECLARATION:
+                declaredInLoop.insert(statement.children[0].token.id);
+                written.insert(statement.children[0].token.id);
+                break;
+            case NodeType::ASSIGNMENT:
+                written.insert(statement.children[0].token.id);
+                break;
+            case NodeType::READ:
+                for (const Node& item : statement.children) {
+                    written.insert(item.token.id);
+                }
+                break;
+            case NodeType::FOR_LOOP:
+                written.insert(statement.children[0].children[0].token.id);
+                break;
+            default:
+                break;
+        }
+    });
+}
+
+// Expects `written` to hold what the loop writes, its own variable included. Statements
+// are visited in the order of forEachStatement(), keeping track of whether each runs
+// on every iteration: those directly in the body, and the body of a Do, do; those in an
+// If branch or in a nested For or While body may not.
+void Optimizer::hoistFromLoop(Node& loop) {
+    bool isFor = loop.type == NodeType::FOR_LOOP;
+    Node& body = loop.children[isFor ? 2 : 1];
+    ConstantValue runs = entryValue(loop);
+    if (runs.kind == ConstantValue::BOOLEAN && !runs.value) {
+        return;  // the body never runs, nothing is worth computing for it
+    }
+    loopTemporaries.clear();
+    vector<Node> before;
+    vector<Node> entered;  // assignments to make only once the body is known to run
+    hoistExpression(loop.children[isFor ? 1 : 0], Reach::ALWAYS, before, entered);
+
+    Node condition(NodeType::EXPRESSION, loop.token);
+    Reach everyIteration = entryCondition(loop, condition) ? Reach::EVERY_ITERATION : Reach::CONDITIONAL;
+    vector<pair<Node*, Reach>> blocks = { { &body, everyIteration } };
+    while (!blocks.empty()) {
+        auto [block, reach] = blocks.back();
+        blocks.pop_back();
+        for (Node& statement : block->children) {
+            switch (statement.type) {
+                case NodeType::ASSIGNMENT:
+                    hoistExpression(statement.children.back(), reach, before, entered);
+                    break;
+                case NodeType::IF_STATEMENT:
+                    hoistExpression(statement.children[0], reach, before, entered);
+                    for (size_t index = 1; index < statement.children.size(); index++) {
+                        blocks.push_back({ &statement.children[index], Reach::CONDITIONAL });
+                    }
+                    break;
+                case NodeType::WHILE_LOOP:
+                    hoistExpression(statement.children[0], reach, before, entered);
+                    blocks.push_back({ &statement.children[1], Reach::CONDITIONAL });
+                    break;
+                case NodeType::DO_WHILE_LOOP:
+                    hoistExpression(statement.children[0], reach, before, entered);
+                    blocks.push_back({ &statement.children[1], reach });
+                    break;
+                case NodeType::FOR_LOOP:
+                    hoistExpression(statement.children[0].children[2], reach, before, entered);
+                    hoistExpression(statement.children[1], reach, before, entered);
+                    blocks.push_back({ &statement.children[2], Reach::CONDITIONAL });
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (runs.kind == ConstantValue::BOOLEAN) {
+        before.insert(before.end(), entered.begin(), entered.end());
+    } else if (!entered.empty()) {
+        // If <entry condition> Then <assignments> End If, after the declarations
+        uint32_t offset = loop.token.offset;
+        Node guard(NodeType::IF_STATEMENT, { TokenType::IF, "If", offset });
+        Node block(NodeType::BLOCK, { TokenType::KEYWORD, "Then", offset });
+        block.children = arena.copy(entered.data(), entered.size());
+        Node children[] = { condition, block };
+        guard.children = arena.copy(children, 2);
+        before.push_back(guard);
+    }
+    if (!before.empty()) {
+        hoistedBefore[&loop] = move(before);
+    }
+}
+
+// The condition under which `loop` runs its body at least once, evaluated just before
+// it: start <= end for a For, the condition of a While. False when evaluating it again
+// could have an effect, or for a Do, whose body always runs.
+bool Optimizer::entryCondition(const Node& loop, Node& condition) {
+    if (loop.type == NodeType::WHILE_LOOP) {
+        condition = loop.children[0];
+        return isPure(condition, true);
+    }
+    if (loop.type != NodeType::FOR_LOOP) {
+        return false;
+    }
+    const Node& start = loop.children[0].children[2];
+    const Node& end = loop.children[1];
+    if (!isPure(start, true) || !isPure(end, true)) {
+        return false;
+    }
+    uint32_t offset = loop.token.offset;
+    Node compare(NodeType::BINARY_EXPRESSION, { TokenType::OPERATOR, "<=", offset });
+    Node operands[] = { start.type == NodeType::EXPRESSION ? start.children[0] : start,
+                        end.type == NodeType::EXPRESSION ? end.children[0] : end };
+    compare.children = arena.copy(operands, 2);
+    Token slot{};
+    slot.offset = offset;
+    condition = Node(NodeType::EXPRESSION, slot);
+    condition.children = arena.copy(&compare, 1);
+    return true;
+}
+
+// Whether `loop` runs its body at least once, when its literal bounds or condition tell:
+// a BOOLEAN, or NONE when it depends on the values at run time
+ConstantValue Optimizer::entryValue(const Node& loop) const {
+    if (loop.type == NodeType::WHILE_LOOP) {
+        return expressionValue(loop.children[0]);
+    }
+    if (loop.type != NodeType::FOR_LOOP) {
+        return { ConstantValue::NONE, 0 };
+    }
+    ConstantValue start = expressionValue(loop.children[0].children[2]);
+    ConstantValue end = expressionValue(loop.children[1]);
+    if (start.kind != ConstantValue::INTEGER || end.kind != ConstantValue::INTEGER) {
+        return { ConstantValue::NONE, 0 };
+    }
+    return { ConstantValue::BOOLEAN, start.value <= end.value };
+}
+
+// Replaces the largest invariant parts of `expression` by temporaries. Below the right
+// operand of && or || a part may not be evaluated, as in an If branch. A part that may
+// not be evaluated at all is taken only if it cannot overflow; one evaluated on every
+// iteration gets its temporary assigned in `entered`.
+void Optimizer::hoistExpression(Node& expression, Reach reach, vector<Node>& before, vector<Node>& entered) {
+    vector<pair<Node*, Reach>> stack = { { &expression, reach } };
+    while (!stack.empty()) {
+        auto [node, nodeReach] = stack.back();
+        stack.pop_back();
+        bool worthHoisting = false;
+        if (isInvariant(*node, nodeReach == Reach::ALWAYS, worthHoisting) && worthHoisting &&
+            (nodeReach != Reach::CONDITIONAL || cannotOverflow(*node))) {
+            uint32_t offset = node->token.offset;
+            *node = nameNode(temporaryFor(*node, nodeReach, before, entered), offset);
+            counts.hoistedExpressions++;
+            continue;
+        }
+        bool shortCircuit = node->type == NodeType::BINARY_EXPRESSION &&
+                            (node->token.lexeme == "&&" || node->token.lexeme == "||");
+        // Pushed in reverse, so temporaries are numbered left to right
+        for (size_t index = node->children.size(); index > 0; index--) {
+            stack.push_back({ &node->children[index - 1], shortCircuit && index == 2 ? Reach::CONDITIONAL : nodeReach });
+        }
+    }
+}
+
+// An Integer expression of literals and variables the loop does not write. Worth
+// hoisting once it has an operator or an array read to save.
+bool Optimizer::isInvariant(const Node& expression, bool alwaysEvaluated, bool& worthHoisting) const {
+    auto variable = [&](const Node& name) -> const Variable* {
+        if (name.token.type != TokenType::IDENTIFIER || written.count(name.token.id)) {
+            return nullptr;
+        }
+        auto entry = variables.find(name.token.id);
+        return entry == variables.end() || entry->second.empty() ? nullptr : &entry->second.back();
+    };
+
+    vector<const Node*> stack = { &expression };
+    while (!stack.empty()) {
+        const Node& node = *stack.back();
+        stack.pop_back();
+        switch (node.type) {
+            case NodeType::IDENTIFIER: {
+                if (node.token.type == TokenType::NUMBER) {
+                    break;
+                }
+                const Variable* scalar = variable(node);
+                if (!scalar || !scalar->integer || scalar->dimensions != 0) {
+                    return false;
+                }
+                break;
+            }
+            case NodeType::UNARY_EXPRESSION:
+                if (node.token.lexeme != "-") {
+                    return false;
+                }
+                stack.push_back(&node.children[0]);
+                break;
+            case NodeType::BINARY_EXPRESSION: {
+                string_view op = node.token.lexeme;
+                if (!(op == "+" || op == "-" || op == "*" || (op == "/" && alwaysEvaluated))) {
+                    return false;
+                }
+                worthHoisting = true;
+                stack.push_back(&node.children[0]);
+                stack.push_back(&node.children[1]);
+                break;
+            }
+            case NodeType::INDEX_EXPRESSION: {
+                // A whole element: as many indices as the array has dimensions
+                if (!alwaysEvaluated) {
+                    return false;
+                }
+                const Node* base = &node;
+                size_t indices = 0;
+                while (base->type == NodeType::INDEX_EXPRESSION) {
+                    stack.push_back(&base->children[1]);
+                    base = &base->children[0];
+                    indices++;
+                }
+                const Variable* array = base->type == NodeType::IDENTIFIER ? variable(*base) : nullptr;
+                if (!array || !array->integer || array->dimensions != indices) {
+                    return false;
+                }
+                worthHoisting = true;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// The temporary holding `expression` before the current loop; the same expression
+// twice in one loop shares one. A temporary first needed on every iteration is
+// assigned in `entered`, which only runs when the loop does; a later use elsewhere in
+// the body is covered by that too.
+uint32_t Optimizer::temporaryFor(const Node& expression, Reach reach, vector<Node>& before,
+                                 vector<Node>& entered) {
+    string text;
+    vector<const Node*> stack = { &expression };
+    while (!stack.empty()) {
+        const Node& node = *stack.back();
+        stack.pop_back();
+        text += node.token.lexeme;
+        text += '/';
+        text += to_string(node.children.size());
+        text += ' ';
+        for (size_t index = node.children.size(); index > 0; index--) {
+            stack.push_back(&node.children[index - 1]);
+        }
+    }
+    auto [entry, added] = loopTemporaries.try_emplace(move(text));
+    if (!added) {
+        return entry->second;
+    }
+
+    uint32_t name = temporary("hoisted_" + to_string(counts.temporaries + 1));
+    entry->second = name;
+    declareVariable(name, { true, 0, { 0, 0 } });
+    counts.temporaries++;
+    declareTemporary(name, TokenType::INTEGER, "Integer", expression, before);
+    if (reach == Reach::EVERY_ITERATION) {
+        entered.push_back(before.back());
+        before.pop_back();
+    }
+    return name;
+}
+
+// Whether `expression`, of + - * and unary minus over literals and the variables of
+// enclosing For loops with literal bounds, stays within int for every value those
+// variables take. Anything else is unknown and may overflow.
+bool Optimizer::cannotOverflow(const Node& expression) const {
+    vector<pair<const Node*, bool>> stack = { { &expression, false } };
+    vector<pair<int64_t, int64_t>> ranges;  // lowest and highest value of each finished operand
+    while (!stack.empty()) {
+        auto [node, operandsDone] = stack.back();
+        stack.pop_back();
+        if (node->type == NodeType::IDENTIFIER) {
+            ConstantValue value = literalValue(*node);
+            const LoopRange* range = value.kind == ConstantValue::NONE ? enclosingRange(node->token.id) : nullptr;
+            if (value.kind == ConstantValue::INTEGER) {
+                ranges.push_back({ value.value, value.value });
+            } else if (range) {
+                ranges.push_back({ range->first.value, range->last.value });
+            } else {
+                return false;
+            }
+            continue;
+        }
+        if (node->type != NodeType::UNARY_EXPRESSION && node->type != NodeType::BINARY_EXPRESSION) {
+            return false;
+        }
+        if (!operandsDone) {
+            stack.push_back({ node, true });
+            for (size_t index = node->children.size(); index > 0; index--) {
+                stack.push_back({ &node->children[index - 1], false });
+            }
+            continue;
+        }
+
+        pair<int64_t, int64_t> result;
+        string_view op = node->token.lexeme;
+        if (node->type == NodeType::UNARY_EXPRESSION) {
+            result = { -ranges.back().second, -ranges.back().first };
+            ranges.pop_back();
+        } else {
+            auto [rightLow, rightHigh] = ranges.back();
+            ranges.pop_back();
+            auto [leftLow, leftHigh] = ranges.back();
+            ranges.pop_back();
+            if (op == "+") {
+                result = { leftLow + rightLow, leftHigh + rightHigh };
+            } else if (op == "-") {
+                result = { leftLow - rightHigh, leftHigh - rightLow };
+            } else if (op == "*") {
+                int64_t corners[] = { leftLow * rightLow, leftLow * rightHigh, leftHigh * rightLow, leftHigh * rightHigh };
+                result = { *min_element(begin(corners), end(corners)), *max_element(begin(corners), end(corners)) };
+            } else {
+                return false;
+            }
+        }
+        if (result.first < INT_MIN || result.second > INT_MAX) {
+            return false;
+        }
+        ranges.push_back(result);
+    }
+    return true;
+}
+
+// The literal bounds of the enclosing For loop whose variable `name` refers to, if
+// the body leaves it alone; null when `name` is something else or the bounds are unknown
+const Optimizer::LoopRange* Optimizer::enclosingRange(uint32_t name) const {
+    auto declared = variables.find(name);
+    if (declared == variables.end() || written.count(name)) {
+        return nullptr;
+    }
+    for (size_t index = loopRanges.size(); index > 0; index--) {
+        const LoopRange& range = loopRanges[index - 1];
+        if (range.iterator == name) {
+            // Not hidden by a later declaration of the same name
+            bool current = range.declarations == declared->second.size();
+            return current && range.first.kind == ConstantValue::INTEGER && range.last.kind == ConstantValue::INTEGER &&
+                   range.first.value <= range.last.value ? &range : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+// Declares `name` and assigns it `value`, as statements to put before a loop. Besides
+// Integer, the type can be a C++ type as a KEYWORD token, which the parser never puts
+// in a declaration and the code generator prints as is.
+void Optimizer::declareTemporary(uint32_t name, TokenType typeToken, string_view type, const Node& value,
+                                 vector<Node>& before) {
+    uint32_t offset = value.token.offset;
+    Node declaration(NodeType::DECLARATION, { TokenType::DECLARE, "Declare", offset });
+    Node declared[] = { nameNode(name, offset), Node(NodeType::IDENTIFIER, { typeToken, type, offset }) };
+    declaration.children = arena.copy(declared, 2);
+    before.push_back(declaration);
+    before.push_back(assignment(name, value));
+}
+
+// Assign name = value
+Node Optimizer::assignment(uint32_t name, const Node& value) {
+    uint32_t offset = value.token.offset;
+    Token slot{};
+    slot.offset = offset;
+    Node expression(NodeType::EXPRESSION, slot);
+    expression.children = arena.copy(&value, 1);
+    Node statement(NodeType::ASSIGNMENT, { TokenType::ASSIGN, "Assign", offset });
+    Node children[] = { nameNode(name, offset), Node(NodeType::IDENTIFIER, { TokenType::OPERATOR, "=", offset }),
+                        expression };
+    statement.children = arena.copy(children, 3);
+    return statement;
+}
+
+// A new name for a temporary, interned with the program's identifiers
+uint32_t Optimizer::temporary(string name) {
+    return identifiers->intern(temporaryNames.emplace_back(move(name)));
+}
+
+// An identifier node for the name with id `name`
+Node Optimizer::nameNode(uint32_t name, uint32_t offset) const {
+    return Node(NodeType::IDENTIFIER, { TokenType::IDENTIFIER, identifiers->name(name), offset, name });
+}
+
+// Puts each loop's temporaries just before it, and its induction variable updates at
+// the end of its body
+void Optimizer::insertLoopStatements(Node& program) {
+    if (hoistedBefore.empty()) {
+        return;
+    }
+    vector<Node*> blocks = { &program };
+    while (!blocks.empty()) {
+        Node& block = *blocks.back();
+        blocks.pop_back();
+        vector<Node> rebuilt;
+        bool changed = false;
+        for (const Node& statement : block.children) {
+            auto entry = hoistedBefore.find(&statement);
+            if (entry != hoistedBefore.end()) {
+                rebuilt.insert(rebuilt.end(), entry->second.begin(), entry->second.end());
+                changed = true;
+            }
+            rebuilt.push_back(statement);
+        }
+        auto updates = loopUpdates.find(&block);
+        if (updates != loopUpdates.end()) {
+            rebuilt.insert(rebuilt.end(), updates->second.begin(), updates->second.end());
+            changed = true;
+        }
+        if (changed) {
+            block.children = arena.copy(rebuilt.data(), rebuilt.size());
+        }
+        for (Node& statement : block.children) {
+            switch (statement.type) {
+                case NodeType::IF_STATEMENT:
+                    for (size_t index = 1; index < statement.children.size(); index++) {
+                        blocks.push_back(&statement.children[index]);
+                    }
+                    break;
+                case NodeType::FOR_LOOP:
+                    blocks.push_back(&statement.children[2]);
+                    break;
+                case NodeType::WHILE_LOOP:
+                case NodeType::DO_WHILE_LOOP:
+                    blocks.push_back(&statement.children[1]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// Rewrites a For loop whose variable i only changes by the loop's own step:
+//  - i * c, c an integer literal, becomes a variable set to first * c before the loop
+//    and increased by c at the end of each iteration, where the multiply runs more
+//    than once per iteration: in a nested loop's body, end bound or condition. In the
+//    body itself, g++ multiplies as cheaply as it adds.
+//  - with literal bounds inside the array, grid[r][i], r a literal or the variable of
+//    an enclosing loop that stays inside the rows, goes through a pointer set to the
+//    first element of the row before the loop and moved on by one each iteration.
+//    arr[i] is left alone: g++ -O0 indexes it as cheaply as it steps a pointer.
+void Optimizer::reduceStrength(Node& loop, const LoopRange& range) {
+    Node& body = loop.children[2];
+    InductionLoop induction = { &loop, range, {}, {} };
+    loopTemporaries.clear();
+
+    // Each block with whether it sits in a loop nested in this one
+    vector<pair<Node*, bool>> blocks = { { &body, false } };
+    while (!blocks.empty()) {
+        auto [block, nested] = blocks.back();
+        blocks.pop_back();
+        for (Node& statement : block->children) {
+            switch (statement.type) {
+                case NodeType::ASSIGNMENT: {
+                    reduceExpression(statement.children.back(), nested, induction);
+                    // The target: name, indices, "=", value
+                    size_t indices = statement.children.size() - 3;
+                    if (indices == 2) {
+                        uint32_t pointer = pointerFor(statement.children[0], statement.children[1],
+                                                      statement.children[2], induction);
+                        if (pointer != Token::noId) {
+                            Node children[] = { nameNode(pointer, statement.token.offset),
+                                                Node(NodeType::IDENTIFIER, { TokenType::NUMBER, "0", statement.token.offset }),
+                                                statement.children[indices + 1], statement.children[indices + 2] };
+                            statement.children = arena.copy(children, 4);
+                        }
+                    }
+                    break;
+                }
+                case NodeType::PRINT:
+                case NodeType::READ:
+                    for (Node& item : statement.children) {
+                        if (item.children.size() != 2) {
+                            continue;
+                        }
+                        uint32_t pointer = pointerFor(item, item.children[0], item.children[1], induction);
+                        if (pointer != Token::noId) {
+                            Node zero(NodeType::IDENTIFIER, { TokenType::NUMBER, "0", item.token.offset });
+                            item = nameNode(pointer, item.token.offset);
+                            item.children = arena.copy(&zero, 1);
+                        }
+                    }
+                    break;
+                case NodeType::IF_STATEMENT:
+                    reduceExpression(statement.children[0], nested, induction);
+                    for (size_t index = 1; index < statement.children.size(); index++) {
+                        blocks.push_back({ &statement.children[index], nested });
+                    }
+                    break;
+                case NodeType::WHILE_LOOP:
+                case NodeType::DO_WHILE_LOOP:
+                    reduceExpression(statement.children[0], true, induction);
+                    blocks.push_back({ &statement.children[1], true });
+                    break;
+                case NodeType::FOR_LOOP:
+                    reduceExpression(statement.children[0].children[2], nested, induction);
+                    reduceExpression(statement.children[1], true, induction);
+                    blocks.push_back({ &statement.children[2], true });
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (induction.before.empty()) {
+        return;
+    }
+    vector<Node>& before = hoistedBefore[&loop];
+    before.insert(before.end(), induction.before.begin(), induction.before.end());
+    loopUpdates[&body] = move(induction.updates);
+}
+
+// Replaces array elements indexed by i inside `expression`, and i * c too when
+// `multiplies` is set
+void Optimizer::reduceExpression(Node& expression, bool multiplies, InductionLoop& induction) {
+    vector<Node*> stack = { &expression };
+    while (!stack.empty()) {
+        Node& node = *stack.back();
+        stack.pop_back();
+        if (multiplies && node.type == NodeType::BINARY_EXPRESSION && node.token.lexeme == "*") {
+            uint32_t variable = Token::noId;
+            for (size_t side = 0; side < 2 && variable == Token::noId; side++) {
+                if (isLoopVariable(node.children[side], induction)) {
+                    variable = inductionFor(node.children[1 - side], induction);
+                }
+            }
+            if (variable != Token::noId) {
+                node = nameNode(variable, node.token.offset);
+                counts.reducedMultiplications++;
+                continue;
+            }
+        }
+        if (node.type == NodeType::INDEX_EXPRESSION && node.children[0].type == NodeType::INDEX_EXPRESSION) {
+            const Node& inner = node.children[0];
+            uint32_t pointer = pointerFor(inner.children[0], inner.children[1], node.children[1], induction);
+            if (pointer != Token::noId) {
+                Node children[] = { nameNode(pointer, node.token.offset),
+                                    Node(NodeType::IDENTIFIER, { TokenType::NUMBER, "0", node.token.offset }) };
+                node.children = arena.copy(children, 2);
+                continue;
+            }
+        }
+        for (size_t index = node.children.size(); index > 0; index--) {
+            stack.push_back(&node.children[index - 1]);
+        }
+    }
+}
+
+bool Optimizer::isLoopVariable(const Node& node, const InductionLoop& induction) {
+    return node.type == NodeType::IDENTIFIER && node.token.type == TokenType::IDENTIFIER &&
+           node.token.id == induction.range.iterator;
+}
+
+// The variable equal to i * factor, or Token::noId unless the factor is an integer literal
+// and the literal bounds keep every value the variable takes inside an int. It takes
+// one step past the last iteration, as i does, so (last + 1) * factor must fit too;
+// INT_MIN is left out as it has no literal.
+uint32_t Optimizer::inductionFor(const Node& factor, InductionLoop& induction) {
+    ConstantValue step = literalValue(factor);
+    const LoopRange& range = induction.range;
+    if (step.kind != ConstantValue::INTEGER || range.first.kind != ConstantValue::INTEGER ||
+        range.last.kind != ConstantValue::INTEGER || range.first.value > range.last.value) {
+        return Token::noId;
+    }
+    int64_t first = int64_t(range.first.value) * step.value;
+    int64_t past = (int64_t(range.last.value) + 1) * step.value;
+    if (min(first, past) <= INT_MIN || max(first, past) > INT_MAX) {
+        return Token::noId;
+    }
+    string key = "*";
+    key += factor.token.lexeme;
+    auto [entry, added] = loopTemporaries.try_emplace(key);
+    if (!added) {
+        return entry->second;
+    }
+
+    uint32_t offset = factor.token.offset;
+    Node initial = integerLiteral(static_cast<int32_t>(first), offset);
+    uint32_t name = temporary("induction_" + to_string(++counts.inductionVariables));
+    entry->second = name;
+    declareVariable(name, { true, 0, { 0, 0 } });
+    declareTemporary(name, TokenType::INTEGER, "Integer", initial, induction.before);
+
+    Node next(NodeType::BINARY_EXPRESSION, { TokenType::OPERATOR, "+", offset });
+    Node operands[] = { nameNode(name, offset), factor };
+    next.children = arena.copy(operands, 2);
+    induction.updates.push_back(assignment(name, next));
+    return name;
+}
+
+// The pointer standing for array[row][i]; Token::noId unless every element the loop reaches
+// lies inside the array
+uint32_t Optimizer::pointerFor(const Node& array, const Node& row, const Node& last, InductionLoop& induction) {
+    const LoopRange& range = induction.range;
+    if (range.first.kind != ConstantValue::INTEGER || range.last.kind != ConstantValue::INTEGER ||
+        range.first.value < 0 || range.first.value > range.last.value || !isLoopVariable(last, induction) ||
+        array.type != NodeType::IDENTIFIER || array.token.type != TokenType::IDENTIFIER ||
+        declaredInLoop.count(array.token.id)) {
+        return Token::noId;
+    }
+    auto declared = variables.find(array.token.id);
+    if (declared == variables.end() || declared->second.empty()) {
+        return Token::noId;
+    }
+    const Variable& variable = declared->second.back();
+    if (!variable.integer || variable.dimensions != 2 || range.last.value >= variable.extents[1] ||
+        row.type != NodeType::IDENTIFIER) {
+        return Token::noId;
+    }
+    // A literal row, or the variable of an enclosing loop whose rows all exist
+    ConstantValue lowest = literalValue(row);
+    ConstantValue highest = lowest;
+    const LoopRange* rows = lowest.kind == ConstantValue::NONE && row.token.type == TokenType::IDENTIFIER ?
+                            enclosingRange(row.token.id) : nullptr;
+    if (rows) {
+        lowest = rows->first;
+        highest = rows->last;
+    }
+    if (lowest.kind != ConstantValue::INTEGER || highest.kind != ConstantValue::INTEGER || lowest.value < 0 ||
+        highest.value >= variable.extents[0]) {
+        return Token::noId;
+    }
+
+    string key = "&";
+    key += array.token.lexeme;
+    key += '/';
+    key += row.token.lexeme;
+    auto [entry, added] = loopTemporaries.try_emplace(key);
+    counts.pointerAccesses++;
+    if (!added) {
+        return entry->second;
+    }
+
+    uint32_t offset = array.token.offset;
+    uint32_t name = temporary("pointer_" + to_string(++counts.pointers));
+    entry->second = name;
+    declareVariable(name, { false, 0, { 0, 0 } });
+
+    // A Print or Read item carries its indices as children; the address takes the name alone
+    Node element(NodeType::INDEX_EXPRESSION, { TokenType::PUNCTUATION, "[", offset });
+    Node rowElements(NodeType::INDEX_EXPRESSION, { TokenType::PUNCTUATION, "[", offset });
+    Node rowOperands[] = { Node(NodeType::IDENTIFIER, array.token), row };
+    rowElements.children = arena.copy(rowOperands, 2);
+    Node elementOperands[] = { rowElements, integerLiteral(range.first.value, offset) };
+    element.children = arena.copy(elementOperands, 2);
+    Node address(NodeType::UNARY_EXPRESSION, { TokenType::OPERATOR, "&", offset });
+    address.children = arena.copy(&element, 1);
+    declareTemporary(name, TokenType::KEYWORD, "int*", address, induction.before);
+
+    Node next(NodeType::BINARY_EXPRESSION, { TokenType::OPERATOR, "+", offset });
+    Node operands[] = { nameNode(name, offset), Node(NodeType::IDENTIFIER, { TokenType::NUMBER, "1", offset }) };
+    next.children = arena.copy(operands, 2);
+    induction.updates.push_back(assignment(name, next));
+    return name;
+}
@@ -0,0 +1,244 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../parser/parser.h"
+
+// A value known while compiling: an Integer (C++ int) or a Boolean, or nothing
+struct ConstantValue {
+    enum Kind : uint8_t { NONE, INTEGER, BOOLEAN };
+    Kind kind;
+    int32_t value;  // the Integer, or 0/1 for a Boolean
+
+    bool operator==(const ConstantValue& other) const { return kind == other.kind && value == other.value; }
+    bool operator!=(const ConstantValue& other) const { return !(*this == other); }
+};
+
+struct OptimizerStats {
+    size_t foldedExpressions = 0;  // operators replaced by their result
+    size_t propagatedUses = 0;     // variable reads replaced by a known value
+    size_t removedBranches = 0;    // If, For, While and Do never entered, decided or left empty
+    size_t deadStores = 0;         // assignments overwritten or dropped before any read
+    size_t unusedDeclarations = 0; // variables never read, removed with their stores
+    size_t hoistedExpressions = 0; // loop-invariant expressions replaced by a temporary
+    size_t temporaries = 0;        // temporaries computed before loops
+    size_t reducedMultiplications = 0;  // loop variable times an invariant, now an induction variable
+    size_t inductionVariables = 0;      // variables stepped by addition instead
+    size_t pointerAccesses = 0;         // array elements reached through a pointer the loop steps
+    size_t pointers = 0;
+};
+
+// AST rewrites between the semantic check and code generation. The tree is changed in
+// place; new nodes and lexemes live in the optimizer, so it must outlive the tree.
+// Expects a program that passed SemanticAnalyzer. Variables are told apart by the ids
+// their tokens got from the tokenizer's IdentifierTable, and temporaries are interned
+// there too.
+//
+// FOLD_CONSTANTS evaluates Integer arithmetic, comparisons, Not, And and Or on known
+// operands, and carries the values of scalar variables through straight-line code, into
+// branches and into loop bounds. Results follow C++ int semantics: anything that would
+// overflow, divide by zero or need INT_MIN as a literal is left for run time. String
+// operands are never folded, since two C++ string literals do not concatenate with +.
+//
+// ELIMINATE_DEAD_CODE runs after folding. It replaces an If, While or Do whose
+// condition is a literal by the block that runs, and drops a For whose literal bounds
+// never meet. A backward liveness walk then removes assignments to scalars that are not
+// read before being overwritten or going out of scope. A variable that is never read
+// loses its declaration and its stores, arrays included. Stores whose value calls a
+// function are kept. Loops and Ifs left empty are dropped when their conditions have no
+// side effects, except loops that never stop.
+//
+// HOIST_INVARIANTS runs last. Integer expressions in a For or While whose variables the
+// loop never writes are computed once into a temporary declared just before the loop:
+// the For end bound, parts of the While condition and of the statements in the body,
+// nested loops included, outermost loop first. The temporaries are named hoisted_N,
+// which no pseudocode identifier can be. A hoisted expression must not fault or
+// overflow where the original program would not have run it:
+//  - a division or an array read is hoisted only from the bound or condition, and only
+//    where && and || always reach it;
+//  - + - * and unary minus from a statement that runs on every iteration are computed
+//    under an If on the loop's entry condition, so only when the body runs;
+//  - from an If branch, a nested loop's body or the right of && and ||, only when the
+//    literals and enclosing loop variables with literal bounds they combine cannot
+//    overflow an int.
+//
+// REDUCE_STRENGTH works on For loops whose body leaves the loop variable alone. Inside
+// a nested loop it replaces the loop variable times an integer literal by a variable
+// stepped by addition, when the literal bounds keep it inside an int, and, when they
+// keep every element inside the array, walks the row of grid[r][i] with a pointer
+// stepped by one. Temporaries are named induction_N and pointer_N.
+class Optimizer {
+public:
+    enum Pass : uint32_t {
+        FOLD_CONSTANTS = 1 << 0,
+        ELIMINATE_DEAD_CODE = 1 << 1,
+        HOIST_INVARIANTS = 1 << 2,
+        REDUCE_STRENGTH = 1 << 3,
+    };
+    static constexpr uint32_t allPasses = FOLD_CONSTANTS | ELIMINATE_DEAD_CODE | HOIST_INVARIANTS | REDUCE_STRENGTH;
+    // REDUCE_STRENGTH is opt-in: g++ -O2 runs the grid kernel of bench_optimizer
+    // slower through its pointers
+    static constexpr uint32_t defaultPasses = allPasses & ~REDUCE_STRENGTH;
+
+    explicit Optimizer(uint32_t passes = defaultPasses) : enabled(passes) {}
+
+    // The optimizer owns nodes the tree points to
+    Optimizer(const Optimizer&) = delete;
+    Optimizer& operator=(const Optimizer&) = delete;
+
+    // Rewrite `program`, the root returned by Parser::parse; `identifiers` is the table of
+    // the tokenizer that read it
+    void optimize(Node& program, IdentifierTable& identifiers);
+
+    uint32_t passes() const { return enabled; }
+    const OptimizerStats& stats() const { return counts; }
+
+private:
+    // Pending work of the statement walk. Blocks are bracketed by OPEN_BLOCK and
+    // CLOSE_BLOCK, which forget the names they declared; the other kinds save, switch
+    // and merge the known values around branches and loop bodies.
+    struct Work {
+        enum Kind { STATEMENT, OPEN_BLOCK, CLOSE_BLOCK, ELSE_BRANCH, IF_END, LOOP_END, DO_END };
+        Kind kind;
+        Node* node;
+        int8_t taken = -1;  // IF_END: 1 or 0 when the condition is a known true or false
+    };
+    using Values = std::unordered_map<uint32_t, ConstantValue>;  // by identifier id
+
+    // Pending work of the backward liveness walk: statements are popped last to first,
+    // and a block's BLOCK_END comes before its statements, BLOCK_START after them
+    struct LiveWork {
+        enum Kind { STATEMENT, BLOCK_END, BLOCK_START, IF_ELSE, IF_START, LOOP_START, FOR_START };
+        Kind kind;
+        Node* node;
+        bool outerLive = false;  // FOR_START: whether the name the loop variable hides was live
+    };
+
+    // Bit per identifier id, for liveness
+    class NameSet {
+    public:
+        bool has(uint32_t name) const { return name / 64 < words.size() && (words[name / 64] >> (name % 64) & 1); }
+        void add(uint32_t name);
+        void remove(uint32_t name);
+        void merge(const NameSet& other);
+
+    private:
+        std::vector<uint64_t> words;
+    };
+
+    // What a name refers to, for the types of hoisted expressions
+    struct Variable {
+        bool integer;         // Integer, or an array of Integers
+        uint8_t dimensions;   // 0 for a scalar
+        int32_t extents[2];   // array sizes, outermost first
+    };
+
+    // A For loop variable and its literal bounds, when the body leaves it alone
+    struct LoopRange {
+        uint32_t iterator;
+        ConstantValue first;
+        ConstantValue last;
+        size_t declarations;  // declarations of the name in scope in the body, the iterator last
+    };
+
+    // Where an expression in a loop sits: the bound or condition, evaluated whenever the
+    // loop is reached; a statement the body runs on every iteration; or a place that may
+    // not be reached at all
+    enum class Reach : uint8_t { CONDITIONAL, EVERY_ITERATION, ALWAYS };
+
+    // The For loop being strength-reduced and the statements it gains
+    struct InductionLoop {
+        Node* loop;
+        LoopRange range;
+        std::vector<Node> before;   // declarations and initial values
+        std::vector<Node> updates;  // steps at the end of the body
+    };
+
+    void foldConstants(Node& program);
+    void foldStatement(Node& node, std::vector<Work>& work);
+    void foldAssignment(Node& node);
+    void foldItems(Node& node, bool isRead);
+    void pushBlock(Node& block, std::vector<Work>& work);
+    void declare(uint32_t name);
+    void forgetAssigned(const Node& body);
+    ConstantValue foldExpression(Node& expression);
+    ConstantValue evaluate(const Node& node, const ConstantValue* operands) const;
+    bool substitute(Node& operand);
+
+    void eliminateDeadCode(Node& program);
+    void markDeadStores(Node& program);
+    void markLiveStatement(Node& node, NameSet& live, std::vector<LiveWork>& work);
+    void pushLiveBlock(Node& block, std::vector<LiveWork>& work);
+    void markUnusedDeclarations(Node& program);
+    bool rebuildBlocks(Node& program);
+    bool keepStatement(Node& statement, std::vector<Node>& kept);
+    void addUses(const Node& node, NameSet& live);
+    void addReads(const Node& block, NameSet& live);
+    bool isPure(const Node& expression, bool mayFault = false) const;
+    static bool declaresNames(const Node& block);
+
+    void transformLoops(Node& program);
+    void collectWritten(const Node& body);
+    void hoistFromLoop(Node& loop);
+    void hoistExpression(Node& expression, Reach reach, std::vector<Node>& before, std::vector<Node>& entered);
+    bool isInvariant(const Node& expression, bool alwaysEvaluated, bool& worthHoisting) const;
+    bool cannotOverflow(const Node& expression) const;
+    const LoopRange* enclosingRange(uint32_t name) const;
+    bool entryCondition(const Node& loop, Node& condition);
+    ConstantValue entryValue(const Node& loop) const;
+    uint32_t temporaryFor(const Node& expression, Reach reach, std::vector<Node>& before,
+                          std::vector<Node>& entered);
+    void declareTemporary(uint32_t name, TokenType typeToken, std::string_view type, const Node& value,
+                          std::vector<Node>& before);
+    Node assignment(uint32_t name, const Node& value);
+    uint32_t temporary(std::string name);
+    Node nameNode(uint32_t name, uint32_t offset) const;
+    void insertLoopStatements(Node& program);
+    void declareVariable(uint32_t name, Variable variable);
+
+    void reduceStrength(Node& loop, const LoopRange& range);
+    void reduceExpression(Node& expression, bool multiplies, InductionLoop& induction);
+    uint32_t inductionFor(const Node& factor, InductionLoop& induction);
+    uint32_t pointerFor(const Node& array, const Node& row, const Node& last, InductionLoop& induction);
+    static bool isLoopVariable(const Node& node, const InductionLoop& induction);
+
+    // Literal nodes: a negative Integer becomes unary minus on its magnitude
+    Node integerLiteral(int32_t value, uint32_t offset);
+    Node booleanLiteral(bool value, uint32_t offset);
+    ConstantValue literalValue(const Node& node) const;
+    ConstantValue expressionValue(const Node& expression) const;
+
+    uint32_t enabled;
+    OptimizerStats counts;
+    IdentifierTable* identifiers = nullptr;  // the program's, during optimize()
+    AstArena arena;  // nodes created by the rewrites
+    std::unordered_map<int32_t, std::string> numberText;  // lexemes of folded Integers
+
+    Values known;                       // values of variables at the current point
+    std::vector<Values> saved;          // known values before the branch or loop being walked
+    std::vector<uint32_t> blockNames;   // names declared by the open blocks
+    std::vector<size_t> blockStarts;    // where each open block's names begin
+    bool booleanNamesDeclared = false;  // a variable is named True or False
+
+    std::unordered_set<const Node*> dead;  // statements to remove at the next rebuildBlocks()
+    std::vector<NameSet> liveSaved;        // live names around the branch or loop being walked
+    std::vector<std::pair<uint32_t, bool>> hidden;  // names a block declares, and whether the outer one was live
+    std::vector<size_t> hiddenStarts;      // where each block's entries in `hidden` begin
+
+    std::unordered_map<uint32_t, std::vector<Variable>> variables;  // each name's declarations, innermost last
+    std::unordered_set<uint32_t> written;  // names the loop being transformed assigns or declares
+    std::unordered_set<uint32_t> declaredInLoop;  // names it declares
+    std::unordered_map<std::string, uint32_t> loopTemporaries;  // expression text to temporary, per loop
+    std::unordered_map<const Node*, std::vector<Node>> hoistedBefore;  // statements to insert before each loop
+    std::unordered_map<const Node*, std::vector<Node>> loopUpdates;    // statements to append to each For body, by body
+    std::vector<LoopRange> loopRanges;  // enclosing For loops, innermost last
+    std::deque<std::string> temporaryNames;  // text of the names interned for temporaries
+};
+
+#endif // OPTIMIZER_H
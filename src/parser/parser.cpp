@@ -1,78 +1,653 @@
 #include "parser.h"
 #include "../tokenizer/tokenizer.cpp"
+#include "../common/parallelFor.h"
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 using namespace std;
 
-Parser::Parser(vector<Token> tokens) : tokens(tokens), currentPos(0) {
-    currentToken = tokens[currentPos];
+Parser::Parser(const vector<Token>& tokens, string_view source)
+    : tokenVector(&tokens), stream(tokens), source(source), lines(source) {
+    currentToken = stream.next();
+}
+
+Parser::Parser(vector<Token>&& tokens, string_view source)
+    : tokens(move(tokens)), tokenVector(&this->tokens), stream(this->tokens), source(source), lines(source) {
+    currentToken = stream.next();
+}
+
+Parser::Parser(const vector<Token>& tokens, size_t first, size_t last)
+    : stream(tokens, first, last), lines(source) {
+    currentToken = stream.next();
+}
+
+Parser::Parser(Tokenizer& tokenizer)
+    : stream(tokenizer), source(tokenizer.sourceText()), lines(source) {
+    currentToken = stream.next();
+}
+
+Parser::Parser(const TokenStore& store)
+    : stream(store), source(store.sourceText()), lines(source) {
+    currentToken = stream.next();
 }
 
 Node Parser::parse() {
     return parseStatements();
 }
 
+Node Parser::parse(vector<Diagnostic>& diagnostics) {
+    this->diagnostics = &diagnostics;
+    Node root = parseStatements();
+    this->diagnostics = nullptr;
+    return root;
+}
+
+// ----------------------------------------------------------------------------------
+// Statement grammar
+//
+// Statements are parsed by an LL(1) driver over this grammar:
+//
+//   Statement -> Declare ... | Function ... | Assign ... | Read ... | Print ...
+//              | If Expr Then                    opens an If
+//              | Else                            the innermost If moves to its Else block
+//              | Else If Expr Then               Else, then an If closed by the same End If
+//              | For Ident = Expr To Expr Do     opens a For
+//              | While Expr WhileTail
+//              | Do                              opens a Do ... While
+//              | End EndTail
+//   WhileTail -> Do                              opens a While
+//              | (nothing)                       closes the innermost Do with its condition
+//   EndTail   -> If | For | While                closes the innermost statement
+//
+// Bodies are not part of it: an opened statement waits on the `open` stack and the
+// statements that follow go into its block. "While Expr Do" always opens a loop, so
+// the statement after a Do ... While cannot be another Do. The grammar is the
+// `productions` table below; its predict table is built and checked at compile time,
+// so the driver picks a production with one lookup. Expressions and the insides of
+// the simple statements are parsed by hand, see parseExpression().
+
+// Statement-level terminals: token types, with the keywords told apart by spelling.
+// OTHER stands for every token the grammar does not name.
+enum class Terminal : uint8_t {
+    OTHER,
+    DECLARE,
+    FUNCTION,
+    ASSIGN,
+    READ,
+    PRINT,
+    IF,
+    ELSE,
+    ELSE_IF,  // one token, see Tokenizer::tokenizeIdentifier()
+    END,
+    FOR,
+    WHILE,
+    DO,
+    THEN,
+    TO,
+    AS,
+    OF,
+    END_OF_FILE,
+};
+static constexpr size_t terminalCount = static_cast<size_t>(Terminal::END_OF_FILE) + 1;
+
+static constexpr string_view terminalNames[terminalCount] = {
+    "", "Declare", "Function", "Assign", "Read", "Print", "If", "Else", "Else If", "End",
+    "For", "While", "Do", "Then", "To", "As", "Of", "end of input",
+};
+
+enum class Nonterminal : uint8_t { STATEMENT, WHILE_TAIL, END_TAIL };
+static constexpr size_t nonterminalCount = 3;
+
+// What one step of a production does
+enum class Action : uint8_t {
+    NONE,          // past the last step
+    MATCH,         // consume terminal `argument`
+    EXPRESSION,    // parse an expression onto `pending`
+    LOOP_START,    // parse the "i = start" of a For onto `pending`
+    SIMPLE,        // parse a whole statement of NodeType `argument`
+    OPEN,          // open a statement of NodeType `argument`
+    OPEN_CHAINED,  // open an If that its parent's End If closes
+    ELSE,          // move the innermost If to its Else block
+    CLOSE,         // close the innermost statement, expected to be of NodeType `argument`
+    EXPAND,        // go on with nonterminal `argument`
+};
+
+// What must be innermost on the `open` stack for a production to apply
+enum class Context : uint8_t {
+    ANY,
+    END_BLOCK,  // an If, For or While
+    IF_BODY,    // an If still in its Then block
+    DO_BODY,    // a Do
+};
+
+struct Step {
+    Action action;
+    uint8_t argument;
+};
+
+static constexpr Step match(Terminal terminal) { return { Action::MATCH, static_cast<uint8_t>(terminal) }; }
+static constexpr Step simple(NodeType type) { return { Action::SIMPLE, static_cast<uint8_t>(type) }; }
+static constexpr Step opens(NodeType type) { return { Action::OPEN, static_cast<uint8_t>(type) }; }
+static constexpr Step closes(NodeType type) { return { Action::CLOSE, static_cast<uint8_t>(type) }; }
+static constexpr Step expand(Nonterminal next) { return { Action::EXPAND, static_cast<uint8_t>(next) }; }
+static constexpr Step expression = { Action::EXPRESSION, 0 };
+static constexpr Step loopStart = { Action::LOOP_START, 0 };
+static constexpr Step elseBlock = { Action::ELSE, 0 };
+static constexpr Step opensChainedIf = { Action::OPEN_CHAINED, static_cast<uint8_t>(NodeType::IF_STATEMENT) };
+
+static constexpr size_t maxSteps = 6;
+
+struct Production {
+    Nonterminal head;
+    Terminal first;  // OTHER: taken on any terminal no other production of `head` starts with
+    Context context;
+    Step steps[maxSteps];
+};
+
+static constexpr Production productions[] = {
+    { Nonterminal::STATEMENT, Terminal::DECLARE, Context::ANY, { simple(NodeType::DECLARATION) } },
+    { Nonterminal::STATEMENT, Terminal::FUNCTION, Context::ANY, { simple(NodeType::FUNCTION_DECLARATION) } },
+    { Nonterminal::STATEMENT, Terminal::ASSIGN, Context::ANY, { simple(NodeType::ASSIGNMENT) } },
+    { Nonterminal::STATEMENT, Terminal::READ, Context::ANY, { simple(NodeType::READ) } },
+    { Nonterminal::STATEMENT, Terminal::PRINT, Context::ANY, { simple(NodeType::PRINT) } },
+    { Nonterminal::STATEMENT, Terminal::IF, Context::ANY,
+      { match(Terminal::IF), expression, match(Terminal::THEN), opens(NodeType::IF_STATEMENT) } },
+    { Nonterminal::STATEMENT, Terminal::ELSE, Context::IF_BODY, { match(Terminal::ELSE), elseBlock } },
+    { Nonterminal::STATEMENT, Terminal::ELSE_IF, Context::IF_BODY,
+      { match(Terminal::ELSE_IF), elseBlock, expression, match(Terminal::THEN), opensChainedIf } },
+    { Nonterminal::STATEMENT, Terminal::FOR, Context::ANY,
+      { match(Terminal::FOR), loopStart, match(Terminal::TO), expression, match(Terminal::DO), opens(NodeType::FOR_LOOP) } },
+    { Nonterminal::STATEMENT, Terminal::WHILE, Context::ANY,
+      { match(Terminal::WHILE), expression, expand(Nonterminal::WHILE_TAIL) } },
+    { Nonterminal::STATEMENT, Terminal::DO, Context::ANY, { match(Terminal::DO), opens(NodeType::DO_WHILE_LOOP) } },
+    { Nonterminal::STATEMENT, Terminal::END, Context::END_BLOCK, { match(Terminal::END), expand(Nonterminal::END_TAIL) } },
+    { Nonterminal::WHILE_TAIL, Terminal::DO, Context::ANY, { match(Terminal::DO), opens(NodeType::WHILE_LOOP) } },
+    { Nonterminal::WHILE_TAIL, Terminal::OTHER, Context::DO_BODY, { closes(NodeType::DO_WHILE_LOOP) } },
+    { Nonterminal::END_TAIL, Terminal::IF, Context::ANY, { match(Terminal::IF), closes(NodeType::IF_STATEMENT) } },
+    { Nonterminal::END_TAIL, Terminal::FOR, Context::ANY, { match(Terminal::FOR), closes(NodeType::FOR_LOOP) } },
+    { Nonterminal::END_TAIL, Terminal::WHILE, Context::ANY, { match(Terminal::WHILE), closes(NodeType::WHILE_LOOP) } },
+};
+static constexpr size_t productionCount = sizeof(productions) / sizeof(productions[0]);
+
+// predict[head][terminal]: the production to take, or -1 for a syntax error
+struct PredictTable {
+    int8_t predict[nonterminalCount][terminalCount];
+    bool conflict;  // two productions of one head start with the same terminal
+};
+
+static constexpr PredictTable buildPredictTable() {
+    PredictTable table{};
+    for (auto& row : table.predict) {
+        for (auto& entry : row) {
+            entry = -1;
+        }
+    }
+    bool hasDefault[nonterminalCount] = {};
+    for (size_t index = 0; index < productionCount; index++) {
+        const Production& production = productions[index];
+        size_t head = static_cast<size_t>(production.head);
+        if (production.first == Terminal::OTHER) {
+            table.conflict = table.conflict || hasDefault[head];
+            hasDefault[head] = true;
+            continue;
+        }
+        int8_t& entry = table.predict[head][static_cast<size_t>(production.first)];
+        table.conflict = table.conflict || entry != -1;
+        entry = static_cast<int8_t>(index);
+    }
+    // The default production fills in every terminal left over
+    for (size_t index = 0; index < productionCount; index++) {
+        if (productions[index].first == Terminal::OTHER) {
+            for (auto& entry : table.predict[static_cast<size_t>(productions[index].head)]) {
+                if (entry == -1) {
+                    entry = static_cast<int8_t>(index);
+                }
+            }
+        }
+    }
+    return table;
+}
+
+static constexpr PredictTable predictTable = buildPredictTable();
+static_assert(!predictTable.conflict, "the statement grammar is not LL(1)");
+static_assert(productionCount < INT8_MAX, "predict entries are int8_t");
+
+static Terminal terminalOf(const Token& token) {
+    switch (token.type) {
+        case TokenType::DECLARE: return Terminal::DECLARE;
+        case TokenType::FUNCTION: return Terminal::FUNCTION;
+        case TokenType::ASSIGN: return Terminal::ASSIGN;
+        case TokenType::READ: return Terminal::READ;
+        case TokenType::PRINT: return Terminal::PRINT;
+        case TokenType::IF: return Terminal::IF;
+        case TokenType::ELSE: return equalsIgnoreCase(token.lexeme, "Else") ? Terminal::ELSE : Terminal::ELSE_IF;
+        case TokenType::END: return Terminal::END;
+        case TokenType::FOR: return Terminal::FOR;
+        case TokenType::WHILE: return Terminal::WHILE;
+        case TokenType::END_OF_FILE: return Terminal::END_OF_FILE;
+        case TokenType::KEYWORD:
+            // The tokenizer has already matched the spelling, up to case
+            for (Terminal keyword : { Terminal::DO, Terminal::THEN, Terminal::TO, Terminal::AS, Terminal::OF }) {
+                if (equalsIgnoreCase(token.lexeme, terminalNames[static_cast<size_t>(keyword)])) {
+                    return keyword;
+                }
+            }
+            return Terminal::OTHER;
+        default:
+            return Terminal::OTHER;
+    }
+}
+
+// The keyword after End that closes a statement of this type
+static string_view closingKeyword(NodeType type) {
+    return type == NodeType::IF_STATEMENT ? "If" : type == NodeType::FOR_LOOP ? "For" : "While";
+}
+
+// ----------------------------------------------------------------------------------
+
+// Indices of tokens that start a top-level statement, about tokens.size() / chunkCount
+// apart, from 0 to the index of the trailing END_OF_FILE. If, For, While and Do open a
+// block, "End If", "End For", "End While" and the While of a Do close one, so counting
+// them is enough: a While whose condition is followed by Do opens a loop, any other
+// closes a Do, and a Do that no For or While claims opens one. An "Else If" is a single
+// ELSE token and opens nothing of its own. Empty when they do not balance: the input
+// has a syntax error then, which the serial parser will report.
+static vector<size_t> topLevelBounds(const vector<Token>& tokens, size_t chunkCount) {
+    size_t last = tokens.size() - (tokens.back().type == TokenType::END_OF_FILE ? 1 : 0);
+    vector<size_t> bounds = { 0 };
+    size_t nextCut = last / chunkCount;
+    long depth = 0;
+    auto statementAt = [&](size_t index, long change) {
+        if (depth == 0 && index >= nextCut && index > 0) {
+            bounds.push_back(index);
+            nextCut = index + last / chunkCount;
+        }
+        depth += change;
+    };
+    // Index of the first token from `index` on that is not part of an expression
+    auto skipExpression = [&](size_t index) {
+        while (index < last && (tokens[index].type == TokenType::IDENTIFIER || tokens[index].type == TokenType::NUMBER ||
+                                tokens[index].type == TokenType::STRINGVAL || tokens[index].type == TokenType::OPERATOR ||
+                                tokens[index].type == TokenType::PUNCTUATION)) {
+            index++;
+        }
+        return index;
+    };
+
+    for (size_t index = 0; index < last; index++) {
+        switch (terminalOf(tokens[index])) {
+            case Terminal::END: {
+                Terminal closed = index + 1 < last ? terminalOf(tokens[index + 1]) : Terminal::END_OF_FILE;
+                if ((closed != Terminal::IF && closed != Terminal::FOR && closed != Terminal::WHILE) || --depth < 0) {
+                    return {};
+                }
+                index++;
+                break;
+            }
+            case Terminal::FOR:
+                // The header's Do belongs to the For
+                statementAt(index, 1);
+                while (index + 1 < last && terminalOf(tokens[index + 1]) != Terminal::DO) {
+                    index++;
+                }
+                index++;
+                break;
+            case Terminal::WHILE: {
+                size_t next = skipExpression(index + 1);
+                if (next < last && terminalOf(tokens[next]) == Terminal::DO) {
+                    statementAt(index, 1);
+                    index = next;
+                } else if (--depth < 0) {
+                    return {};
+                }
+                break;
+            }
+            case Terminal::IF:
+            case Terminal::DO:
+                statementAt(index, 1);
+                break;
+            case Terminal::DECLARE:
+            case Terminal::FUNCTION:
+            case Terminal::ASSIGN:
+            case Terminal::READ:
+            case Terminal::PRINT:
+                statementAt(index, 0);
+                break;
+            default:
+                break;
+        }
+    }
+    if (depth != 0) {
+        return {};
+    }
+    bounds.push_back(last);
+    return bounds;
+}
+
+Node Parser::parseParallel(size_t threadCount, size_t minChunkTokens) {
+    size_t chunkCount = tokenVector ? min(threadCount * 4, tokenVector->size() / max<size_t>(minChunkTokens, 1)) : 0;
+    if (threadCount <= 1 || chunkCount <= 1) {
+        return parse();
+    }
+    vector<size_t> bounds = topLevelBounds(*tokenVector, chunkCount);
+    if (bounds.size() <= 2) {
+        return parse();
+    }
+
+    // Each chunk gets a parser and an arena of its own
+    size_t chunks = bounds.size() - 1;
+    vector<unique_ptr<Parser>> parsers(chunks);
+    vector<NodeList> statements(chunks);
+    vector<char> failed(chunks, false);
+    parallelFor(chunks, threadCount, [&](size_t chunk) {
+        parsers[chunk] = make_unique<Parser>(*tokenVector, bounds[chunk], bounds[chunk + 1]);
+        try {
+            statements[chunk] = parsers[chunk]->parse().children;
+        } catch (const ParseError&) {
+            failed[chunk] = true;
+        }
+    });
+    if (find(failed.begin(), failed.end(), true) != failed.end()) {
+        return parse();
+    }
+
+    // Splice the statements together in chunk order
+    Node node(NodeType::DECLARATION, currentToken);
+    size_t mark = pending.size();
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        pending.insert(pending.end(), statements[chunk].begin(), statements[chunk].end());
+        arena.adopt(parsers[chunk]->takeArena());
+    }
+    node.children = closeChildren(mark);
+    return node;
+}
+
+void Parser::parse(StatementSink& sink) {
+    this->sink = &sink;
+    parseStatements();
+    this->sink = nullptr;
+}
+
+// Statements are parsed by a loop, not by recursion: an If, For, While or Do that is
+// still open sits on the `open` stack with its finished statements on `pending`, so
+// nesting depth is limited by memory rather than by the call stack.
 Node Parser::parseStatements() {
     Node node(NodeType::DECLARATION, currentToken);
-    while (currentToken.type != TokenType::END_OF_FILE) {
-        node.children.push_back(parseStatement());
+    size_t mark = pending.size();
+    vector<OpenStatement> open;
+
+    while (!open.empty() || currentToken.type != TokenType::END_OF_FILE) {
+        Token statementToken = currentToken;
+        size_t statementMark = pending.size();
+        try {
+            if (currentToken.type == TokenType::END_OF_FILE) {
+                // Input ended inside a statement; a Do without its While has no condition
+                OpenStatement& innermost = open.back();
+                report(unexpected(currentToken, innermost.node.type == NodeType::DO_WHILE_LOOP ? "While" :
+                                                "End " + string(closingKeyword(innermost.node.type))));
+                innermost.broken = innermost.broken || innermost.node.type == NodeType::DO_WHILE_LOOP;
+                closeStatement(open);
+                continue;
+            }
+            parseStatement(open);
+        } catch (const ParseError& error) {
+            if (!diagnostics) {
+                throw;
+            }
+            report(error.diagnostic);
+            // An Else If that failed after its Else has started the Else block, which stays
+            size_t keep = open.empty() ? statementMark : max(statementMark, open.back().blockMark);
+            pending.erase(pending.begin() + keep, pending.end());
+            synchronize(statementToken.offset);
+
+            // The While that closes a Do: the Do ends here, without a condition
+            if (statementToken.type == TokenType::WHILE && !open.empty() &&
+                open.back().node.type == NodeType::DO_WHILE_LOOP) {
+                open.back().broken = true;
+                closeStatement(open);
+                continue;
+            }
+
+            // A compound statement whose header failed stays open, so its body is
+            // still checked and its End does not close the enclosing statement
+            NodeType type = statementToken.type == TokenType::IF ? NodeType::IF_STATEMENT :
+                            statementToken.type == TokenType::FOR ? NodeType::FOR_LOOP :
+                            statementToken.type == TokenType::WHILE ? NodeType::WHILE_LOOP : NodeType::BLOCK;
+            if (type != NodeType::BLOCK) {
+                open.push_back({ Node(type, statementToken), pending.size(), Node(NodeType::BLOCK, currentToken),
+                                 pending.size(), false, true, false });
+            }
+        }
     }
+    node.children = closeChildren(mark);
     return node;
 }
 
-Node Parser::parseStatement() {
-    switch (currentToken.type) {
-        case TokenType::DECLARE:
+// Parses one statement by running the productions the predict table picks: a simple
+// statement is finished here, a compound one is opened or closed on `open`.
+void Parser::parseStatement(vector<OpenStatement>& open) {
+    Token begin = currentToken;     // token of a node opened by this statement
+    size_t beginMark = pending.size();  // where its children start
+    Token last = currentToken;      // the last terminal matched
+    Nonterminal head = Nonterminal::STATEMENT;
+
+    for (bool expanded = true; expanded;) {
+        expanded = false;
+        int index = predictTable.predict[static_cast<size_t>(head)][static_cast<size_t>(terminalOf(currentToken))];
+        const Production* production = index < 0 ? nullptr : &productions[index];
+        NodeType innermost = open.empty() ? NodeType::BLOCK : open.back().node.type;
+        bool applies = production && (production->context == Context::ANY ||
+            (production->context == Context::END_BLOCK && innermost != NodeType::BLOCK &&
+             innermost != NodeType::DO_WHILE_LOOP) ||
+            (production->context == Context::IF_BODY && innermost == NodeType::IF_STATEMENT && !open.back().inElse) ||
+            (production->context == Context::DO_BODY && innermost == NodeType::DO_WHILE_LOOP));
+        if (!applies) {
+            fail(unexpected(currentToken, head == Nonterminal::WHILE_TAIL ? "Do" :
+                                          head == Nonterminal::END_TAIL ? closingKeyword(innermost) : ""));
+        }
+
+        for (const Step& step : production->steps) {
+            NodeType type = static_cast<NodeType>(step.argument);
+            switch (step.action) {
+                case Action::NONE:
+                    break;
+                case Action::MATCH:
+                    last = expect(static_cast<Terminal>(step.argument));
+                    break;
+                case Action::EXPRESSION:
+                    pending.push_back(parseExpression());
+                    break;
+                case Action::LOOP_START:
+                    pending.push_back(parseLoopStart());
+                    break;
+                case Action::SIMPLE:
+                    pending.push_back(parseSimpleStatement(type));
+                    if (sink) {
+                        sink->statement(pending.back());
+                        pending.pop_back();
+                        arena.clear();
+                    }
+                    break;
+                case Action::OPEN:
+                case Action::OPEN_CHAINED:
+                    open.push_back({ Node(type, begin), beginMark, Node(NodeType::BLOCK, last), pending.size(),
+                                     false, false, step.action == Action::OPEN_CHAINED });
+                    if (sink) {
+                        streamOpen(open.back());
+                    }
+                    break;
+                case Action::ELSE:
+                    enterElse(open.back(), last);
+                    beginMark = pending.size();
+                    break;
+                case Action::CLOSE:
+                    if (open.back().node.type != type) {
+                        // End of the wrong kind: close the innermost statement anyway
+                        report(unexpected(last, closingKeyword(open.back().node.type)));
+                    }
+                    closeStatement(open);
+                    break;
+                case Action::EXPAND:
+                    // Always the last step
+                    head = static_cast<Nonterminal>(step.argument);
+                    expanded = true;
+                    break;
+            }
+        }
+    }
+}
+// Closes the innermost open statement once its End, or the While of a Do, has been
+// matched, together with the Ifs it is chained to by Else If
+void Parser::closeStatement(vector<OpenStatement>& open) {
+    bool chained = true;
+    while (chained && !open.empty()) {
+        OpenStatement& innermost = open.back();
+        chained = innermost.chained;
+        bool doWhile = innermost.node.type == NodeType::DO_WHILE_LOOP && !innermost.broken;
+
+        if (sink) {
+            if (doWhile) {
+                // The condition is the one node left on `pending`
+                Node statement = innermost.node;
+                statement.children = NodeList(&pending.back(), 1);
+                sink->close(statement, false);
+                pending.pop_back();
+                arena.clear();
+            } else if (!innermost.broken) {
+                sink->close(innermost.node, innermost.inElse);
+            }
+            open.pop_back();
+            continue;
+        }
+
+        if (innermost.broken) {
+            pending.erase(pending.begin() + innermost.mark, pending.end());
+        } else if (doWhile) {
+            // The condition was parsed after the body but comes first, as in a While
+            Node condition = pending.back();
+            pending.pop_back();
+            closeBlock(innermost);
+            pending.insert(pending.begin() + innermost.mark, condition);
+            innermost.node.children = closeChildren(innermost.mark);
+            pending.push_back(move(innermost.node));
+        } else {
+            closeBlock(innermost);
+            innermost.node.children = closeChildren(innermost.mark);
+            pending.push_back(move(innermost.node));
+        }
+        open.pop_back();
+    }
+}
+
+// Moves an If on to its Else block, which starts at `elseToken`
+void Parser::enterElse(OpenStatement& statement, Token elseToken) {
+    if (!sink) {
+        closeBlock(statement);
+    } else if (!statement.broken) {
+        sink->elseBranch(statement.node);
+    }
+    statement.block = Node(NodeType::BLOCK, elseToken);
+    statement.blockMark = pending.size();
+    statement.inElse = true;
+}
+
+// Hands a just-opened statement's header to the sink; nothing of it is kept, so the
+// arena can be recycled
+void Parser::streamOpen(OpenStatement& statement) {
+    Node header = statement.node;
+    header.children = NodeList(pending.data() + statement.mark, pending.size() - statement.mark);
+    sink->open(header);
+    pending.erase(pending.begin() + statement.mark, pending.end());
+    statement.blockMark = statement.mark;
+    arena.clear();
+}
+
+// Panic-mode recovery: skip to the next token that can start or end a statement.
+// The token the failed statement started at is always skipped, so recovery cannot
+// loop; a stray "End If" is skipped as a whole.
+void Parser::synchronize(uint32_t statementStart) {
+    if (currentToken.offset == statementStart && currentToken.type != TokenType::END_OF_FILE) {
+        bool strayEnd = currentToken.type == TokenType::END;
+        currentToken = stream.next();
+        if (strayEnd && (currentToken.type == TokenType::IF || currentToken.type == TokenType::FOR ||
+                         currentToken.type == TokenType::WHILE)) {
+            currentToken = stream.next();
+        }
+    }
+    while (true) {
+        switch (currentToken.type) {
+            case TokenType::DECLARE:
+            case TokenType::FUNCTION:
+            case TokenType::ASSIGN:
+            case TokenType::READ:
+            case TokenType::PRINT:
+            case TokenType::IF:
+            case TokenType::FOR:
+            case TokenType::WHILE:
+            case TokenType::ELSE:
+            case TokenType::END:
+            case TokenType::END_OF_FILE:
+                return;
+            default:
+                currentToken = stream.next();
+        }
+    }
+}
+
+Node Parser::parseSimpleStatement(NodeType type) {
+    switch (type) {
+        case NodeType::DECLARATION:
             return parseDeclaration();
-        case TokenType::FUNCTION:
+        case NodeType::FUNCTION_DECLARATION:
             return parseFunctionDeclaration();
-        case TokenType::ASSIGN:
+        case NodeType::ASSIGNMENT:
             return parseAssignment();
-        case TokenType::PRINT:
-            return parsePrint();
-        case TokenType::IF:
-            return parseIf();
-        case TokenType::FOR:
-            return parseFor();
-        case TokenType::WHILE:
-            return parseWhile();
+        case NodeType::READ:
+            return parseRead();
         default:
-            throw runtime_error("Unexpected token: " + currentToken.lexeme);
+            return parsePrint();
     }
 }
 
 Node Parser::parseDeclaration() {
     Token declareToken = consume(TokenType::DECLARE);
     Token identifierToken = consume(TokenType::IDENTIFIER);
-    Token asKeyWord = consume(TokenType::KEYWORD);
+    expect(Terminal::AS);
 
     // Consume the type token
     Token typeToken = consume(currentToken.type);
     Node node(NodeType::DECLARATION, declareToken);
+    size_t mark = pending.size();
 
     if(typeToken.type == TokenType::ARRAY){
         // 1D array
-        node.children.push_back(Node(NodeType::IDENTIFIER, identifierToken));
-        node.children.push_back(Node(NodeType::IDENTIFIER, typeToken));
+        pending.push_back(Node(NodeType::IDENTIFIER, identifierToken));
+        pending.push_back(Node(NodeType::IDENTIFIER, typeToken));
 
-        Token ofKeyWord = consume(TokenType::KEYWORD);
+        expect(Terminal::OF);
         Token dataTypeToken = consume(currentToken.type);
+        consume(TokenType::PUNCTUATION, "[");
         Token arraySize = consume(TokenType::NUMBER);
+        consume(TokenType::PUNCTUATION, "]");
 
-        node.children.push_back(Node(NodeType::IDENTIFIER, dataTypeToken));
-        node.children.push_back(Node(NodeType::IDENTIFIER, arraySize));
+        pending.push_back(Node(NodeType::IDENTIFIER, dataTypeToken));
+        pending.push_back(Node(NodeType::IDENTIFIER, arraySize));
 
-        if(currentToken.type == TokenType::NUMBER){
+        if(isPunctuation("[")){
             // 2D array
+            consume(TokenType::PUNCTUATION, "[");
             Token arraySize2 = consume(TokenType::NUMBER);
-            node.children.push_back(Node(NodeType::IDENTIFIER, arraySize2));
+            consume(TokenType::PUNCTUATION, "]");
+            pending.push_back(Node(NodeType::IDENTIFIER, arraySize2));
         }
     }
     else{
-        node.children.push_back(Node(NodeType::IDENTIFIER, identifierToken));
-        node.children.push_back(Node(NodeType::IDENTIFIER, typeToken)); // Assuming type is also an identifier
+        pending.push_back(Node(NodeType::IDENTIFIER, identifierToken));
+        pending.push_back(Node(NodeType::IDENTIFIER, typeToken)); // Assuming type is also an identifier
     }
 
+    node.children = closeChildren(mark);
     return node;
 }
 
@@ -81,152 +656,490 @@ Node Parser::parseFunctionDeclaration() {
     Token identifier = consume(TokenType::IDENTIFIER);
     consume(TokenType::KEYWORD); // assuming FUNCTION is followed by params
     Node node(NodeType::FUNCTION_DECLARATION, token);
-    node.children.push_back(Node(NodeType::IDENTIFIER, identifier));
+    size_t mark = pending.size();
+    pending.push_back(Node(NodeType::IDENTIFIER, identifier));
     // parse function body
+    node.children = closeChildren(mark);
     return node;
 }
 
 Node Parser::parseAssignment(){
     Token assignToken = consume(TokenType::ASSIGN);
     Node node(NodeType::ASSIGNMENT, assignToken);
+    size_t mark = pending.size();
+
+    Token identifierToken = consume(TokenType::IDENTIFIER);
+    pending.push_back(Node(NodeType::IDENTIFIER, identifierToken));
 
-    while(currentToken.type == TokenType::IDENTIFIER){
-        Token identifierToken = consume(TokenType::IDENTIFIER);
-        node.children.push_back(Node(NodeType::IDENTIFIER, identifierToken));
+    // Array indices: arr[i] or mat[i][j], kept as siblings of the variable
+    while(isPunctuation("[")){
+        consume(TokenType::PUNCTUATION, "[");
+        Token indexToken = consume(currentToken.type == TokenType::NUMBER ? TokenType::NUMBER : TokenType::IDENTIFIER);
+        consume(TokenType::PUNCTUATION, "]");
+        pending.push_back(Node(NodeType::IDENTIFIER, indexToken));
     }
 
     Token opert = consume(TokenType::OPERATOR);
-    node.children.push_back(Node(NodeType::IDENTIFIER, opert));
+    pending.push_back(Node(NodeType::IDENTIFIER, opert));
 
     // Token expr = consume(currentToken.type);
     Node expr = parseExpression();
-    node.children.push_back(expr);
+    pending.push_back(move(expr));
 
+    node.children = closeChildren(mark);
     return node;
 }
 
+// Expression grammar, loosest to tightest binding:
+//   Or ||  <  And &&  <  Not (prefix)  <  = == <> < > <= >=  <  + -  <  * /
+//   <  unary -  <  postfix [index] and (call)  <  primary
+// Binary operators are left-associative. The EXPRESSION node is a slot holding the
+// resulting tree as its only child.
+static constexpr int notPrecedence = 3;
+
 Node Parser::parseExpression(){
-    Token exprSt;
-    Node node(NodeType::EXPRESSION, exprSt);
+    Token exprSt{};
+    exprSt.offset = currentToken.offset;  // empty lexeme, positioned at the expression
+    return makeNode(NodeType::EXPRESSION, exprSt, { parseBinary(1) });
+}
+
+// Precedence climbing: fold in operators that bind at least as tightly as
+// minPrecedence and leave looser ones to the caller. Each token is looked at once,
+// so long chains like a + b + c + ... parse in linear time.
+Node Parser::parseBinary(int minPrecedence){
+    Node left = parseUnary();
+
+    while(currentToken.type == TokenType::OPERATOR){
+        string_view op = canonicalOperator(currentToken.lexeme);
+        int precedence = binaryPrecedence(op);
+        if(precedence == 0 || precedence < minPrecedence){
+            break;
+        }
+        Token opToken = consume(TokenType::OPERATOR);
+        opToken.lexeme = op;
+        Node right = parseBinary(precedence + 1);
+        left = makeNode(NodeType::BINARY_EXPRESSION, opToken, { left, right });
+    }
+    return left;
+}
 
-    while(currentToken.type==TokenType::IDENTIFIER || currentToken.type==TokenType::OPERATOR || currentToken.type==TokenType::NUMBER || currentToken.type==TokenType::STRINGVAL){
-        Token expr = consume(currentToken.type);
-        node.children.push_back(Node(NodeType::IDENTIFIER, expr));
+Node Parser::parseUnary(){
+    if(currentToken.type == TokenType::OPERATOR){
+        string_view op = canonicalOperator(currentToken.lexeme);
+        if(op == "!"){
+            // Not x = 3 negates the comparison, so the operand takes in everything
+            // that binds tighter than Not
+            Token opToken = consume(TokenType::OPERATOR);
+            opToken.lexeme = op;
+            return makeNode(NodeType::UNARY_EXPRESSION, opToken, { parseBinary(notPrecedence + 1) });
+        }
+        if(op == "-"){
+            Token opToken = consume(TokenType::OPERATOR);
+            return makeNode(NodeType::UNARY_EXPRESSION, opToken, { parseUnary() });
+        }
+    }
+    return parsePostfix();
+}
+
+Node Parser::parsePostfix(){
+    Node node = parsePrimary();
+    while(isPunctuation("[") || isPunctuation("(")){
+        if(isPunctuation("[")){
+            Token open = consume(TokenType::PUNCTUATION, "[");
+            Node index = parseBinary(1);
+            consume(TokenType::PUNCTUATION, "]");
+            node = makeNode(NodeType::INDEX_EXPRESSION, open, { node, index });
+            continue;
+        }
+
+        Token open = consume(TokenType::PUNCTUATION, "(");
+        Node call(NodeType::CALL_EXPRESSION, open);
+        size_t mark = pending.size();
+        pending.push_back(move(node));
+        if(!isPunctuation(")")){
+            pending.push_back(parseBinary(1));
+            while(isPunctuation(",")){
+                consume(TokenType::PUNCTUATION, ",");
+                pending.push_back(parseBinary(1));
+            }
+        }
+        consume(TokenType::PUNCTUATION, ")");
+        call.children = closeChildren(mark);
+        node = call;
+    }
+    return node;
+}
+
+Node Parser::parsePrimary(){
+    switch(currentToken.type){
+        case TokenType::IDENTIFIER:
+        case TokenType::NUMBER:
+        case TokenType::STRINGVAL:
+            return Node(NodeType::IDENTIFIER, consume(currentToken.type));
+        default:
+            break;
+    }
+    if(isPunctuation("(")){
+        consume(TokenType::PUNCTUATION, "(");
+        Node inner = parseBinary(1);
+        consume(TokenType::PUNCTUATION, ")");
+        return inner;
     }
+    fail(unexpected(currentToken));
+}
 
+Node Parser::makeNode(NodeType type, Token token, initializer_list<Node> children){
+    Node node(type, token);
+    node.children = arena.copy(children.begin(), children.size());
     return node;
 }
 
 Node Parser::parsePrint(){
     Token printToken = consume(TokenType::PRINT);
     Node node(NodeType::PRINT, printToken);
+    size_t mark = pending.size();
 
     while(currentToken.type==TokenType::IDENTIFIER || currentToken.type==TokenType::STRINGVAL || currentToken.type==TokenType::NUMBER){
         Token printId = consume(currentToken.type);
-        node.children.push_back(Node(NodeType::IDENTIFIER, printId));
+        Node printNode(NodeType::IDENTIFIER, printId);
+        size_t indexMark = pending.size();
+
+        // Array element: the indices become children of the variable
+        while(printId.type == TokenType::IDENTIFIER && isPunctuation("[")){
+            consume(TokenType::PUNCTUATION, "[");
+            Token indexToken = consume(currentToken.type == TokenType::NUMBER ? TokenType::NUMBER : TokenType::IDENTIFIER);
+            consume(TokenType::PUNCTUATION, "]");
+            pending.push_back(Node(NodeType::IDENTIFIER, indexToken));
+        }
+        printNode.children = closeChildren(indexMark);
+        pending.push_back(move(printNode));
+
+        // Items may be separated by commas
+        if(isPunctuation(",")){
+            consume(TokenType::PUNCTUATION, ",");
+        }
     }
 
+    node.children = closeChildren(mark);
+    return node;
+}
+
+// Read x, arr[i], ...: the variables to read into, indices as children like Print's
+Node Parser::parseRead(){
+    Token readToken = consume(TokenType::READ);
+    Node node(NodeType::READ, readToken);
+    size_t mark = pending.size();
+
+    do{
+        if(isPunctuation(",")){
+            consume(TokenType::PUNCTUATION, ",");
+        }
+        Node variable(NodeType::IDENTIFIER, consume(TokenType::IDENTIFIER));
+        size_t indexMark = pending.size();
+        while(isPunctuation("[")){
+            consume(TokenType::PUNCTUATION, "[");
+            Token indexToken = consume(currentToken.type == TokenType::NUMBER ? TokenType::NUMBER : TokenType::IDENTIFIER);
+            consume(TokenType::PUNCTUATION, "]");
+            pending.push_back(Node(NodeType::IDENTIFIER, indexToken));
+        }
+        variable.children = closeChildren(indexMark);
+        pending.push_back(move(variable));
+    }while(currentToken.type == TokenType::IDENTIFIER || isPunctuation(","));
+
+    node.children = closeChildren(mark);
     return node;
 }
 
-Node Parser::parseIf(){
-    Token ifToken = consume(TokenType::IF);
-    Node node(NodeType::IF_STATEMENT, ifToken);
+// The start value of a For is an assignment to the loop variable: i = 0
+Node Parser::parseLoopStart(){
+    Token iteratorToken = consume(TokenType::IDENTIFIER);
+    Token assignToken = consume(TokenType::OPERATOR, "=");
+    Node start = parseExpression();
+    return makeNode(NodeType::ASSIGNMENT, assignToken,
+                    { Node(NodeType::IDENTIFIER, iteratorToken), Node(NodeType::IDENTIFIER, assignToken), start });
+}
 
-    Node condition = parseExpression();
-    node.children.push_back(condition);
+void Parser::closeBlock(OpenStatement& statement){
+    statement.block.children = closeChildren(statement.blockMark);
+    pending.push_back(statement.block);
+}
 
-    Token thenToken = consume(TokenType::KEYWORD);
-    Node ifBlock(NodeType::BLOCK, thenToken);
+bool Parser::isPunctuation(string_view lexeme) const {
+    return currentToken.type == TokenType::PUNCTUATION && currentToken.lexeme == lexeme;
+}
 
-    while(currentToken.type != TokenType::ELSE && currentToken.type != TokenType::END){
-        Node blkStatement = parseStatement();
-        ifBlock.children.push_back(blkStatement);
+Token Parser::expect(Terminal terminal) {
+    if (terminalOf(currentToken) != terminal) {
+        fail(unexpected(currentToken, terminalNames[static_cast<size_t>(terminal)]));
     }
-    node.children.push_back(ifBlock);
+    return exchange(currentToken, stream.next());
+}
 
-    if(currentToken.type == TokenType::ELSE){
-        Token elseToken = consume(TokenType::ELSE);
-        Node elseBlock(NodeType::BLOCK, elseToken);
+Token Parser::consume(TokenType expectedType, string_view expectedLexeme) {
+    if (currentToken.type != expectedType || currentToken.lexeme != expectedLexeme) {
+        fail(unexpected(currentToken, expectedLexeme));
+    }
+    return consume(expectedType);
+}
 
-        while(currentToken.type != TokenType::END){
-            Node blkStatement = parseStatement();
-            elseBlock.children.push_back(blkStatement);
-        }
-        node.children.push_back(elseBlock);
+Token Parser::consume(TokenType expectedType) {
+    if (currentToken.type != expectedType) {
+        fail(unexpected(currentToken));
     }
-    
-    Token endToken = consume(TokenType::END);
-    Token endIfToken = consume(TokenType::IF);
+    return exchange(currentToken, stream.next());
+}
 
-    return node;
+NodeList Parser::closeChildren(size_t mark) {
+    NodeList children = arena.copy(pending.data() + mark, pending.size() - mark);
+    pending.erase(pending.begin() + mark, pending.end());
+    return children;
 }
 
-Node Parser::parseFor(){
-    Token forToken = consume(TokenType::FOR);
-    Node node(NodeType::FOR_LOOP, forToken);
+string_view canonicalOperator(string_view op) {
+    if (op == "=") {
+        return "==";
+    }
+    if (op == "<>") {
+        return "!=";
+    }
+    // Keyword operators may arrive in any case when keyword case is ignored
+    if (equalsIgnoreCase(op, "And")) {
+        return "&&";
+    }
+    if (equalsIgnoreCase(op, "Or")) {
+        return "||";
+    }
+    if (equalsIgnoreCase(op, "Not")) {
+        return "!";
+    }
+    return op;
+}
 
-    Node stCondition = parseExpression();
-    node.children.push_back(stCondition);
-    Token toToken = consume(TokenType::KEYWORD);
-    Node edCondition = parseExpression();
-    node.children.push_back(edCondition);
+int binaryPrecedence(string_view op) {
+    if (op == "||") {
+        return 1;
+    }
+    if (op == "&&") {
+        return 2;
+    }
+    if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=") {
+        return 4;
+    }
+    if (op == "+" || op == "-") {
+        return 5;
+    }
+    if (op == "*" || op == "/") {
+        return 6;
+    }
+    return 0;
+}
 
-    Token doToken = consume(TokenType::KEYWORD);
-    Node forBlock(NodeType::BLOCK, doToken);
+string Parser::where(const Token& token) const {
+    if (source.empty()) {
+        return "";
+    }
+    SourceLocation location = lines.locate(token.offset);
+    return " at line " + to_string(location.line) + ", column " + to_string(location.column);
+}
 
-    while(currentToken.type != TokenType::END){
-        Node blkStatement = parseStatement();
-        forBlock.children.push_back(blkStatement);
+Diagnostic Parser::unexpected(const Token& token, string_view expected) const {
+    string message = token.type == TokenType::END_OF_FILE ? "Unexpected end of input" :
+                     "Unexpected token: " + string(token.lexeme);
+    message += where(token);
+    if (!expected.empty()) {
+        message += ", expected " + string(expected);
     }
-    node.children.push_back(forBlock);
+    return { message, token.offset };
+}
 
-    Token endToken = consume(TokenType::END);
-    Token endForToken = consume(TokenType::FOR);
+void Parser::fail(const Diagnostic& diagnostic) const {
+    throw ParseError(diagnostic);
+}
 
-    return node;
+// Unwinding several open statements at one token reports it once
+void Parser::report(const Diagnostic& diagnostic) {
+    if (!diagnostics) {
+        fail(diagnostic);
+    }
+    if (diagnostics->empty() || diagnostics->back().offset != diagnostic.offset) {
+        diagnostics->push_back(diagnostic);
+    }
 }
 
-Node Parser::parseWhile(){
-    Token whileToken = consume(TokenType::WHILE);
-    Node node(NodeType::WHILE_LOOP, whileToken);
+// ----------------------------------------------------------------------------------
+// AstArena
 
-    Node condition = parseExpression();
-    node.children.push_back(condition);
+static_assert(is_trivially_destructible<Node>::value, "AstArena never runs node destructors");
 
-    Token doToken = consume(TokenType::KEYWORD);
-    Node whileBlock(NodeType::BLOCK, doToken);
+AstArena::AstArena(AstArena&& other) noexcept
+    : blocks(move(other.blocks)), current(other.current), remaining(other.remaining), nodes(other.nodes) {
+    other.current = nullptr;
+    other.remaining = 0;
+    other.nodes = 0;
+}
 
-    while(currentToken.type != TokenType::END){
-        Node blkStatement = parseStatement();
-        whileBlock.children.push_back(blkStatement);
+AstArena& AstArena::operator=(AstArena&& other) noexcept {
+    blocks = move(other.blocks);
+    current = other.current;
+    remaining = other.remaining;
+    nodes = other.nodes;
+    other.current = nullptr;
+    other.remaining = 0;
+    other.nodes = 0;
+    return *this;
+}
+
+Node* AstArena::allocateBlock(size_t count) {
+    blocks.emplace_back(static_cast<Node*>(::operator new(count * sizeof(Node))));
+    return blocks.back().get();
+}
+
+void AstArena::clear() {
+    unique_ptr<Node, BlockDeleter> reuse;
+    if (current) {
+        // Start of the regular block that `current` points into
+        Node* start = current - (blockNodes - remaining);
+        for (auto& block : blocks) {
+            if (block.get() == start) {
+                reuse = move(block);
+                break;
+            }
+        }
+        current = start;
+        remaining = blockNodes;
+    }
+    blocks.clear();
+    if (reuse) {
+        blocks.push_back(move(reuse));
     }
-    node.children.push_back(whileBlock);
+    nodes = 0;
+}
 
-    Token endToken = consume(TokenType::END);
-    Token endWhileToken = consume(TokenType::WHILE);
+void AstArena::adopt(AstArena&& other) {
+    for (auto& block : other.blocks) {
+        blocks.push_back(move(block));
+    }
+    nodes += other.nodes;
+    other = AstArena();
+}
 
-    return node;
+NodeList AstArena::copy(const Node* source, size_t count) {
+    if (count == 0) {
+        return NodeList();
+    }
+    if (count > UINT32_MAX) {
+        throw length_error("AstArena child lists are limited to 2^32 nodes");
+    }
+    Node* target;
+    if (count > blockNodes / 4) {
+        // Long lists (a big program's statements) get a block of their own, so the
+        // current block keeps its free space for the small lists that follow
+        target = allocateBlock(count);
+    } else {
+        if (count > remaining) {
+            current = allocateBlock(blockNodes);
+            remaining = blockNodes;
+        }
+        target = current;
+        current += count;
+        remaining -= count;
+    }
+    uninitialized_copy(source, source + count, target);
+    nodes += count;
+    return NodeList(target, count);
 }
 
-void Parser::release(TokenType expectedType) {
-    if (currentToken.type != expectedType) {
-        throw runtime_error("Unexpected token: " + currentToken.lexeme);
+// ----------------------------------------------------------------------------------
+// FlatAst
+
+// Both conversions keep their own stack instead of recursing, like printAST
+FlatAst FlatAst::fromTree(const Node& root) {
+    // A node whose subtree is still being appended, and its next child to visit
+    struct OpenNode {
+        const Node* node;
+        size_t index;
+        size_t nextChild;
+    };
+
+    FlatAst ast;
+    vector<OpenNode> open;
+    const Node* next = &root;
+    while (next) {
+        open.push_back({ next, ast.nodes.size(), 0 });
+        ast.nodes.push_back({ next->type, static_cast<uint32_t>(ast.tokens.size()), 0 });
+        ast.tokens.push_back(next->token);
+
+        next = nullptr;
+        while (!open.empty() && !next) {
+            OpenNode& top = open.back();
+            if (top.nextChild < top.node->children.size()) {
+                next = &top.node->children[top.nextChild++];
+            } else {
+                ast.nodes[top.index].subtreeSize = static_cast<uint32_t>(ast.nodes.size() - top.index);
+                open.pop_back();
+            }
+        }
     }
-    currentToken = tokens[--currentPos];
+    return ast;
 }
 
-Token Parser::consume(TokenType expectedType) {
-    if (currentToken.type != expectedType) {
-        throw runtime_error("Unexpected token: " + currentToken.lexeme);
+Node FlatAst::toTree(AstArena& arena) const {
+    // Build bottom-up: walking the pre-order array backwards, a node's children are
+    // already built and sit on top of `built`, first child on top
+    vector<Node> built;
+    for (size_t index = nodes.size(); index > 0; --index) {
+        const FlatNode& flat = nodes[index - 1];
+        size_t childCount = 0;
+        for (size_t child = index, end = index - 1 + flat.subtreeSize; child < end; child += nodes[child].subtreeSize) {
+            childCount++;
+        }
+
+        Node node(flat.type, tokens[flat.token]);
+        size_t first = built.size() - childCount;
+        reverse(built.begin() + first, built.end());
+        node.children = arena.copy(built.data() + first, childCount);
+        built.erase(built.begin() + first, built.end());
+        built.push_back(node);
     }
-    Token token = currentToken;
-    currentToken = tokens[++currentPos];
-    return token;
+    return built.back();
 }
 
-void printAST(const Node& node, int level) {
-    for (int i = 0; i < level; ++i) {
+FlatNodeRef FlatAst::at(size_t index) const {
+    return { nodes[index].type, tokens[nodes[index].token], FlatChildren(this, static_cast<uint32_t>(index)) };
+}
+
+FlatNodeRef FlatChildren::iterator::operator*() const {
+    return ast->at(index);
+}
+
+FlatChildren::iterator& FlatChildren::iterator::operator++() {
+    index += ast->node(index).subtreeSize;
+    return *this;
+}
+
+FlatChildren::iterator FlatChildren::end() const {
+    return iterator(ast, parent + ast->node(parent).subtreeSize);
+}
+
+size_t FlatChildren::size() const {
+    size_t count = 0;
+    for (iterator child = begin(), last = end(); child != last; ++child) {
+        count++;
+    }
+    return count;
+}
+
+FlatNodeRef FlatChildren::operator[](size_t index) const {
+    iterator child = begin();
+    for (size_t ind = 0; ind < index; ind++) {
+        ++child;
+    }
+    return *child;
+}
+
+// Prints a single node, without its children
+static void printNode(const Node& node, int level, const LineTable* lines) {
+    for (int i = 0; i < min(level, maxIndentLevel); ++i) {
         cout << "  ";
     }
 
@@ -268,13 +1181,41 @@ void printAST(const Node& node, int level) {
         case NodeType::READ:
             cout << "READ";
             break;
+        case NodeType::BINARY_EXPRESSION:
+            cout << "BINARY_EXPRESSION";
+            break;
+        case NodeType::UNARY_EXPRESSION:
+            cout << "UNARY_EXPRESSION";
+            break;
+        case NodeType::INDEX_EXPRESSION:
+            cout << "INDEX_EXPRESSION";
+            break;
+        case NodeType::CALL_EXPRESSION:
+            cout << "CALL_EXPRESSION";
+            break;
         // Add cases for other node types as needed
     }
 
-    cout << ", Lexeme: " << node.token.lexeme << ", Line: " << node.token.line << endl;
+    cout << ", Lexeme: " << node.token.lexeme;
+    if (lines) {
+        SourceLocation location = lines->locate(node.token.offset);
+        cout << ", Line: " << location.line << ", Column: " << location.column << endl;
+    } else {
+        cout << ", Offset: " << node.token.offset << endl;
+    }
+}
 
-    for (const auto& child : node.children) {
-        printAST(child, level + 1);
+// Walks the tree with an explicit stack, so deep nesting cannot overflow the call stack
+void printAST(const Node& node, int level, const LineTable* lines) {
+    vector<pair<const Node*, int>> stack = { { &node, level } };
+    while (!stack.empty()) {
+        auto [current, currentLevel] = stack.back();
+        stack.pop_back();
+        printNode(*current, currentLevel, lines);
+        // Children are pushed last to first so they print in order
+        for (size_t i = current->children.size(); i > 0; --i) {
+            stack.push_back({ &current->children[i - 1], currentLevel + 1 });
+        }
     }
 }
 
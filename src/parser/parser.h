@@ -1,6 +1,8 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <initializer_list>
+#include <memory>
 #include <vector>
 #include <stdexcept>
 #include "../tokenizer/tokenizer.h"  
@@ -18,49 +20,316 @@ enum class NodeType {
     WHILE_LOOP,
     DO_WHILE_LOOP,
     IDENTIFIER,
-    BLOCK
+    BLOCK,
+    BINARY_EXPRESSION,  // token: operator, children: left and right operands
+    UNARY_EXPRESSION,   // token: operator, children: operand
+    INDEX_EXPRESSION,   // token: "[", children: array and index
+    CALL_EXPRESSION,    // token: "(", children: callee, then the arguments
     // Add other necessary node types
 };
 
+struct Node;
+
+// A node's children: a contiguous run of nodes owned by an AstArena
+class NodeList {
+public:
+    NodeList() : first(nullptr), count(0) {}
+    NodeList(Node* first, size_t count) : first(first), count(static_cast<uint32_t>(count)) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Node& operator[](size_t index) const;
+    Node& back() const;
+    Node* begin() const { return first; }
+    Node* end() const;
+
+private:
+    Node* first;
+    uint32_t count;
+};
+
 // AST Node structure
+// Copying a Node is shallow: the copy shares its children with the original.
 struct Node {
     NodeType type;
-    std::vector<Node> children;
+    NodeList children;
     Token token;
 
     Node(NodeType type, Token token) : type(type), token(token) {}
 };
 
+inline Node& NodeList::operator[](size_t index) const { return first[index]; }
+inline Node& NodeList::back() const { return first[count - 1]; }
+inline Node* NodeList::end() const { return first + count; }
+
+// Bump allocator that owns every node of a tree. Nodes are carved out of large
+// blocks and never freed one by one; destroying the arena frees the whole tree.
+class AstArena {
+public:
+    AstArena() : current(nullptr), remaining(0), nodes(0) {}
+    AstArena(AstArena&& other) noexcept;
+    AstArena& operator=(AstArena&& other) noexcept;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    // Copy `count` nodes into the arena as one child list
+    NodeList copy(const Node* source, size_t count);
+
+    // Free every node, keeping the block in use for the nodes that follow
+    void clear();
+
+    // Take over every node of `other`; the nodes stay where they are
+    void adopt(AstArena&& other);
+
+    size_t nodeCount() const { return nodes; }
+    size_t blockCount() const { return blocks.size(); }
+
+private:
+    static constexpr size_t blockNodes = 1024;
+
+    struct BlockDeleter {
+        void operator()(Node* block) const { ::operator delete(block); }
+    };
+
+    Node* allocateBlock(size_t count);
+
+    std::vector<std::unique_ptr<Node, BlockDeleter>> blocks;
+    Node* current;  // free space in the newest regular block
+    size_t remaining;
+    size_t nodes;
+};
+
+// One node of a FlatAst
+struct FlatNode {
+    NodeType type;
+    uint32_t token;        // index into the FlatAst's token table
+    uint32_t subtreeSize;  // this node plus all of its descendants
+};
+
+class FlatAst;
+struct FlatNodeRef;
+
+// Children of a FlatAst node; stepping to the next sibling skips a whole subtree
+class FlatChildren {
+public:
+    class iterator {
+    public:
+        iterator(const FlatAst* ast, uint32_t index) : ast(ast), index(index) {}
+        FlatNodeRef operator*() const;
+        iterator& operator++();
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        const FlatAst* ast;
+        uint32_t index;
+    };
+
+    FlatChildren(const FlatAst* ast, uint32_t parent) : ast(ast), parent(parent) {}
+
+    size_t size() const;
+    bool empty() const { return !(begin() != end()); }
+    FlatNodeRef operator[](size_t index) const;  // walks past `index` siblings
+    iterator begin() const { return iterator(ast, parent + 1); }
+    iterator end() const;
+
+private:
+    const FlatAst* ast;
+    uint32_t parent;
+};
+
+// Read-only view of one FlatAst node with the same members as Node, so code
+// written against Node's fields can walk either form
+struct FlatNodeRef {
+    NodeType type;
+    const Token& token;
+    FlatChildren children;
+};
+
+// The AST as one pre-order array: every node is followed by its subtrees, and its
+// subtreeSize says where its next sibling starts. Tokens sit in a side table, so a
+// walk that only looks at node types stays within 12 bytes per node.
+class FlatAst {
+public:
+    // Flatten a tree; the result does not refer to the tree's arena
+    static FlatAst fromTree(const Node& root);
+
+    // Rebuild the tree, allocating its nodes in `arena`
+    Node toTree(AstArena& arena) const;
+
+    size_t size() const { return nodes.size(); }
+    const FlatNode& node(size_t index) const { return nodes[index]; }
+    const Token& token(size_t index) const { return tokens[nodes[index].token]; }
+    FlatNodeRef at(size_t index) const;
+    FlatNodeRef root() const { return at(0); }
+
+private:
+    std::vector<FlatNode> nodes;
+    std::vector<Token> tokens;
+};
+
+// A syntax error: its message, with line and column when the source is known, and
+// the byte offset of the offending token
+struct Diagnostic {
+    std::string message;
+    uint32_t offset;
+};
+
+// Thrown for syntax errors; still a runtime_error for callers that catch those
+class ParseError : public std::runtime_error {
+public:
+    explicit ParseError(const Diagnostic& diagnostic)
+        : std::runtime_error(diagnostic.message), diagnostic(diagnostic) {}
+
+    Diagnostic diagnostic;
+};
+
+// Receives statements from Parser::parse(StatementSink&) as they are recognized, for
+// translating without building a tree. Nodes are only valid during the call.
+class StatementSink {
+public:
+    virtual ~StatementSink() = default;
+
+    // A complete Declare, Assign, Read, Print or Function statement
+    virtual void statement(const Node& node) = 0;
+    // An If, For, While or Do whose body follows; its children are the header only, as
+    // in the tree form but without the blocks
+    virtual void open(const Node& header) = 0;
+    // The Else and the End of the innermost open statement; only the type and token
+    // of `statement` are set by now, except that a Do's closing While brings its
+    // condition as the only child
+    virtual void elseBranch(const Node& statement) = 0;
+    virtual void close(const Node& statement, bool hasElse) = 0;
+};
+
+// Statement-level terminals of the grammar in parser.cpp
+enum class Terminal : uint8_t;
+
 // Parser class
 class Parser {
 private:
-    std::vector<Token> tokens;
-    size_t currentPos;
+    std::vector<Token> tokens;  // only filled when the parser was handed a vector to own
+    const std::vector<Token>* tokenVector = nullptr;  // the vector read from, if there is one
+    TokenStream stream;
     Token currentToken;
+    std::string_view source;  // empty when the tokens came without their source
+    LineTable lines;  // only built if an error needs a line number
+    AstArena arena;  // owns every node returned by parse()
+    std::vector<Node> pending;  // children of the nodes still being parsed
+    std::vector<Diagnostic>* diagnostics = nullptr;  // set while parsing with error recovery
+    StatementSink* sink = nullptr;  // set while streaming statements instead of building a tree
 
 public:
-    Parser(std::vector<Token> tokens);
+    // Pass the source the tokens were read from to get line numbers in errors.
+    // An lvalue vector is read in place and must outlive the parser; an rvalue is
+    // moved in. Neither copies the tokens.
+    Parser(const std::vector<Token>& tokens, std::string_view source = {});
+    Parser(std::vector<Token>&& tokens, std::string_view source = {});
+
+    // Pull tokens straight from the tokenizer instead of a materialized vector
+    Parser(Tokenizer& tokenizer);
+
+    // Read tokens from compact storage; the store must outlive the parser
+    Parser(const TokenStore& store);
+
+    // Parses tokens[first, last) of a vector as a whole program; parseParallel() runs
+    // one per chunk. The vector must outlive the parser.
+    Parser(const std::vector<Token>& tokens, size_t first, size_t last);
+
+    // The token stream points into this object, so a Parser is not copyable
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
 
     // Function to parse the tokens and build the AST
+    // The nodes live in this parser's arena: keep the parser alive, or take the arena.
     Node parse();
 
+    // Parse without stopping at the first error: each syntax error is appended to
+    // `diagnostics` and parsing resumes at the next statement. The tree holds the
+    // statements that parsed cleanly; it is empty of code only if all of them failed.
+    Node parse(std::vector<Diagnostic>& diagnostics);
+
+    // Hand each statement to `sink` as soon as it is parsed and build no tree: memory
+    // stays bounded by the nesting depth and the largest single statement
+    void parse(StatementSink& sink);
+
+    // Same tree as parse(), with top-level statements parsed on up to threadCount
+    // threads. A pre-scan matches If/For/While/Do to their closer to find where top-level
+    // statements start, and the token vector is cut there into chunks of at least
+    // minChunkTokens. Falls back to parse() when the tokens did not come as a vector
+    // or the input is too small to split; on a syntax error the serial parse runs, so
+    // the error is the serial one too.
+    Node parseParallel(size_t threadCount, size_t minChunkTokens = 1 << 14);
+
+    // Parse and flatten the result into pre-order form
+    FlatAst parseFlat() { return FlatAst::fromTree(parse()); }
+
+    // Hand over the arena holding the parsed nodes
+    AstArena takeArena() { return std::move(arena); }
+
 private:
+    // An If, For, While or Do whose body is still being parsed
+    struct OpenStatement {
+        Node node;         // IF_STATEMENT, FOR_LOOP, WHILE_LOOP or DO_WHILE_LOOP
+        size_t mark;       // where the node's children start on `pending`
+        Node block;        // the BLOCK now collecting statements
+        size_t blockMark;  // where the block's statements start on `pending`
+        bool inElse;       // an If that has moved on to its Else block
+        bool broken;       // the header failed to parse: the body is checked, then dropped
+        bool chained;      // an If opened by Else If, closed by its parent's End If
+    };
+
     Node parseStatements();
-    Node parseStatement();
+    void parseStatement(std::vector<OpenStatement>& open);
+    Node parseSimpleStatement(NodeType type);
     Node parseDeclaration();
     Node parseFunctionDeclaration();
     Node parseAssignment();
     Node parseExpression();
+    Node parseBinary(int minPrecedence);
+    Node parseUnary();
+    Node parsePostfix();
+    Node parsePrimary();
+    Node makeNode(NodeType type, Token token, std::initializer_list<Node> children);
     Node parsePrint();
-    Node parseIf();
-    Node parseFor();
-    Node parseWhile();
+    Node parseRead();
+    Node parseLoopStart();
 
-    void release(TokenType expectedType);
+    void enterElse(OpenStatement& statement, Token elseToken);
+    void closeBlock(OpenStatement& statement);
+    void closeStatement(std::vector<OpenStatement>& open);
+    void streamOpen(OpenStatement& statement);
+    void synchronize(uint32_t statementStart);
+
+    Token expect(Terminal terminal);
     Token consume(TokenType expectedType);
+    Token consume(TokenType expectedType, std::string_view expectedLexeme);
+    bool isPunctuation(std::string_view lexeme) const;
+
+    // Move pending[mark...] into the arena as one child list
+    NodeList closeChildren(size_t mark);
+    std::string where(const Token& token) const;
+
+    // Syntax errors: fail() always throws; report() records the error and returns
+    // when recovering, so the caller can repair locally and carry on
+    Diagnostic unexpected(const Token& token, std::string_view expected = {}) const;
+    [[noreturn]] void fail(const Diagnostic& diagnostic) const;
+    void report(const Diagnostic& diagnostic);
 };
 
-// Function to print the AST
-void printAST(const Node& node, int level = 0);
+// C++ spelling of a pseudocode operator: "=" in an expression is a comparison, so it
+// becomes "=="; "<>", "And", "Or" and "Not" become "!=", "&&", "||" and "!"
+std::string_view canonicalOperator(std::string_view op);
+
+// Binding strength of a canonical binary operator, higher binds tighter; 0 if `op`
+// is not a binary operator
+int binaryPrecedence(std::string_view op);
+
+// Indentation stops growing past this depth in printed trees and generated code, so
+// very deep nesting still prints in linear time
+constexpr int maxIndentLevel = 64;
+
+// Function to print the AST; token positions are shown as line and column when
+// `lines` is given, as byte offsets otherwise
+void printAST(const Node& node, int level = 0, const LineTable* lines = nullptr);
 
 #endif // PARSER_H
@@ -0,0 +1,443 @@
+#include "semantic.h"
+#include <algorithm>
+
+using namespace std;
+
+// ----------------------------------------------------------------------------------
+// SymbolTable
+
+SymbolTable::SymbolTable() : slots(16, { 0, -1 }), used(0) {}
+
+// Fibonacci hashing: identifier ids are dense, so spread them with a multiply
+static size_t slotOf(uint32_t key, size_t mask) {
+    return static_cast<size_t>((uint64_t(key) * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+void SymbolTable::pushScope() {
+    scopeStarts.push_back(symbols.size());
+}
+
+void SymbolTable::popScope() {
+    for (size_t index = symbols.size(); index > scopeStarts.back(); --index) {
+        slots[indexOf(keys[index - 1])].symbol = symbols[index - 1].shadowed;
+    }
+    symbols.resize(scopeStarts.back());
+    keys.resize(scopeStarts.back());
+    scopeStarts.pop_back();
+}
+
+const Symbol* SymbolTable::lookup(uint32_t key) const {
+    size_t index = indexOf(key);
+    return index != notFound && slots[index].symbol >= 0 ? &symbols[slots[index].symbol] : nullptr;
+}
+
+const Symbol* SymbolTable::declare(uint32_t key, const Token& name, SymbolType type) {
+    Slot& slot = find(key);
+    if (slot.symbol >= 0 && symbols[slot.symbol].scope == depth()) {
+        return &symbols[slot.symbol];
+    }
+    symbols.push_back({ name, type, depth(), slot.symbol });
+    keys.push_back(key);
+    slot.symbol = static_cast<int32_t>(symbols.size() - 1);
+    return nullptr;
+}
+
+SymbolTable::Slot& SymbolTable::find(uint32_t key) {
+    if ((used + 1) * 2 > slots.size()) {
+        grow();
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t index = slotOf(key, mask);; index = (index + 1) & mask) {
+        if (slots[index].key == key + 1) {
+            return slots[index];
+        }
+        if (slots[index].key == 0) {
+            used++;
+            slots[index] = { key + 1, -1 };
+            return slots[index];
+        }
+    }
+}
+
+size_t SymbolTable::indexOf(uint32_t key) const {
+    size_t mask = slots.size() - 1;
+    for (size_t index = slotOf(key, mask);; index = (index + 1) & mask) {
+        if (slots[index].key == key + 1) {
+            return index;
+        }
+        if (slots[index].key == 0) {
+            return notFound;
+        }
+    }
+}
+
+void SymbolTable::grow() {
+    vector<Slot> old = move(slots);
+    slots.assign(old.size() * 2, { 0, -1 });
+    size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.key != 0) {
+            size_t index = slotOf(slot.key - 1, mask);
+            while (slots[index].key != 0) {
+                index = (index + 1) & mask;
+            }
+            slots[index] = slot;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------
+// SemanticAnalyzer
+
+static constexpr SymbolType integerType = { ValueType::INTEGER, 0 };
+static constexpr SymbolType stringType = { ValueType::STRING, 0 };
+static constexpr SymbolType booleanType = { ValueType::BOOLEAN, 0 };
+static constexpr SymbolType errorType = { ValueType::ERROR, 0 };
+
+string typeName(SymbolType type) {
+    string name = type.element == ValueType::INTEGER ? "Integer" :
+                  type.element == ValueType::STRING ? "String" :
+                  type.element == ValueType::BOOLEAN ? "Boolean" :
+                  type.element == ValueType::FUNCTION ? "Function" : "unknown";
+    if (type.dimensions == 0) {
+        return name;
+    }
+    name = "Array Of " + name;
+    for (int dimension = 0; dimension < type.dimensions; dimension++) {
+        name += "[]";
+    }
+    return name;
+}
+
+SemanticAnalyzer::SemanticAnalyzer(string_view source) : source(source), lines(source) {}
+
+vector<Diagnostic> SemanticAnalyzer::analyze(const Node& program) {
+    diagnostics.clear();
+    symbols = SymbolTable();
+    vector<Work> work;
+    pushStatements(program, work);
+    while (!work.empty()) {
+        Work item = work.back();
+        work.pop_back();
+        switch (item.kind) {
+            case Work::STATEMENT:
+                checkStatement(*item.node, work);
+                break;
+            case Work::OPEN_SCOPE:
+                symbols.pushScope();
+                break;
+            case Work::CLOSE_SCOPE:
+                symbols.popScope();
+                break;
+            case Work::CONDITION:
+                expectType(*item.node, ValueType::BOOLEAN, "Condition");
+                break;
+        }
+    }
+    return move(diagnostics);
+}
+
+// Pushes a block's statements so that the first one is popped first
+void SemanticAnalyzer::pushStatements(const Node& block, vector<Work>& work) {
+    for (size_t index = block.children.size(); index > 0; --index) {
+        work.push_back({ Work::STATEMENT, &block.children[index - 1] });
+    }
+}
+
+// Simple statements are checked here; compound ones check their header and push their
+// blocks, each between an OPEN_SCOPE and a CLOSE_SCOPE, so nesting depth does not
+// grow the call stack
+void SemanticAnalyzer::checkStatement(const Node& node, vector<Work>& work) {
+    switch (node.type) {
+        case NodeType::DECLARATION:
+            checkDeclaration(node);
+            break;
+        case NodeType::FUNCTION_DECLARATION: {
+            const Token& name = node.children[0].token;
+            if (const Symbol* first = symbols.declare(keyOf(name), name, { ValueType::FUNCTION, 0 })) {
+                error(name, "Redeclared name: " + string(name.lexeme), "first declared" + where(first->name));
+            }
+            break;
+        }
+        case NodeType::ASSIGNMENT:
+            checkAssignment(node);
+            break;
+        case NodeType::PRINT:
+        case NodeType::READ:
+            checkVariables(node);
+            break;
+        case NodeType::IF_STATEMENT:
+            expectType(node.children[0], ValueType::BOOLEAN, "Condition");
+            // Pushed in reverse: then block, then the optional else block
+            if (node.children.size() > 2) {
+                work.push_back({ Work::CLOSE_SCOPE, &node });
+                pushStatements(node.children[2], work);
+                work.push_back({ Work::OPEN_SCOPE, &node });
+            }
+            work.push_back({ Work::CLOSE_SCOPE, &node });
+            pushStatements(node.children[1], work);
+            work.push_back({ Work::OPEN_SCOPE, &node });
+            break;
+        case NodeType::FOR_LOOP: {
+            // children[0] is the start assignment: iterator, "=", start expression
+            const Node& start = node.children[0];
+            expectType(start.children[2], ValueType::INTEGER, "Loop start");
+            symbols.pushScope();
+            const Token& iterator = start.children[0].token;
+            symbols.declare(keyOf(iterator), iterator, integerType);
+            expectType(node.children[1], ValueType::INTEGER, "Loop end");
+            work.push_back({ Work::CLOSE_SCOPE, &node });
+            pushStatements(node.children[2], work);
+            break;
+        }
+        case NodeType::WHILE_LOOP:
+            expectType(node.children[0], ValueType::BOOLEAN, "Condition");
+            work.push_back({ Work::CLOSE_SCOPE, &node });
+            pushStatements(node.children[1], work);
+            work.push_back({ Work::OPEN_SCOPE, &node });
+            break;
+        case NodeType::DO_WHILE_LOOP:
+            // The condition follows the body, outside its scope
+            work.push_back({ Work::CONDITION, &node.children[0] });
+            work.push_back({ Work::CLOSE_SCOPE, &node });
+            pushStatements(node.children[1], work);
+            work.push_back({ Work::OPEN_SCOPE, &node });
+            break;
+        default:
+            break;
+    }
+}
+
+// children: name and type, or name, "Array", element type and one or two sizes
+void SemanticAnalyzer::checkDeclaration(const Node& node) {
+    const Token& name = node.children[0].token;
+    const Token& typeToken = node.children[1].token;
+    bool isArray = typeToken.type == TokenType::ARRAY;
+    const Token& elementToken = isArray ? node.children[2].token : typeToken;
+
+    SymbolType type = { ValueType::ERROR, static_cast<uint8_t>(isArray ? node.children.size() - 3 : 0) };
+    switch (elementToken.type) {
+        case TokenType::INTEGER:
+            type.element = ValueType::INTEGER;
+            break;
+        case TokenType::STRING:
+            type.element = ValueType::STRING;
+            break;
+        case TokenType::BOOLEAN:
+            type.element = ValueType::BOOLEAN;
+            break;
+        default:
+            error(elementToken, "Unknown type: " + string(elementToken.lexeme));
+    }
+    for (size_t index = 3; isArray && index < node.children.size(); index++) {
+        const Token& size = node.children[index].token;
+        if (all_of(size.lexeme.begin(), size.lexeme.end(), [](char digit) { return digit == '0'; })) {
+            error(size, "Array size must be positive: " + string(name.lexeme));
+        }
+    }
+
+    if (const Symbol* first = symbols.declare(keyOf(name), name, type)) {
+        error(name, "Redeclared variable: " + string(name.lexeme), "first declared" + where(first->name));
+    }
+}
+
+// children: target, its indices, the "=" operator and the value expression
+void SemanticAnalyzer::checkAssignment(const Node& node) {
+    size_t operatorIndex = 1;
+    while (operatorIndex < node.children.size() && node.children[operatorIndex].token.type != TokenType::OPERATOR) {
+        checkIndex(node.children[operatorIndex]);
+        operatorIndex++;
+    }
+    const Node& target = node.children[0];
+    SymbolType targetType = variableType(target, operatorIndex - 1);
+    SymbolType valueType = expressionType(node.children[operatorIndex + 1]);
+    if (targetType.element != ValueType::ERROR && valueType.element != ValueType::ERROR && targetType != valueType) {
+        error(target.token, "Type mismatch: cannot assign " + typeName(valueType) + " to " + typeName(targetType) + " " +
+                                string(target.token.lexeme));
+    }
+}
+
+// Print and Read items: variables with their indices as children, or literals
+void SemanticAnalyzer::checkVariables(const Node& node) {
+    for (const Node& item : node.children) {
+        if (item.token.type != TokenType::IDENTIFIER) {
+            continue;
+        }
+        for (const Node& index : item.children) {
+            checkIndex(index);
+        }
+        SymbolType type = variableType(item, item.children.size());
+        if (type.dimensions > 0) {
+            error(item.token, "Missing index for array: " + string(item.token.lexeme));
+        }
+    }
+}
+
+// An index written in a statement: a number or an Integer variable
+void SemanticAnalyzer::checkIndex(const Node& index) {
+    if (index.token.type != TokenType::IDENTIFIER) {
+        return;
+    }
+    SymbolType type = variableType(index, 0);
+    if (type.element != ValueType::ERROR && type != integerType) {
+        error(index.token, "Index is " + typeName(type) + ", expected Integer");
+    }
+}
+
+// Type of a variable with `indexCount` indices applied; reports undeclared names
+SymbolType SemanticAnalyzer::variableType(const Node& variable, size_t indexCount) {
+    const Token& name = variable.token;
+    const Symbol* symbol = symbols.lookup(keyOf(name));
+    if (!symbol) {
+        error(name, "Undeclared variable: " + string(name.lexeme));
+        return errorType;
+    }
+    if (symbol->type.element == ValueType::FUNCTION) {
+        error(name, "Not a variable: " + string(name.lexeme));
+        return errorType;
+    }
+    if (indexCount > symbol->type.dimensions) {
+        error(name, symbol->type.dimensions == 0 ? "Not an array: " + string(name.lexeme) :
+                                                   "Too many indices for " + string(name.lexeme));
+        return errorType;
+    }
+    return { symbol->type.element, static_cast<uint8_t>(symbol->type.dimensions - indexCount) };
+}
+
+// Works bottom-up with an explicit stack, so long operator chains (a left-deep tree)
+// cannot overflow the call stack
+SymbolType SemanticAnalyzer::expressionType(const Node& expression) {
+    const Node& root = expression.type == NodeType::EXPRESSION ? expression.children[0] : expression;
+    vector<pair<const Node*, bool>> stack = { { &root, false } };
+    vector<SymbolType> types;  // types of the operands finished so far
+    while (!stack.empty()) {
+        auto [node, visited] = stack.back();
+        stack.pop_back();
+        // A call's callee is a function name, not an operand
+        size_t firstOperand = node->type == NodeType::CALL_EXPRESSION ? 1 : 0;
+        if (!visited && node->children.size() > firstOperand) {
+            stack.push_back({ node, true });
+            for (size_t index = node->children.size(); index > firstOperand; --index) {
+                stack.push_back({ &node->children[index - 1], false });
+            }
+            continue;
+        }
+        size_t operandCount = node->children.size() - firstOperand;
+        SymbolType type = operandType(*node, types.data() + types.size() - operandCount);
+        types.resize(types.size() - operandCount);
+        types.push_back(type);
+    }
+    return types.back();
+}
+
+// Type of one expression node given its operands' types
+SymbolType SemanticAnalyzer::operandType(const Node& node, const SymbolType* operands) {
+    string_view op = node.token.lexeme;
+    switch (node.type) {
+        case NodeType::IDENTIFIER:
+            if (node.token.type == TokenType::NUMBER) {
+                return integerType;
+            }
+            if (node.token.type == TokenType::STRINGVAL) {
+                return stringType;
+            }
+            if ((op == "True" || op == "False") && !symbols.lookup(keyOf(node.token))) {
+                return booleanType;
+            }
+            return variableType(node, 0);
+
+        case NodeType::INDEX_EXPRESSION: {
+            SymbolType array = operands[0];
+            SymbolType index = operands[1];
+            if (index.element != ValueType::ERROR && index != integerType) {
+                error(node.token, "Index is " + typeName(index) + ", expected Integer");
+            }
+            if (array.element == ValueType::ERROR) {
+                return errorType;
+            }
+            if (array.dimensions == 0) {
+                error(node.token, "Indexing a " + typeName(array) + " value");
+                return errorType;
+            }
+            return { array.element, static_cast<uint8_t>(array.dimensions - 1) };
+        }
+
+        case NodeType::CALL_EXPRESSION: {
+            // Functions carry no signature, so the result is left unknown
+            const Token& callee = node.children[0].token;
+            const Symbol* symbol = callee.type == TokenType::IDENTIFIER ? symbols.lookup(keyOf(callee)) : nullptr;
+            if (!symbol) {
+                error(callee, "Undeclared function: " + string(callee.lexeme));
+            } else if (symbol->type.element != ValueType::FUNCTION) {
+                error(callee, "Not a function: " + string(callee.lexeme));
+            }
+            return errorType;
+        }
+
+        case NodeType::UNARY_EXPRESSION: {
+            SymbolType expected = op == "!" ? booleanType : integerType;
+            if (operands[0].element != ValueType::ERROR && operands[0] != expected) {
+                error(node.token, "Type mismatch: " + string(op) + " on " + typeName(operands[0]));
+            }
+            return expected;
+        }
+
+        case NodeType::BINARY_EXPRESSION: {
+            SymbolType left = operands[0];
+            SymbolType right = operands[1];
+            bool arithmetic = op == "-" || op == "*" || op == "/";
+            bool ordering = op == "<" || op == ">" || op == "<=" || op == ">=";
+            bool logical = op == "&&" || op == "||";
+            SymbolType result = arithmetic ? integerType : op == "+" ? left : booleanType;
+            if (left.element == ValueType::ERROR || right.element == ValueType::ERROR) {
+                return op == "+" ? errorType : result;
+            }
+
+            bool valid = left == right && left.dimensions == 0;
+            if (arithmetic) {
+                valid = valid && left == integerType;
+            } else if (op == "+" || ordering) {
+                valid = valid && (left == integerType || left == stringType);
+            } else if (logical) {
+                valid = valid && left == booleanType;
+            }
+            if (!valid) {
+                error(node.token, "Type mismatch: " + typeName(left) + " " + string(op) + " " + typeName(right));
+                return op == "+" ? errorType : result;
+            }
+            return result;
+        }
+
+        default:
+            return errorType;
+    }
+}
+
+void SemanticAnalyzer::expectType(const Node& expression, ValueType expected, const string& what) {
+    SymbolType type = expressionType(expression);
+    if (type.element != ValueType::ERROR && type != SymbolType{ expected, 0 }) {
+        error(expression.token, what + " is " + typeName(type) + ", expected " + typeName({ expected, 0 }));
+    }
+}
+
+// Identifier ids come from the tokenizer; a token without one gets an id of its own
+// from the upper half of the range
+uint32_t SemanticAnalyzer::keyOf(const Token& name) {
+    return name.id != Token::noId ? name.id : (1u << 31) + unnamed.intern(name.lexeme);
+}
+
+string SemanticAnalyzer::where(const Token& token) const {
+    if (source.empty()) {
+        return "";
+    }
+    SourceLocation location = lines.locate(token.offset);
+    return " at line " + to_string(location.line) + ", column " + to_string(location.column);
+}
+
+void SemanticAnalyzer::error(const Token& token, const string& message, const string& detail) {
+    string text = message + where(token);
+    if (!detail.empty() && !source.empty()) {
+        text += ", " + detail;
+    }
+    diagnostics.push_back({ text, token.offset });
+}
@@ -0,0 +1,122 @@
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../parser/parser.h"
+
+// Types of the pseudocode language. An array is its element type plus a dimension
+// count; ERROR stands for an expression whose type could not be worked out, so one
+// mistake is reported once and not again by every expression around it.
+enum class ValueType : uint8_t {
+    INTEGER,
+    STRING,
+    BOOLEAN,
+    FUNCTION,
+    ERROR,
+};
+
+struct SymbolType {
+    ValueType element;
+    uint8_t dimensions;  // 0 for a scalar
+
+    bool operator==(const SymbolType& other) const { return element == other.element && dimensions == other.dimensions; }
+    bool operator!=(const SymbolType& other) const { return !(*this == other); }
+};
+
+// A declared name
+struct Symbol {
+    Token name;
+    SymbolType type;
+    uint32_t scope;     // nesting depth of the block that declared it
+    int32_t shadowed;   // symbol of the same name in an outer scope, or -1
+};
+
+// Names in scope, innermost first. Lookups go through a flat open-addressing table
+// keyed by identifier id that maps each name to its innermost symbol; a symbol
+// remembers the one it shadows, so closing a scope only touches the names that scope
+// declared. Names stay in the table once seen, which keeps probe chains intact
+// without tombstones.
+class SymbolTable {
+public:
+    SymbolTable();
+
+    void pushScope();
+    void popScope();
+    uint32_t depth() const { return static_cast<uint32_t>(scopeStarts.size()); }
+
+    // Innermost symbol named `key`, or nullptr
+    const Symbol* lookup(uint32_t key) const;
+
+    // Declare `name` in the current scope; returns the symbol it clashes with when the
+    // name is already declared in this same scope, and declares nothing then
+    const Symbol* declare(uint32_t key, const Token& name, SymbolType type);
+
+private:
+    struct Slot {
+        uint32_t key;     // identifier id + 1, or 0 for an empty slot
+        int32_t symbol;   // innermost symbol, or -1 when none is in scope
+    };
+
+    static constexpr size_t notFound = SIZE_MAX;
+
+    Slot& find(uint32_t key);  // adds the key if it is new
+    size_t indexOf(uint32_t key) const;  // notFound if the key was never added
+    void grow();
+
+    std::vector<Slot> slots;  // power-of-two size, at most half full
+    size_t used;
+    std::vector<Symbol> symbols;  // the symbols in scope, outermost first
+    std::vector<uint32_t> keys;   // keys[i] is the key of symbols[i]
+    std::vector<size_t> scopeStarts;  // where each open scope's symbols begin
+};
+
+// Semantic checks between parsing and code generation: every variable is declared
+// before use and at most once per scope, and assignments, operators, indices and
+// conditions get operands of the right type. Blocks of If, For, While and Do are
+// scopes as in the generated C++, and a For declares its loop variable as an
+// Integer local to the loop. Boolean values are written True and False.
+class SemanticAnalyzer {
+public:
+    // Pass the program's source to get line numbers in the messages
+    explicit SemanticAnalyzer(std::string_view source = {});
+
+    // Check `program` (the root returned by Parser::parse) and return every error
+    // found, in program order; empty when the program is fine
+    std::vector<Diagnostic> analyze(const Node& program);
+
+private:
+    // Pending work of the walk, which keeps its own stack like the code generator
+    struct Work {
+        enum Kind { STATEMENT, OPEN_SCOPE, CLOSE_SCOPE, CONDITION };
+        Kind kind;
+        const Node* node;  // the statement, or the condition of a Do checked after its body
+    };
+
+    void checkStatement(const Node& node, std::vector<Work>& work);
+    void checkDeclaration(const Node& node);
+    void checkAssignment(const Node& node);
+    void checkVariables(const Node& node);
+    void checkIndex(const Node& index);
+    void pushStatements(const Node& block, std::vector<Work>& work);
+    SymbolType variableType(const Node& variable, size_t indexCount);
+    SymbolType expressionType(const Node& expression);
+    SymbolType operandType(const Node& node, const SymbolType* operands);
+    void expectType(const Node& expression, ValueType expected, const std::string& what);
+
+    uint32_t keyOf(const Token& name);
+    std::string where(const Token& token) const;
+    void error(const Token& token, const std::string& message, const std::string& detail = "");
+
+    std::string_view source;
+    LineTable lines;
+    SymbolTable symbols;
+    IdentifierTable unnamed;  // ids for identifiers that came without one
+    std::vector<Diagnostic> diagnostics;
+};
+
+// Pseudocode spelling of a type, such as "Integer" or "Array Of String[][]"
+std::string typeName(SymbolType type);
+
+#endif // SEMANTIC_H
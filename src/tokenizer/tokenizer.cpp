@@ -1,117 +1,594 @@
 #include "tokenizer.h"
+#include "../common/parallelFor.h"
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
 // #include <cctype>
 
-vector<Token> Tokenizer::tokenize() {
+// ----------------------------------------------------------------------------------
+// Keyword recognition
+//
+// Identifiers are classified through a perfect hash generated at compile time:
+// buildKeywordTable() searches for a multiplier that puts every keyword in its own
+// slot, so a lookup is one hash plus at most one comparison. To add a keyword, add a
+// row to `keywords`; the static_assert fires if the new set needs a bigger table.
+
+static constexpr Keyword keywords[] = {
+    { "Declare", TokenType::DECLARE },
+    { "Assign", TokenType::ASSIGN },
+    { "Function", TokenType::FUNCTION },
+    { "Integer", TokenType::INTEGER },
+    { "String", TokenType::STRING },
+    { "Boolean", TokenType::BOOLEAN },
+    { "As", TokenType::KEYWORD },
+    { "Of", TokenType::KEYWORD },
+    { "Then", TokenType::KEYWORD },
+    { "To", TokenType::KEYWORD },
+    { "Do", TokenType::KEYWORD },
+    { "Array", TokenType::ARRAY },
+    { "Read", TokenType::READ },
+    { "Print", TokenType::PRINT },
+    { "If", TokenType::IF },
+    { "Else", TokenType::ELSE },
+    { "For", TokenType::FOR },
+    { "While", TokenType::WHILE },
+    { "End", TokenType::END },
+    { "And", TokenType::OPERATOR },
+    { "Or", TokenType::OPERATOR },
+    { "Not", TokenType::OPERATOR },
+};
+
+static constexpr size_t keywordCount = sizeof(keywords) / sizeof(keywords[0]);
+static constexpr size_t keywordTableSize = 64;  // power of two
+
+static constexpr char toLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static constexpr bool equalsIgnoreCase(string_view a, string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (toLowerAscii(a[i]) != toLowerAscii(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Hash of length, first two and last character; case-insensitive so one table serves both modes
+static constexpr size_t keywordSlot(string_view word, uint32_t seed) {
+    uint32_t second = word.size() > 1 ? toLowerAscii(word[1]) : 0;
+    uint32_t h = (toLowerAscii(word.front()) + second * 31u +
+                  toLowerAscii(word.back()) * 961u + static_cast<uint32_t>(word.size())) * seed;
+    return (h >> 16) & (keywordTableSize - 1);
+}
+
+struct KeywordTable {
+    uint32_t seed;  // 0 when no collision-free seed was found
+    size_t minLength;
+    size_t maxLength;
+    int8_t slots[keywordTableSize];  // index into keywords, or -1 for an empty slot
+};
+
+static constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table{ 0, keywords[0].text.size(), keywords[0].text.size(), {} };
+    for (size_t i = 0; i < keywordCount; i++) {
+        table.minLength = keywords[i].text.size() < table.minLength ? keywords[i].text.size() : table.minLength;
+        table.maxLength = keywords[i].text.size() > table.maxLength ? keywords[i].text.size() : table.maxLength;
+    }
+
+    for (uint32_t seed = 1; seed < 100000; seed++) {
+        for (size_t slot = 0; slot < keywordTableSize; slot++) {
+            table.slots[slot] = -1;
+        }
+        bool collision = false;
+        for (size_t i = 0; i < keywordCount && !collision; i++) {
+            size_t slot = keywordSlot(keywords[i].text, seed);
+            if (table.slots[slot] != -1) {
+                collision = true;
+            } else {
+                table.slots[slot] = static_cast<int8_t>(i);
+            }
+        }
+        if (!collision) {
+            table.seed = seed;
+            return table;
+        }
+    }
+    return table;
+}
+
+static constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.seed != 0, "no collision-free keyword hash, increase keywordTableSize");
+
+TokenType Tokenizer::classifyIdentifier(string_view identifier) const {
+    if (identifier.size() < keywordTable.minLength || identifier.size() > keywordTable.maxLength) {
+        return TokenType::IDENTIFIER;
+    }
+    int8_t index = keywordTable.slots[keywordSlot(identifier, keywordTable.seed)];
+    if (index < 0) {
+        return TokenType::IDENTIFIER;
+    }
+    const Keyword& keyword = keywords[index];
+    bool matches = ignoreKeywordCase ? equalsIgnoreCase(identifier, keyword.text) : identifier == keyword.text;
+    return matches ? keyword.type : TokenType::IDENTIFIER;
+}
+
+// ----------------------------------------------------------------------------------
+// Operator recognition
+//
+// Operators and punctuation are lexed by a DFA generated at compile time from
+// `operatorSpellings`: buildOperatorDfa() lays the spellings out as a trie over
+// character classes, so tokenizeOperator() takes the longest match ("<=" rather
+// than "<" then "=") with one table lookup per character. To add an operator, add
+// a row; every first character must be an operator on its own so that a match
+// always exists.
+
+struct OperatorSpelling {
+    string_view text;
+    TokenType type;
+};
+
+static constexpr OperatorSpelling operatorSpellings[] = {
+    { "+", TokenType::OPERATOR },
+    { "-", TokenType::OPERATOR },
+    { "*", TokenType::OPERATOR },
+    { "/", TokenType::OPERATOR },
+    { "=", TokenType::OPERATOR },
+    { ">", TokenType::OPERATOR },
+    { "<", TokenType::OPERATOR },
+    { "&", TokenType::OPERATOR },
+    { "|", TokenType::OPERATOR },
+    { "<=", TokenType::OPERATOR },
+    { ">=", TokenType::OPERATOR },
+    { "==", TokenType::OPERATOR },
+    { "&&", TokenType::OPERATOR },
+    { "||", TokenType::OPERATOR },
+    { "<>", TokenType::OPERATOR },
+    { "[", TokenType::PUNCTUATION },
+    { "]", TokenType::PUNCTUATION },
+    { "(", TokenType::PUNCTUATION },
+    { ")", TokenType::PUNCTUATION },
+    { ",", TokenType::PUNCTUATION },
+};
+
+static constexpr size_t operatorSpellingCount = sizeof(operatorSpellings) / sizeof(operatorSpellings[0]);
+static constexpr size_t operatorMaxStates = 32;
+static constexpr size_t operatorMaxClasses = 32;
+static constexpr uint8_t operatorNoAccept = 0xFF;
+
+struct OperatorDfa {
+    uint8_t charClass[256];  // 0 for characters that never appear in an operator
+    uint8_t next[operatorMaxStates][operatorMaxClasses];  // 0 means no transition
+    uint8_t accept[operatorMaxStates];  // TokenType, or operatorNoAccept
+    size_t stateCount;
+    size_t classCount;
+    bool everyFirstCharAccepts;
+};
+
+static constexpr OperatorDfa buildOperatorDfa() {
+    OperatorDfa dfa{ {}, {}, {}, 1, 1, true };
+    for (size_t state = 0; state < operatorMaxStates; state++) {
+        dfa.accept[state] = operatorNoAccept;
+    }
+
+    for (size_t i = 0; i < operatorSpellingCount; i++) {
+        size_t state = 0;
+        for (char c : operatorSpellings[i].text) {
+            uint8_t& charClass = dfa.charClass[static_cast<unsigned char>(c)];
+            if (charClass == 0) {
+                charClass = static_cast<uint8_t>(dfa.classCount++);
+            }
+            uint8_t& next = dfa.next[state][charClass];
+            if (next == 0) {
+                next = static_cast<uint8_t>(dfa.stateCount++);
+            }
+            state = next;
+        }
+        dfa.accept[state] = static_cast<uint8_t>(operatorSpellings[i].type);
+    }
+
+    for (size_t charClass = 1; charClass < dfa.classCount; charClass++) {
+        if (dfa.accept[dfa.next[0][charClass]] == operatorNoAccept) {
+            dfa.everyFirstCharAccepts = false;
+        }
+    }
+    return dfa;
+}
+
+static constexpr OperatorDfa operatorDfa = buildOperatorDfa();
+static_assert(operatorDfa.stateCount <= operatorMaxStates && operatorDfa.classCount <= operatorMaxClasses,
+              "operator DFA table too small, increase operatorMaxStates/operatorMaxClasses");
+static_assert(operatorDfa.everyFirstCharAccepts, "every operator character must be an operator on its own");
+
+// ----------------------------------------------------------------------------------
+// Character-run scanning
+//
+// Whitespace runs, identifier tails and string bodies are scanned 16 (SSE2) or 32
+// (AVX2) bytes at a time. Each scanner returns the position of the first byte that
+// does not belong to the run, or `size` if the run reaches the end of the input.
+// The character classes match isspace/isalnum in the "C" locale, so the SIMD and
+// scalar paths always agree. The AVX2 path is compiled with a target attribute and
+// picked at startup only if the CPU supports it.
+
+struct ScanFunctions {
+    size_t (*skipWhitespace)(const char* data, size_t size, size_t pos);
+    size_t (*findIdentifierEnd)(const char* data, size_t size, size_t pos);
+    size_t (*findQuote)(const char* data, size_t size, size_t pos);
+};
+
+static size_t skipWhitespaceScalar(const char* data, size_t size, size_t pos) {
+    while (pos < size && isspace(data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+static size_t findIdentifierEndScalar(const char* data, size_t size, size_t pos) {
+    while (pos < size && isalnum(data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+static size_t findQuoteScalar(const char* data, size_t size, size_t pos) {
+    while (pos < size && data[pos] != '"') {
+        pos++;
+    }
+    return pos;
+}
+
+#ifdef __SSE2__
+// Bytes in [low, low + span] map to 0xFF: the wrapped difference is at most span
+static inline __m128i inRange16(__m128i chunk, char low, char span) {
+    __m128i offset = _mm_sub_epi8(chunk, _mm_set1_epi8(low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
+
+static inline __m128i whitespaceMask16(__m128i chunk) {
+    // ' ' plus '\t', '\n', '\v', '\f', '\r'
+    return _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), inRange16(chunk, '\t', 4));
+}
+
+static inline __m128i alnumMask16(__m128i chunk) {
+    // Setting bit 5 folds 'A'-'Z' onto 'a'-'z' and leaves digits unchanged
+    __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    return _mm_or_si128(inRange16(chunk, '0', 9), inRange16(folded, 'a', 25));
+}
+
+static size_t skipWhitespaceSse2(const char* data, size_t size, size_t pos) {
+    while (pos + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned stop = ~_mm_movemask_epi8(whitespaceMask16(chunk)) & 0xFFFFu;
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 16;
+    }
+    return skipWhitespaceScalar(data, size, pos);
+}
+
+static size_t findIdentifierEndSse2(const char* data, size_t size, size_t pos) {
+    for (size_t limit = pos + 8; pos < limit; pos++) {
+        if (pos >= size || !isalnum(data[pos])) {
+            return pos;
+        }
+    }
+    while (pos + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned stop = ~_mm_movemask_epi8(alnumMask16(chunk)) & 0xFFFFu;
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 16;
+    }
+    return findIdentifierEndScalar(data, size, pos);
+}
+
+static size_t findQuoteSse2(const char* data, size_t size, size_t pos) {
+    while (pos + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned stop = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 16;
+    }
+    return findQuoteScalar(data, size, pos);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i inRange32(__m256i chunk, char low, char span) {
+    __m256i offset = _mm256_sub_epi8(chunk, _mm256_set1_epi8(low));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(span)), offset);
+}
+
+__attribute__((target("avx2")))
+static size_t skipWhitespaceAvx2(const char* data, size_t size, size_t pos) {
+    while (pos + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i mask = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), inRange32(chunk, '\t', 4));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(mask));
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 32;
+    }
+    return skipWhitespaceSse2(data, size, pos);
+}
+
+__attribute__((target("avx2")))
+static size_t findIdentifierEndAvx2(const char* data, size_t size, size_t pos) {
+    // Most identifiers are short, so try a few bytes scalar before paying for a vector load
+    for (size_t limit = pos + 8; pos < limit; pos++) {
+        if (pos >= size || !isalnum(data[pos])) {
+            return pos;
+        }
+    }
+    while (pos + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        __m256i mask = _mm256_or_si256(inRange32(chunk, '0', 9), inRange32(folded, 'a', 25));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(mask));
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 32;
+    }
+    return findIdentifierEndSse2(data, size, pos);
+}
+
+__attribute__((target("avx2")))
+static size_t findQuoteAvx2(const char* data, size_t size, size_t pos) {
+    while (pos + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        unsigned stop = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))));
+        if (stop != 0) {
+            return pos + __builtin_ctz(stop);
+        }
+        pos += 32;
+    }
+    return findQuoteSse2(data, size, pos);
+}
+#endif
+
+static constexpr ScanFunctions scalarScan = { skipWhitespaceScalar, findIdentifierEndScalar, findQuoteScalar };
+
+static ScanFunctions selectScanFunctions() {
+#ifdef __SSE2__
+    // Runs from a static initializer, possibly before libgcc has filled in the CPU model
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { skipWhitespaceAvx2, findIdentifierEndAvx2, findQuoteAvx2 };
+    }
+    return { skipWhitespaceSse2, findIdentifierEndSse2, findQuoteSse2 };
+#else
+    return scalarScan;
+#endif
+}
+
+// Scanners used by the Tokenizer; benchmarks swap in scalarScan to compare paths
+static ScanFunctions activeScan = selectScanFunctions();
+
+// ----------------------------------------------------------------------------------
+
+Token Tokenizer::nextToken() {
     while (currentPos < input.size()) {
         char currentChar = input[currentPos];
 
         // Handle whitespace
         if (isspace(currentChar)) {
-            currentPos++;
+            currentPos = activeScan.skipWhitespace(input.data(), input.size(), currentPos + 1);
             continue;
         }
 
         // Handle digits (numbers)
         if (isdigit(currentChar)) {
-            tokenizeNumber();
-            continue;
+            return tokenizeNumber();
         }
 
         // Handle identifiers (keywords, variable names, function names)
         if (isalpha(currentChar)) {
-            tokenizeIdentifier();
-            continue;
+            return tokenizeIdentifier();
         }
 
-        // Handle operators and special characters
+        // Handle operators and punctuation
         if (isOperator(currentChar)) {
-            tokenizeOperator();
-            continue;
+            return tokenizeOperator();
         }
 
         // Handle strings (quoted text)
         if (currentChar == '"') {
-            tokenizeString();
-            continue;
+            return tokenizeString();
         }
 
         // Handle other cases (like keywords DECLARE, FUNCTION)
         tokenizeOther();
     }
 
-    // Add an end-of-file token
-    tokens.push_back({ TokenType::END_OF_FILE, "", -1 });
-    // tokens.push_back({ TokenType::END_OF_FILE, "", -1 });
+    // End-of-file token, returned again on every further call
+    return { TokenType::END_OF_FILE, "", static_cast<uint32_t>(input.size()) };
+}
+
+vector<Token> Tokenizer::tokenize() {
+    vector<Token> tokens;
+    Token token;
+    do {
+        token = nextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
 
     return tokens;
 }
 
-void Tokenizer::tokenizeNumber() {
-    size_t startPos = currentPos;
-    while (isdigit(input[currentPos])) {
-        currentPos++;
+TokenStore Tokenizer::tokenizeCompact() {
+    TokenStore store(input);
+    Token token;
+    do {
+        token = nextToken();
+        store.push(token);
+    } while (token.type != TokenType::END_OF_FILE);
+
+    // Give back the slack left by vector growth; the store is read-only from here on
+    store.shrinkToFit();
+    return store;
+}
+
+vector<Token> Tokenizer::tokenizeParallel(size_t threadCount, size_t minChunkBytes) {
+    string_view rest = input.substr(currentPos);
+    size_t chunkCount = min(threadCount * 4, rest.size() / max<size_t>(minChunkBytes, 1));
+    if (threadCount <= 1 || chunkCount <= 1) {
+        return tokenize();
+    }
+
+    // Cut roughly even chunks, each starting right after a newline
+    vector<size_t> cuts = { 0 };
+    for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+        size_t newline = rest.find('\n', max(rest.size() * chunk / chunkCount, cuts.back()));
+        if (newline == string_view::npos) {
+            break;
+        }
+        cuts.push_back(newline + 1);
+    }
+    cuts.push_back(rest.size());
+
+    // A string literal may span lines, and a cut inside one would tokenize its tail as
+    // code. Quotes only ever open or close strings, so a cut is inside a string exactly
+    // when an odd number of quotes precede it.
+    vector<size_t> quoteCounts(cuts.size() - 1);
+    parallelFor(quoteCounts.size(), threadCount, [&](size_t chunk) {
+        quoteCounts[chunk] = count(rest.begin() + cuts[chunk], rest.begin() + cuts[chunk + 1], '"');
+    });
+
+    // Move such cuts to the first newline outside a string; drop cuts they overtake
+    vector<size_t> bounds = { 0 };
+    size_t quotesBefore = 0;
+    for (size_t chunk = 1; chunk < cuts.size(); chunk++) {
+        quotesBefore += quoteCounts[chunk - 1];
+        size_t cut = cuts[chunk];
+        if (cut <= bounds.back()) {
+            continue;
+        }
+        bool insideString = quotesBefore % 2 == 1;
+        while (cut < rest.size() && (insideString || rest[cut - 1] != '\n')) {
+            insideString ^= rest[cut] == '"';
+            cut++;
+        }
+        if (cut < rest.size()) {
+            bounds.push_back(cut);
+        }
     }
-    string numberStr = input.substr(startPos, currentPos - startPos);
-    tokens.push_back({ TokenType::NUMBER, numberStr, -1 });
+    bounds.push_back(rest.size());
+
+    // Tokenize every chunk independently, each with its own identifier table
+    size_t chunks = bounds.size() - 1;
+    vector<Tokenizer> chunkTokenizers;
+    chunkTokenizers.reserve(chunks);
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        chunkTokenizers.emplace_back(rest.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk]), ignoreKeywordCase);
+    }
+    vector<vector<Token>> chunkTokens(chunks);
+    parallelFor(chunks, threadCount, [&](size_t chunk) {
+        for (Token token = chunkTokenizers[chunk].nextToken(); token.type != TokenType::END_OF_FILE;
+             token = chunkTokenizers[chunk].nextToken()) {
+            chunkTokens[chunk].push_back(token);
+        }
+    });
+
+    // Merging the tables in chunk order hands out ids in the serial first-use order
+    vector<vector<uint32_t>> remaps(chunks);
+    vector<size_t> firstToken(chunks + 1, 0);
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        remaps[chunk] = identifiers.merge(chunkTokenizers[chunk].identifiers);
+        firstToken[chunk + 1] = firstToken[chunk] + chunkTokens[chunk].size();
+    }
+
+    vector<Token> tokens(firstToken[chunks] + 1);
+    parallelFor(chunks, threadCount, [&](size_t chunk) {
+        Token* out = tokens.data() + firstToken[chunk];
+        uint32_t chunkStart = static_cast<uint32_t>(currentPos + bounds[chunk]);
+        for (const Token& token : chunkTokens[chunk]) {
+            *out = token;
+            out->offset += chunkStart;
+            if (token.id != Token::noId) {
+                out->id = remaps[chunk][token.id];
+            }
+            out++;
+        }
+    });
+    tokens.back() = { TokenType::END_OF_FILE, "", static_cast<uint32_t>(input.size()) };
+
+    currentPos = input.size();
+    return tokens;
 }
 
-void Tokenizer::tokenizeIdentifier() {
+Token Tokenizer::tokenizeNumber() {
     size_t startPos = currentPos;
-    while (isalnum(input[currentPos])) {
+    while (currentPos < input.size() && isdigit(input[currentPos])) {
         currentPos++;
     }
-    string identifier = input.substr(startPos, currentPos - startPos);
+    string_view numberStr = input.substr(startPos, currentPos - startPos);
+    return { TokenType::NUMBER, numberStr, static_cast<uint32_t>(startPos) };
+}
+
+Token Tokenizer::tokenizeIdentifier() {
+    size_t startPos = currentPos;
+    currentPos = activeScan.findIdentifierEnd(input.data(), input.size(), currentPos);
+    string_view identifier = input.substr(startPos, currentPos - startPos);
     // Check if the identifier matches known keywords
-    if (identifier == "Declare") {
-        tokens.push_back({ TokenType::DECLARE, identifier, -1 });
-    } else if (identifier == "Assign") {
-        tokens.push_back({ TokenType::ASSIGN, identifier, -1 });
-    } else if (identifier == "Function") {
-        tokens.push_back({ TokenType::FUNCTION, identifier, -1 });
-    } else if (identifier == "Integer") {
-        tokens.push_back({ TokenType::INTEGER, identifier, -1 });
-    } else if (identifier == "String") {
-        tokens.push_back({ TokenType::STRING, identifier, -1 });
-    } else if (identifier == "Boolean") {
-        tokens.push_back({ TokenType::BOOLEAN, identifier, -1 });
-    } else if (identifier == "As" || identifier == "Of" || identifier == "Then" || identifier == "To" || identifier == "Do") {
-        tokens.push_back({ TokenType::KEYWORD, identifier, -1 });
-    } else if (identifier == "Array") {
-        tokens.push_back({ TokenType::ARRAY, identifier, -1 });
-    } else if (identifier == "Read") {
-        tokens.push_back({ TokenType::READ, identifier, -1 });
-    } else if (identifier == "Print") {
-        tokens.push_back({ TokenType::PRINT, identifier, -1 });
-    } else if (identifier == "If") {
-        tokens.push_back({ TokenType::IF, identifier, -1 });
-    } else if (identifier == "Else") {
-        tokens.push_back({ TokenType::ELSE, identifier, -1 });
-    } else if (identifier == "For") {
-        tokens.push_back({ TokenType::FOR, identifier, -1 });
-    } else if (identifier == "While") {
-        tokens.push_back({ TokenType::WHILE, identifier, -1 });
-    } else if (identifier == "End") {
-        tokens.push_back({ TokenType::END, identifier, -1 });
-    } else {
-        tokens.push_back({ TokenType::IDENTIFIER, identifier, -1 });
-    }
-}
-
-void Tokenizer::tokenizeOperator() {
-    char currentChar = input[currentPos];
-    string op(1, currentChar);  // Convert char to string
-    tokens.push_back({ TokenType::OPERATOR, op, -1 });
-    currentPos++;
+    TokenType type = classifyIdentifier(identifier);
+    if (type == TokenType::ELSE) {
+        // "Else If" on one line is a single ELSE token, which the parser tells apart
+        // from an If nested at the start of an Else block on the next line
+        size_t next = currentPos;
+        while (next < input.size() && (input[next] == ' ' || input[next] == '\t')) {
+            next++;
+        }
+        if (next < input.size() && isalpha(static_cast<unsigned char>(input[next]))) {
+            size_t end = activeScan.findIdentifierEnd(input.data(), input.size(), next);
+            if (classifyIdentifier(input.substr(next, end - next)) == TokenType::IF) {
+                currentPos = end;
+                identifier = input.substr(startPos, end - startPos);
+            }
+        }
+    }
+    if (type != TokenType::IDENTIFIER) {
+        return { type, identifier, static_cast<uint32_t>(startPos) };
+    }
+    return { type, identifier, static_cast<uint32_t>(startPos), identifiers.intern(identifier) };
 }
 
-void Tokenizer::tokenizeString() {
-    size_t startPos = ++currentPos;  // Skip the opening quote
-    while (currentPos < input.size() && input[currentPos] != '"') {
-        currentPos++;
+Token Tokenizer::tokenizeOperator() {
+    // Maximal munch: follow the DFA as far as it goes, remembering the last accepting state
+    size_t startPos = currentPos;
+    size_t acceptEnd = startPos;
+    uint8_t acceptType = operatorNoAccept;
+    uint8_t state = 0;
+    for (size_t pos = startPos; pos < input.size(); pos++) {
+        state = operatorDfa.next[state][operatorDfa.charClass[static_cast<unsigned char>(input[pos])]];
+        if (state == 0) {
+            break;
+        }
+        if (operatorDfa.accept[state] != operatorNoAccept) {
+            acceptEnd = pos + 1;
+            acceptType = operatorDfa.accept[state];
+        }
     }
-    string strLiteral = input.substr(startPos, currentPos - startPos);
+    currentPos = acceptEnd;
+    return { static_cast<TokenType>(acceptType), input.substr(startPos, acceptEnd - startPos),
+             static_cast<uint32_t>(startPos) };
+}
+
+Token Tokenizer::tokenizeString() {
+    size_t startPos = ++currentPos;  // Skip the opening quote
+    currentPos = activeScan.findQuote(input.data(), input.size(), currentPos);
+    string_view strLiteral = input.substr(startPos, currentPos - startPos);
     currentPos++;  // Skip the closing quote
-    tokens.push_back({ TokenType::STRINGVAL, strLiteral, -1 });
+    return { TokenType::STRINGVAL, strLiteral, static_cast<uint32_t>(startPos) };
 }
 
 void Tokenizer::tokenizeOther() {
@@ -122,13 +599,187 @@ void Tokenizer::tokenizeOther() {
 }
 
 bool Tokenizer::isOperator(char c) {
-    // Define operators specific to your pseudocode syntax
-    // For example: +, -, *, /, :=, >, <, >=, <=, ==, !=, AND, OR, etc.
-    return (c == '+' || c == '-' || c == '*' || c == '/' ||
-            c == '=' || c == '>' || c == '<' || c == '&' || c == '|');
+    // Operators and punctuation are listed in operatorSpellings above
+    // For example: +, -, *, /, =, >, <, >=, <=, ==, &&, ||, [, ], (, ), ","
+    return operatorDfa.next[0][operatorDfa.charClass[static_cast<unsigned char>(c)]] != 0;
 }
 
 
+// ----------------------------------------------------------------------------------
+// LineTable and TokenStore
+
+void LineTable::build() const {
+    const char* data = source.data();
+    size_t size = source.size();
+    size_t pos = 0;
+    lineStarts.push_back(0);
+#ifdef __SSE2__
+    // Compare 16 bytes at a time and emit one line start per set bit of the mask
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        unsigned found = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        while (found != 0) {
+            lineStarts.push_back(static_cast<uint32_t>(pos + __builtin_ctz(found) + 1));
+            found &= found - 1;
+        }
+    }
+#endif
+    for (; pos < size; pos++) {
+        if (data[pos] == '\n') {
+            lineStarts.push_back(static_cast<uint32_t>(pos + 1));
+        }
+    }
+    built = true;
+}
+
+int LineTable::lineOf(size_t offset) const {
+    if (!built) {
+        build();
+    }
+    // Last line start at or before offset
+    auto next = upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    return static_cast<int>(next - lineStarts.begin());
+}
+
+SourceLocation LineTable::locate(size_t offset) const {
+    int line = lineOf(offset);
+    return { line, static_cast<int>(offset - lineStarts[line - 1]) + 1 };
+}
+
+void TokenStore::push(const Token& token) {
+    types.push_back(static_cast<uint8_t>(token.type));
+    offsets.push_back(token.offset);
+    lengths.push_back(static_cast<uint32_t>(token.lexeme.size()));
+    ids.push_back(token.id);
+}
+
+void TokenStore::shrinkToFit() {
+    types.shrink_to_fit();
+    offsets.shrink_to_fit();
+    lengths.shrink_to_fit();
+    ids.shrink_to_fit();
+}
+
+size_t TokenStore::memoryBytes() const {
+    return types.capacity() * sizeof(uint8_t) + offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) + ids.capacity() * sizeof(uint32_t);
+}
+
+// ----------------------------------------------------------------------------------
+// IdentifierTable
+
+static inline uint32_t hashName(string_view name) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return h;
+}
+
+IdentifierTable::IdentifierTable() : slots(64, 0), internCount(0) {}
+
+uint32_t IdentifierTable::intern(string_view name) {
+    internCount++;
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hashName(name) & mask; ; slot = (slot + 1) & mask) {
+        uint32_t entry = slots[slot];
+        if (entry == 0) {
+            uint32_t id = static_cast<uint32_t>(names.size());
+            names.push_back(name);
+            slots[slot] = id + 1;
+            // Keep the load factor at or below one half
+            if (names.size() * 2 > slots.size()) {
+                grow();
+            }
+            return id;
+        }
+        if (names[entry - 1] == name) {
+            return entry - 1;
+        }
+    }
+}
+
+vector<uint32_t> IdentifierTable::merge(const IdentifierTable& other) {
+    vector<uint32_t> remap(other.names.size());
+    for (uint32_t id = 0; id < other.names.size(); id++) {
+        remap[id] = intern(other.names[id]);
+    }
+    // intern() counted each distinct name once; add the rest of other's occurrences
+    internCount += other.internCount - other.names.size();
+    return remap;
+}
+
+void IdentifierTable::grow() {
+    vector<uint32_t> grown(slots.size() * 2, 0);
+    size_t mask = grown.size() - 1;
+    for (uint32_t id = 0; id < names.size(); id++) {
+        size_t slot = hashName(names[id]) & mask;
+        while (grown[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        grown[slot] = id + 1;
+    }
+    slots.swap(grown);
+}
+
+// ----------------------------------------------------------------------------------
+// TokenStream
+
+TokenStream::TokenStream(Tokenizer& tokenizer)
+    : tokenizer(&tokenizer), tokens(nullptr), store(nullptr), tokenPos(0), tokenEnd(0), head(0), count(0) {}
+
+TokenStream::TokenStream(const vector<Token>& tokens)
+    : tokenizer(nullptr), tokens(&tokens), store(nullptr), tokenPos(0), tokenEnd(tokens.size()), head(0), count(0) {}
+
+TokenStream::TokenStream(const vector<Token>& tokens, size_t first, size_t last)
+    : tokenizer(nullptr), tokens(&tokens), store(nullptr), tokenPos(first), tokenEnd(last), head(0), count(0) {}
+
+TokenStream::TokenStream(const TokenStore& store)
+    : tokenizer(nullptr), tokens(nullptr), store(&store), tokenPos(0), tokenEnd(0), head(0), count(0) {}
+
+Token TokenStream::pull() {
+    if (tokenizer) {
+        return tokenizer->nextToken();
+    }
+    if (store) {
+        if (tokenPos < store->size()) {
+            return store->token(tokenPos++);
+        }
+        return store->size() == 0 ? Token{ TokenType::END_OF_FILE, "", 0 } : store->token(store->size() - 1);
+    }
+    // Keep handing out the trailing END_OF_FILE once the vector is exhausted
+    if (tokenPos < tokenEnd) {
+        return (*tokens)[tokenPos++];
+    }
+    if (tokenEnd < tokens->size()) {
+        return Token{ TokenType::END_OF_FILE, "", (*tokens)[tokenEnd].offset };
+    }
+    return tokens->empty() ? Token{ TokenType::END_OF_FILE, "", 0 } : tokens->back();
+}
+
+const Token& TokenStream::peek(size_t ahead) {
+    if (ahead >= lookaheadSize) {
+        throw out_of_range("TokenStream lookahead exceeded");
+    }
+    while (count <= ahead) {
+        ring[(head + count) % lookaheadSize] = pull();
+        count++;
+    }
+    return ring[(head + ahead) % lookaheadSize];
+}
+
+Token TokenStream::next() {
+    if (count == 0) {
+        return pull();
+    }
+    Token token = ring[head];
+    head = (head + 1) % lookaheadSize;
+    count--;
+    return token;
+}
+
 // ----------------------------------------------------------------------------------
 // main for unit testing
 
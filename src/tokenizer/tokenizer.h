@@ -1,11 +1,14 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -30,37 +33,194 @@ enum class TokenType {
     END,
     FOR,
     WHILE,
+    PUNCTUATION,
     END_OF_FILE,
 };
 
 // Token structure
+// The lexeme is a view into the source buffer handed to the Tokenizer, so tokens
+// stay valid only as long as that buffer is alive. Tokens carry only the byte offset
+// of their lexeme; a LineTable turns it into a line and column when one is needed.
 struct Token {
+    static constexpr uint32_t noId = UINT32_MAX;
+
     TokenType type;
-    string lexeme;
-    int line;  // optional: to track line numbers
+    string_view lexeme;
+    uint32_t offset;  // byte offset of the lexeme in the tokenizer's input
+    uint32_t id = noId;  // interned identifier id, only set on IDENTIFIER tokens
 
     // Token(TokenType type, const string& lexeme, int line) : type(type), lexeme(lexeme), line(line) {}
 };
 
+// Interns identifier spellings as dense ids (0, 1, 2, ... in order of first use), so
+// later passes can compare and index identifiers by integer instead of by string.
+// Names are views into the source buffer, like token lexemes.
+class IdentifierTable {
+public:
+    IdentifierTable();
+
+    // Id for `name`, assigning the next free id on first sight
+    uint32_t intern(string_view name);
+
+    // Intern every name of `other` in id order, as if its identifiers had been seen
+    // right after this table's; returns the new id for each of other's ids
+    vector<uint32_t> merge(const IdentifierTable& other);
+
+    string_view name(uint32_t id) const { return names[id]; }
+    size_t distinctCount() const { return names.size(); }
+    size_t totalCount() const { return internCount; }
+
+private:
+    void grow();
+
+    vector<uint32_t> slots;  // open addressing: id + 1, or 0 for an empty slot
+    vector<string_view> names;
+    size_t internCount;
+};
+
+// Keyword spelling and the token type it maps to
+struct Keyword {
+    string_view text;
+    TokenType type;
+};
+
+// 1-based line and column (in bytes) of a source offset
+struct SourceLocation {
+    int line;
+    int column;
+};
+
+// Start offset of every line in a source buffer, built on the first lookup so
+// tokenizing never pays for line tracking.
+class LineTable {
+public:
+    explicit LineTable(string_view source) : source(source), built(false) {}
+
+    // 1-based line containing the byte at `offset`
+    int lineOf(size_t offset) const;
+
+    SourceLocation locate(size_t offset) const;
+
+private:
+    void build() const;
+
+    string_view source;
+    mutable vector<uint32_t> lineStarts;
+    mutable bool built;
+};
+
+// Struct-of-arrays token storage: one byte of type plus 32-bit offset, length and
+// identifier id per token (13 bytes instead of sizeof(Token)). Lexemes are rebuilt
+// from the source buffer on access and lines are computed only when asked for.
+class TokenStore {
+public:
+    explicit TokenStore(string_view source) : source(source), lines(source) {}
+
+    // Append a token produced by a Tokenizer over the same source
+    void push(const Token& token);
+
+    size_t size() const { return types.size(); }
+    TokenType type(size_t index) const { return static_cast<TokenType>(types[index]); }
+    string_view lexeme(size_t index) const { return source.substr(offsets[index], lengths[index]); }
+    uint32_t id(size_t index) const { return ids[index]; }
+    uint32_t offset(size_t index) const { return offsets[index]; }
+    int line(size_t index) const { return lines.lineOf(offsets[index]); }
+    Token token(size_t index) const { return { type(index), lexeme(index), offsets[index], id(index) }; }
+    string_view sourceText() const { return source; }
+
+    // Release unused capacity once no more tokens will be pushed
+    void shrinkToFit();
+
+    // Bytes held by the token arrays
+    size_t memoryBytes() const;
+
+private:
+    string_view source;
+    vector<uint8_t> types;
+    vector<uint32_t> offsets;
+    vector<uint32_t> lengths;
+    vector<uint32_t> ids;
+    LineTable lines;
+};
+
 // Tokenizer class
 class Tokenizer {
 private:
-    string input;
+    string_view input;  // not owned: the caller keeps the source buffer alive
     size_t currentPos;
-    vector<Token> tokens;
+    bool ignoreKeywordCase;  // match "Array of" the same as "Array Of"
+    IdentifierTable identifiers;
 
-    void tokenizeNumber();
-    void tokenizeIdentifier();
-    void tokenizeOperator();
-    void tokenizeString();
+    Token tokenizeNumber();
+    Token tokenizeIdentifier();
+    Token tokenizeOperator();
+    Token tokenizeString();
     void tokenizeOther();
     bool isOperator(char c);
+    TokenType classifyIdentifier(string_view identifier) const;
 
 public:
-    Tokenizer(string input) : input(input), currentPos(0) {};
+    Tokenizer(string_view input, bool ignoreKeywordCase = false)
+        : input(input), currentPos(0), ignoreKeywordCase(ignoreKeywordCase) {
+        // Token offsets are 32-bit
+        if (input.size() > UINT32_MAX) {
+            throw length_error("Tokenizer supports sources up to 4 GB");
+        }
+    }
+
+    // Function to produce the next token on demand (END_OF_FILE once the input is exhausted)
+    Token nextToken();
 
-    // Function to tokenize the input
+    // Function to tokenize the whole input at once
     vector<Token> tokenize();
+
+    // Same as tokenize(), but into compact struct-of-arrays storage
+    TokenStore tokenizeCompact();
+
+    // Same tokens and identifier ids as tokenize(), with the input split at newlines
+    // into chunks of at least minChunkBytes that are tokenized on threadCount threads
+    vector<Token> tokenizeParallel(size_t threadCount, size_t minChunkBytes = 1 << 16);
+
+    // Identifiers interned so far, with distinct/total counts; the optimizer adds the
+    // names of its temporaries
+    const IdentifierTable& identifierTable() const { return identifiers; }
+    IdentifierTable& identifierTable() { return identifiers; }
+
+    // The buffer token offsets refer to
+    string_view sourceText() const { return input; }
+};
+
+// Pull-based token source with a small fixed lookahead window.
+// Reads either straight from a Tokenizer, keeping token memory constant, or from
+// already materialized tokens (a vector or a TokenStore). No source is owned.
+class TokenStream {
+public:
+    static constexpr size_t lookaheadSize = 4;
+
+    explicit TokenStream(Tokenizer& tokenizer);
+    explicit TokenStream(const vector<Token>& tokens);
+    // Only tokens[first, last), then END_OF_FILE at the offset of tokens[last]
+    TokenStream(const vector<Token>& tokens, size_t first, size_t last);
+    explicit TokenStream(const TokenStore& store);
+
+    // Token `ahead` positions past the next one, without consuming anything
+    const Token& peek(size_t ahead = 0);
+
+    // Consume and return the next token
+    Token next();
+
+private:
+    Token pull();
+
+    Tokenizer* tokenizer;
+    const vector<Token>* tokens;
+    const TokenStore* store;
+    size_t tokenPos;
+    size_t tokenEnd;  // vector mode: where this stream's tokens stop
+
+    Token ring[lookaheadSize];
+    size_t head;
+    size_t count;
 };
 
 #endif // TOKENIZER_H
@@ -14,7 +14,7 @@ GTEST_LIB_PATH="/usr/lib/x86_64-linux-gnu"
 
 # Step 1: Compile the source files and tests
 echo "Compiling CodeGenerator and test files..."
-g++ -std=c++11 -isystem $GTEST_INCLUDE_PATH -pthread $CODEGENERATOR_SRC $TEST_CODEGENERATOR_SRC -lgtest -lgtest_main -o $OUTPUT_EXEC -L$GTEST_LIB_PATH
+g++ -std=c++17 -isystem $GTEST_INCLUDE_PATH -pthread $CODEGENERATOR_SRC $TEST_CODEGENERATOR_SRC -lgtest -lgtest_main -o $OUTPUT_EXEC -L$GTEST_LIB_PATH
 
 # Step 2: Run the tests
 echo "Running tests..."
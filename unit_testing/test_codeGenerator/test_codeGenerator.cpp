@@ -1,14 +1,39 @@
 #include "../../src/codeGenerator/codeGenerator.h" // Header for the CodeGenerator class
 #include "../../src/parser/parser.h" // Header for the Parser class
 #include <gtest/gtest.h> // GoogleTest header
+#include <cstdlib>
+#include <new>
 using namespace std;
 
+// Global allocation counter, bumped by the replaced operator new below
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
 // Helper function to tokenize and parse pseudocode
 Node parseInput(const string& input) {
     Tokenizer tokenizer(input);
     auto tokens = tokenizer.tokenize();
     Parser parser(tokens);
-    return parser.parse();
+    Node ast = parser.parse();
+    // The nodes live in the parser's arena; keep it alive for the rest of the run
+    static vector<AstArena> arenas;
+    arenas.push_back(parser.takeArena());
+    return ast;
 }
 
 // Normalize whitespace in both strings
@@ -221,3 +246,306 @@ TEST(CodeGeneratorTest, GenerateWhileLoop) {
     EXPECT_EQ(normalizeWhitespace(generatedCode), normalizeWhitespace(expectedCode));
 }
 
+
+// Test code generation for compound comparisons and indexed prints
+TEST(CodeGeneratorTest, GenerateCompoundOperators) {
+    string input = R"(
+        Declare mat As Array Of Integer[3][3]
+        If x <= 10 && y >= 2 Then
+            Assign mat[1][j] = arr[i] + 1
+            Print mat[1][j], y
+        End If
+    )";
+    Node ast = parseInput(input);
+
+    CodeGenerator generator;
+    string generatedCode = generator.generateCode(ast);
+
+    string expectedCode = R"(
+        #include <bits/stdc++.h>
+        using namespace std;
+
+        int main() {
+
+            int mat[3][3];
+            if ( x <= 10 && y >= 2 ) {
+                mat[1][j] = arr[i] + 1 ;
+                cout << mat[1][j] << " " << y << endl;
+            }
+
+            return 0;
+        }
+    )";
+    EXPECT_EQ(normalizeWhitespace(generatedCode), normalizeWhitespace(expectedCode));
+}
+
+// Test that generating from the flat pre-order AST gives the same code as from the tree
+TEST(CodeGeneratorTest, GenerateFromFlatAst) {
+    string input = R"(
+        Declare arr As Array Of Integer[10]
+        For i = 0 To 9 Do
+            If i > 4 Then
+                Assign arr[i] = i * 2
+            Else
+                Print "low", arr[i]
+            End If
+        End For
+        While x < 10 Do
+            Assign x = x + 1
+        End While
+    )";
+    Node ast = parseInput(input);
+    FlatAst flat = FlatAst::fromTree(ast);
+
+    CodeGenerator generator;
+    EXPECT_EQ(generator.generateCode(flat), generator.generateCode(ast));
+}
+
+// Build `depth` nested If blocks, each with a statement before the inner block
+string nestedIfs(int depth) {
+    string input;
+    for (int level = 0; level < depth; level++) {
+        input += "If x > " + to_string(level) + " Then\nAssign x = x - 1\n";
+    }
+    for (int level = 0; level < depth; level++) {
+        input += "End If\n";
+    }
+    return input;
+}
+
+// Heap allocations for tokenizing, parsing and generating code from `input`
+size_t pipelineAllocations(const string& input) {
+    size_t allocationsBefore = allocationCount;
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    CodeGenerator generator;
+    string code = generator.generateCode(ast);
+    EXPECT_FALSE(code.empty());
+    return allocationCount - allocationsBefore;
+}
+
+// Test that nesting deeper costs a linear number of allocations, not a quadratic one
+TEST(CodeGeneratorTest, NestingAllocatesLinearly) {
+    size_t shallow = pipelineAllocations(nestedIfs(200));
+    size_t deep = pipelineAllocations(nestedIfs(800));
+
+    // Four times the depth: linear growth stays near 4x, quadratic copying would be 16x
+    EXPECT_LT(deep, shallow * 6) << shallow << " allocations at depth 200, " << deep << " at depth 800";
+}
+
+// Test that nesting far deeper than the call stack allows still generates, with the
+// indentation capped
+TEST(CodeGeneratorTest, GenerateDeepNesting) {
+    const int depth = 100000;
+    string input = nestedIfs(depth);
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+
+    CodeGenerator generator;
+    string code = generator.generateCode(ast);
+    size_t ifs = 0;
+    for (size_t pos = code.find("if ( "); pos != string::npos; pos = code.find("if ( ", pos + 1)) {
+        ifs++;
+    }
+    EXPECT_EQ(ifs, depth);
+    EXPECT_EQ(code.find(string(maxIndentLevel + 1, '\t')), string::npos);
+    EXPECT_NE(code.find(string(maxIndentLevel, '\t') + "x = x - 1 ;"), string::npos);
+
+    FlatAst flat = FlatAst::fromTree(ast);
+    EXPECT_EQ(generator.generateCode(flat), code);
+}
+
+// Test that a long Print over the flat tree walks its items once, not once per item
+TEST(CodeGeneratorTest, GenerateWidePrintFromFlatAst) {
+    const int items = 50000;
+    string input = "Declare x As Integer\nPrint";
+    for (int item = 0; item < items; item++) {
+        input += " x";
+    }
+    input += "\n";
+    Node ast = parseInput(input);
+    FlatAst flat = FlatAst::fromTree(ast);
+
+    CodeGenerator generator;
+    string code = generator.generateCode(flat);
+    EXPECT_EQ(code, generator.generateCode(ast));
+    EXPECT_NE(code.find("cout << x << \" \" << x << "), string::npos);
+}
+
+// Test that conditions use C++ comparison and logic operators and keep needed parentheses
+TEST(CodeGeneratorTest, GenerateExpressionTrees) {
+    string input = R"(
+        If x = 3+4 And Not y <> 2 Then
+            Assign z = (x + 1) * (y - 2) - (a - b)
+        End If
+        While Not done Or -x < 0 Do
+            Assign total = total + arr[i + 1] / 2
+        End While
+    )";
+    Node ast = parseInput(input);
+
+    CodeGenerator generator;
+    string generatedCode = generator.generateCode(ast);
+
+    string expectedCode = R"(
+        #include <bits/stdc++.h>
+        using namespace std;
+
+        int main() {
+
+            if ( x == 3 + 4 && !(y != 2) ) {
+                z = (x + 1) * (y - 2) - (a - b) ;
+            }
+            while (!done || -x < 0 ) {
+                total = total + arr[i + 1] / 2 ;
+            }
+
+
+            return 0;
+        }
+    )";
+    EXPECT_EQ(normalizeWhitespace(generatedCode), normalizeWhitespace(expectedCode));
+}
+
+// Test that comparisons nested in comparisons keep the pseudocode's grouping, since C++
+// binds == and != looser than < and >
+TEST(CodeGeneratorTest, GenerateMixedComparisons) {
+    string input = R"(
+        If a = b < c Then
+            Print a
+        End If
+        While a < (b = c) Or a <> (b > c) Do
+            Print b
+        End While
+    )";
+    Node ast = parseInput(input);
+
+    CodeGenerator generator;
+    string generatedCode = generator.generateCode(ast);
+    EXPECT_NE(generatedCode.find("if ( (a == b) < c ) {"), string::npos) << generatedCode;
+    EXPECT_NE(generatedCode.find("while (a < (b == c) || a != b > c ) {"), string::npos) << generatedCode;
+    EXPECT_EQ(generator.generateCode(FlatAst::fromTree(ast)), generatedCode);
+}
+
+// Test writing the pseudocode Booleans as C++ literals
+TEST(CodeGeneratorTest, GenerateBooleanLiterals) {
+    string input = R"(
+        Declare done As Boolean
+        Assign done = False
+        While done = False Do
+            Assign done = True
+        End While
+    )";
+    Node ast = parseInput(input);
+
+    CodeGenerator generator;
+    string generatedCode = generator.generateCode(ast);
+    EXPECT_NE(generatedCode.find("bool done;"), string::npos) << generatedCode;
+    EXPECT_NE(generatedCode.find("done = false ;"), string::npos) << generatedCode;
+    EXPECT_NE(generatedCode.find("while (done == false ) {"), string::npos) << generatedCode;
+    EXPECT_NE(generatedCode.find("done = true ;"), string::npos) << generatedCode;
+}
+
+// Translate in one pass, without a tree
+string translateInput(const string& input, size_t& arenaNodes) {
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    CodeGenerator generator;
+    stringstream code;
+    generator.translate(parser, code);
+    arenaNodes = parser.takeArena().nodeCount();
+    return code.str();
+}
+
+// Test that direct translation gives exactly the pipeline's output and keeps no tree
+TEST(CodeGeneratorTest, TranslateDirectly) {
+    string program = R"(
+        Declare x As Integer
+        Declare arr As Array Of Integer[10]
+        Assign x = 5
+        For i = 0 To 9 Do
+            Assign arr[i] = i * 2
+            If arr[i] > x And Not i = 3 Then
+                Print arr[i], "big"
+                While x < i Do
+                    Assign x = x + 1
+                End While
+            Else
+                Print "small"
+            End If
+            If x <> 0 Then
+                Print x
+            End If
+        End For
+        Print "done"
+    )";
+    vector<string> inputs = { program, "", "Print 1", nestedIfs(1000) };
+    string repeated;
+    for (int copy = 0; copy < 200; copy++) {
+        repeated += program;
+    }
+    inputs.push_back(repeated);
+
+    CodeGenerator generator;
+    for (const string& input : inputs) {
+        size_t arenaNodes = 0;
+        EXPECT_EQ(translateInput(input, arenaNodes), generator.generateCode(parseInput(input)));
+        // Only the last statement's nodes are still in the arena
+        EXPECT_LT(arenaNodes, 20);
+    }
+
+    size_t arenaNodes = 0;
+    EXPECT_THROW(translateInput("If x Then\nPrint x\nEnd While", arenaNodes), ParseError);
+}
+
+// Test code generation for Read, Else If and Do ... While, from the tree and directly
+TEST(CodeGeneratorTest, GenerateGrammarExtensions) {
+    string input = R"(
+        Declare arr As Array Of Integer[10]
+        Read x, arr[i]
+        If x < 0 Then
+            Print "negative"
+        Else If x = 0 Then
+            Print "zero"
+        End If
+        Do
+            Assign x = x - 1
+        While x > 0
+    )";
+    Node ast = parseInput(input);
+
+    CodeGenerator generator;
+    string generatedCode = generator.generateCode(ast);
+
+    string expectedCode = R"(
+        #include <bits/stdc++.h>
+        using namespace std;
+
+        int main() {
+
+            int arr[10];
+            cin >> x >> arr[i];
+            if ( x < 0 ) {
+                cout << "negative" << endl;
+            }
+            else {
+                if ( x == 0 ) {
+                    cout << "zero" << endl;
+                }
+            }
+
+            do {
+                x = x - 1 ;
+            } while (x > 0 );
+
+
+            return 0;
+        }
+    )";
+    EXPECT_EQ(normalizeWhitespace(generatedCode), normalizeWhitespace(expectedCode));
+
+    size_t arenaNodes = 0;
+    EXPECT_EQ(translateInput(input, arenaNodes), generatedCode);
+}
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Ensure the script stops on any error
+set -e
+
+# Define paths for source files and the output executable
+CODEGENERATOR_SRC="../../src/codeGenerator/codeGenerator.cpp"
+OPTIMIZER_SRC="../../src/optimizer/optimizer.cpp"
+TEST_OPTIMIZER_SRC="test_optimizer.cpp"
+OUTPUT_EXEC="optimizer_test"
+
+# Define the path to GoogleTest
+GTEST_INCLUDE_PATH="/usr/include/gtest"
+GTEST_LIB_PATH="/usr/lib/x86_64-linux-gnu"
+
+# Step 1: Compile the source files and tests
+echo "Compiling Optimizer and test files..."
+g++ -std=c++17 -isystem $GTEST_INCLUDE_PATH -pthread $CODEGENERATOR_SRC $OPTIMIZER_SRC $TEST_OPTIMIZER_SRC -lgtest -lgtest_main -o $OUTPUT_EXEC -L$GTEST_LIB_PATH
+
+# Step 2: Run the tests
+echo "Running tests..."
+./$OUTPUT_EXEC
+
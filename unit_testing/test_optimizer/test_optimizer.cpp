@@ -0,0 +1,589 @@
+#include "../../src/optimizer/optimizer.h" // Header for the Optimizer class
+#include "../../src/codeGenerator/codeGenerator.h" // Header for the CodeGenerator class
+#include <gtest/gtest.h> // GoogleTest header
+using namespace std;
+
+// Helper function to parse, optimize and translate pseudocode; folding only unless told
+string optimizeInput(const string& input, uint32_t passes = Optimizer::FOLD_CONSTANTS, OptimizerStats* stats = nullptr) {
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    Optimizer optimizer(passes);
+    optimizer.optimize(ast, tokenizer.identifierTable());
+    if (stats) {
+        *stats = optimizer.stats();
+    }
+    CodeGenerator generator;
+    return generator.generateCode(ast);
+}
+
+// True if the generated code has `line` as one of its lines, ignoring indentation
+bool hasLine(const string& code, const string& line) {
+    stringstream lines(code);
+    string current;
+    while (getline(lines, current)) {
+        size_t start = current.find_first_not_of('\t');
+        if (start != string::npos && current.substr(start) == line) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Test folding literal arithmetic and comparisons
+TEST(OptimizerTest, FoldLiterals) {
+    string input = "Declare x As Integer\n"
+                   "Declare y As Integer\n"
+                   "Read x\n"
+                   "Assign y = x + 5 * 3\n"
+                   "If x = 3+4 Then\n"
+                   "    Assign y = (2 - 9) * 3\n"
+                   "End If\n";
+    string code = optimizeInput(input);
+    EXPECT_TRUE(hasLine(code, "y = x + 15 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "if ( x == 7 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "y = -21 ;")) << code;
+}
+
+// Test carrying variable values through straight-line code into expressions, indices and Print
+TEST(OptimizerTest, PropagateConstants) {
+    string input = "Declare x As Integer\n"
+                   "Declare y As Integer\n"
+                   "Declare arr As Array Of Integer[5]\n"
+                   "Assign x = 2\n"
+                   "Assign y = x * x + 1\n"
+                   "Assign arr[x] = y\n"
+                   "Print x arr[x]\n"
+                   "Read x\n"
+                   "Print x\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::FOLD_CONSTANTS, &stats);
+    EXPECT_TRUE(hasLine(code, "y = 5 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "arr[2] = 5 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << 2 << \" \" << arr[2] << endl;")) << code;
+    // Read makes x unknown again
+    EXPECT_TRUE(hasLine(code, "cout << x << endl;")) << code;
+    EXPECT_EQ(stats.foldedExpressions, 2);
+    EXPECT_EQ(stats.propagatedUses, 6);
+}
+
+// Results C++ would not compute the same way are left for run time
+TEST(OptimizerTest, PreserveOverflowAndDivision) {
+    string input = "Declare x As Integer\n"
+                   "Assign x = 2147483647 + 1\n"
+                   "Assign x = 0 - 2147483647 - 1\n"
+                   "Assign x = 7 / 0\n"
+                   "Assign x = 3000000000 - 1\n"
+                   "Assign x = 2147483646 + 1\n"
+                   "Assign x = -7 / 2\n"
+                   "Assign x = 7 / -2\n";
+    string code = optimizeInput(input);
+    EXPECT_TRUE(hasLine(code, "x = 2147483647 + 1 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "x = -2147483647 - 1 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "x = 7 / 0 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "x = 3000000000 - 1 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "x = 2147483647 ;")) << code;
+    // Integer division truncates toward zero, both ways
+    size_t first = code.find("x = -3 ;");
+    ASSERT_NE(first, string::npos) << code;
+    EXPECT_NE(code.find("x = -3 ;", first + 1), string::npos) << code;
+}
+
+// Test Boolean operators, including a left operand that decides And and Or
+TEST(OptimizerTest, FoldBooleans) {
+    string input = "Declare x As Integer\n"
+                   "Read x\n"
+                   "If 1 > 2 And x > 0 Then\n"
+                   "    Print x\n"
+                   "End If\n"
+                   "If 1 < 2 Or x > 0 Then\n"
+                   "    Print x\n"
+                   "End If\n"
+                   "If Not (3 = 3) Or x > 0 Then\n"
+                   "    Print x\n"
+                   "End If\n"
+                   "If True And x > 0 Then\n"
+                   "    Print x\n"
+                   "End If\n";
+    string code = optimizeInput(input);
+    EXPECT_TRUE(hasLine(code, "if ( false ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "if ( true ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "if ( false || x > 0 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "if ( true && x > 0 ) {")) << code;
+}
+
+// Test merging values after an If: kept where both branches agree or the condition is known
+TEST(OptimizerTest, MergeBranches) {
+    string input = "Declare x As Integer\n"
+                   "Declare y As Integer\n"
+                   "Declare z As Integer\n"
+                   "Read z\n"
+                   "If z > 0 Then\n"
+                   "    Assign x = 1\n"
+                   "    Assign y = 2\n"
+                   "Else\n"
+                   "    Assign x = 1\n"
+                   "    Assign y = 3\n"
+                   "End If\n"
+                   "Print x y\n"
+                   "If x = 1 Then\n"
+                   "    Assign y = 4\n"
+                   "End If\n"
+                   "Print y\n";
+    string code = optimizeInput(input);
+    EXPECT_TRUE(hasLine(code, "cout << 1 << \" \" << y << endl;")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << 4 << endl;")) << code;
+}
+
+// Test that a name declared in a block hides the outer value only inside the block
+TEST(OptimizerTest, BlockDeclarations) {
+    string input = "Declare x As Integer\n"
+                   "Declare z As Integer\n"
+                   "Read z\n"
+                   "Assign x = 5\n"
+                   "If z > 0 Then\n"
+                   "    Print x\n"
+                   "    Declare x As Integer\n"
+                   "    Print x\n"
+                   "End If\n";
+    string code = optimizeInput(input);
+    EXPECT_TRUE(hasLine(code, "cout << 5 << endl;")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << x << endl;")) << code;
+}
+
+// Test loop bounds, and variables changed inside loop bodies
+TEST(OptimizerTest, Loops) {
+    string input = "Declare n As Integer\n"
+                   "Declare k As Integer\n"
+                   "Declare total As Integer\n"
+                   "Assign n = 4\n"
+                   "Assign k = 0\n"
+                   "Assign total = 0\n"
+                   "For i = n - 4 To n * 2 Do\n"
+                   "    Assign total = total + i * n\n"
+                   "End For\n"
+                   "Print total\n"
+                   "While k < n Do\n"
+                   "    Assign k = k + 1\n"
+                   "End While\n"
+                   "Print k n\n"
+                   "Do\n"
+                   "    Assign k = 2\n"
+                   "While k > n\n";
+    string code = optimizeInput(input);
+    EXPECT_TRUE(hasLine(code, "for (int i = 0 ; i <= 8 ; i++) {")) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + i * 4 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << total << endl;")) << code;
+    EXPECT_TRUE(hasLine(code, "while (k < 4 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << k << \" \" << 4 << endl;")) << code;
+    EXPECT_TRUE(hasLine(code, "} while (false );")) << code;
+}
+
+// Test replacing decided Ifs and loops by the code that runs
+TEST(OptimizerTest, RemoveBranches) {
+    string input = "Declare x As Integer\n"
+                   "Read x\n"
+                   "If 1 > 2 Then\n"
+                   "    Print \"never\"\n"
+                   "Else\n"
+                   "    Print x\n"
+                   "End If\n"
+                   "If 2 > 1 Then\n"
+                   "    Declare y As Integer\n"
+                   "    Read y\n"
+                   "    Print y\n"
+                   "End If\n"
+                   "While 2 < 1 Do\n"
+                   "    Print \"never\"\n"
+                   "End While\n"
+                   "For i = 5 To 1 Do\n"
+                   "    Print i\n"
+                   "End For\n"
+                   "Do\n"
+                   "    Print x\n"
+                   "While 1 = 2\n"
+                   "While 1 < 2 Do\n"
+                   "End While\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::FOLD_CONSTANTS | Optimizer::ELIMINATE_DEAD_CODE, &stats);
+    EXPECT_EQ(code.find("never"), string::npos) << code;
+    EXPECT_EQ(code.find("for"), string::npos) << code;
+    EXPECT_EQ(code.find("do {"), string::npos) << code;
+    // The block declaring y stays a scope of its own
+    EXPECT_TRUE(hasLine(code, "if ( true ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "int y;")) << code;
+    // A loop that never stops is kept even when empty
+    EXPECT_TRUE(hasLine(code, "while (true ) {")) << code;
+    EXPECT_EQ(stats.removedBranches, 4);
+
+    // Empty statements whose conditions may divide by zero or read out of bounds stay
+    string faulting = "Declare a As Integer\n"
+                      "Declare b As Integer\n"
+                      "Declare arr As Array Of Integer[3]\n"
+                      "Read a b\n"
+                      "While a / b > 0 Do\n"
+                      "End While\n"
+                      "If arr[a] > 0 Then\n"
+                      "End If\n"
+                      "If a / 2 > 0 Then\n"
+                      "End If\n";
+    code = optimizeInput(faulting, Optimizer::FOLD_CONSTANTS | Optimizer::ELIMINATE_DEAD_CODE, &stats);
+    EXPECT_TRUE(hasLine(code, "while (a / b > 0 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "if ( arr[a] > 0 ) {")) << code;
+    EXPECT_EQ(code.find("a / 2"), string::npos) << code;
+    EXPECT_EQ(stats.removedBranches, 1);
+}
+
+// Test removing stores overwritten or never read, through branches, loops and shadowing
+TEST(OptimizerTest, RemoveDeadStores) {
+    string input = "Declare a As Integer\n"
+                   "Declare b As Integer\n"
+                   "Declare c As Integer\n"
+                   "Read a\n"
+                   "Assign b = a * 2\n"
+                   "Assign b = a + 1\n"
+                   "Assign c = 0\n"
+                   "If a > 2 Then\n"
+                   "    Declare b As Integer\n"
+                   "    Read b\n"
+                   "    Assign c = b\n"
+                   "Else\n"
+                   "    Assign b = a - 1\n"
+                   "End If\n"
+                   "Print b\n"
+                   "While c > 0 Do\n"
+                   "    Print c\n"
+                   "    Assign c = c - 1\n"
+                   "    Assign a = c\n"
+                   "End While\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::FOLD_CONSTANTS | Optimizer::ELIMINATE_DEAD_CODE, &stats);
+    EXPECT_FALSE(hasLine(code, "b = a * 2 ;")) << code;
+    // The outer b is read after the If, so neither store before it can go
+    EXPECT_TRUE(hasLine(code, "b = a + 1 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "b = a - 1 ;")) << code;
+    // c is read by the next iteration; a never is again
+    EXPECT_TRUE(hasLine(code, "c = c - 1 ;")) << code;
+    EXPECT_FALSE(hasLine(code, "a = c ;")) << code;
+    EXPECT_EQ(stats.deadStores, 2);
+}
+
+// Test removing variables that are never read, arrays included, and keeping function calls
+TEST(OptimizerTest, RemoveUnusedDeclarations) {
+    string input = "Declare x As Integer\n"
+                   "Declare y As Integer\n"
+                   "Declare arr As Array Of Integer[5]\n"
+                   "Declare matrix As Array Of Integer[3][3]\n"
+                   "Read x\n"
+                   "Assign y = x + 1\n"
+                   "For i = 0 To 4 Do\n"
+                   "    Assign arr[i] = i * x\n"
+                   "End For\n"
+                   "For i = 0 To 2 Do\n"
+                   "    For j = 0 To 2 Do\n"
+                   "        Assign matrix[i][j] = rand()\n"
+                   "    End For\n"
+                   "End For\n"
+                   "Print x\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::FOLD_CONSTANTS | Optimizer::ELIMINATE_DEAD_CODE, &stats);
+    EXPECT_FALSE(hasLine(code, "int y;")) << code;
+    EXPECT_FALSE(hasLine(code, "int arr[5];")) << code;
+    EXPECT_TRUE(hasLine(code, "int matrix[3][3];")) << code;
+    EXPECT_TRUE(hasLine(code, "matrix[i][j] = rand() ;")) << code;
+    EXPECT_EQ(stats.unusedDeclarations, 2);
+    EXPECT_EQ(stats.removedBranches, 1);
+}
+
+// Test computing loop bounds and invariant parts of nested loop bodies once, before the loop
+TEST(OptimizerTest, HoistInvariants) {
+    string input = "Declare n As Integer\n"
+                   "Declare m As Integer\n"
+                   "Declare total As Integer\n"
+                   "Declare grid As Array Of Integer[4][4]\n"
+                   "Read n m\n"
+                   "Assign total = 0\n"
+                   "For i = 0 To n - 1 Do\n"
+                   "    For j = 0 To n - 1 Do\n"
+                   "        Assign grid[i][j] = i * m + j + n * m\n"
+                   "        Assign total = total + n * m\n"
+                   "    End For\n"
+                   "End For\n"
+                   "Print total grid[1][1]\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::HOIST_INVARIANTS, &stats);
+    EXPECT_TRUE(hasLine(code, "hoisted_1 = n - 1 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "for (int i = 0 ; i <= hoisted_1 ; i++) {")) << code;
+    EXPECT_TRUE(hasLine(code, "for (int j = 0 ; j <= hoisted_1 ; j++) {")) << code;
+    // The inner body may not run, so i * m and n * m are computed before the inner loop,
+    // and only when it is entered: they could overflow where the program never would
+    EXPECT_TRUE(hasLine(code, "if ( 0 <= hoisted_1 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "hoisted_2 = i * m ;")) << code;
+    EXPECT_TRUE(hasLine(code, "hoisted_3 = n * m ;")) << code;
+    EXPECT_LT(code.find("if ( 0 <= hoisted_1 )"), code.find("hoisted_2 = i * m ;")) << code;
+    EXPECT_LT(code.find("hoisted_3 = n * m ;"), code.find("for (int j")) << code;
+    EXPECT_TRUE(hasLine(code, "grid[i][j] = hoisted_2 + j + hoisted_3 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + hoisted_3 ;")) << code;
+    EXPECT_EQ(stats.temporaries, 3);
+    EXPECT_EQ(stats.hoistedExpressions, 5);
+
+    // Literal bounds decide the entry condition: no If when the loop runs, nothing hoisted
+    // when it does not
+    string literal = "Declare n As Integer\n"
+                     "Declare total As Integer\n"
+                     "Read n\n"
+                     "Assign total = 0\n"
+                     "For i = 0 To 3 Do\n"
+                     "    Assign total = total + n * 3\n"
+                     "End For\n"
+                     "For i = 5 To 1 Do\n"
+                     "    Assign total = total + n * 5\n"
+                     "End For\n"
+                     "Print total\n";
+    code = optimizeInput(literal, Optimizer::HOIST_INVARIANTS, &stats);
+    EXPECT_TRUE(hasLine(code, "hoisted_1 = n * 3 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + hoisted_1 ;")) << code;
+    EXPECT_EQ(code.find("if ("), string::npos) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + n * 5 ;")) << code;
+    EXPECT_EQ(stats.temporaries, 1);
+}
+
+// Written variables, shadowing names, Strings, and faulting operations in a body that may
+// not run stay in the loop
+TEST(OptimizerTest, HoistOnlySafeInvariants) {
+    string input = "Declare n As Integer\n"
+                   "Declare d As Integer\n"
+                   "Declare k As Integer\n"
+                   "Declare arr As Array Of Integer[5]\n"
+                   "Declare str As String\n"
+                   "Read n d k\n"
+                   "While k < n / d Do\n"
+                   "    Assign k = k + n / d + arr[d]\n"
+                   "    Assign str = str + \"x\"\n"
+                   "End While\n"
+                   "While n > 0 And k < n / d Do\n"
+                   "    Assign n = n - d * 2\n"
+                   "End While\n"
+                   "For i = 0 To 3 Do\n"
+                   "    Declare d As Integer\n"
+                   "    Assign d = i\n"
+                   "    Assign k = k + d * n\n"
+                   "End For\n";
+    string code = optimizeInput(input, Optimizer::HOIST_INVARIANTS);
+    // The condition runs at least once, so its division moves out
+    EXPECT_TRUE(hasLine(code, "hoisted_1 = n / d ;")) << code;
+    EXPECT_TRUE(hasLine(code, "while (k < hoisted_1 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "k = k + n / d + arr[d] ;")) << code;
+    EXPECT_TRUE(hasLine(code, "str = str + \"x\" ;")) << code;
+    // n is written by the second loop; d * 2 is not, and has no division
+    EXPECT_TRUE(hasLine(code, "while (n > 0 && k < n / d ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "n = n - hoisted_2 ;")) << code;
+    // d is declared inside the For, so d * n means the inner d
+    EXPECT_TRUE(hasLine(code, "k = k + d * n ;")) << code;
+    EXPECT_EQ(code.find("hoisted_3"), string::npos) << code;
+
+    // From an If branch, only arithmetic on literals and bounded loop variables moves out
+    string branches = "Declare n As Integer\n"
+                      "Declare k As Integer\n"
+                      "Declare total As Integer\n"
+                      "Read n k\n"
+                      "Assign total = 0\n"
+                      "For i = 0 To 9 Do\n"
+                      "    For j = 0 To n Do\n"
+                      "        If k > 0 Then\n"
+                      "            Assign total = total + k * 1000 + i * 7\n"
+                      "        End If\n"
+                      "    End For\n"
+                      "End For\n"
+                      "Print total\n";
+    code = optimizeInput(branches, Optimizer::HOIST_INVARIANTS);
+    EXPECT_TRUE(hasLine(code, "hoisted_1 = i * 7 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + k * 1000 + hoisted_1 ;")) << code;
+    EXPECT_EQ(code.find("if ( 0 <= n )"), string::npos) << code;
+}
+
+// Test replacing the loop variable times an invariant by a variable stepped by addition
+TEST(OptimizerTest, ReduceInductionVariables) {
+    string input = "Declare n As Integer\n"
+                   "Declare total As Integer\n"
+                   "Read n\n"
+                   "Assign total = 0\n"
+                   "For i = 1 To 10 Do\n"
+                   "    Assign total = total + i * 3\n"
+                   "    For j = 0 To n Do\n"
+                   "        Assign total = total + i * 3 + 2 * i\n"
+                   "        If i * n > 5 Then\n"
+                   "            Print total\n"
+                   "        End If\n"
+                   "    End For\n"
+                   "End For\n"
+                   "For k = 0 To 1000000000 Do\n"
+                   "    While total < k * 4 Do\n"
+                   "        Assign total = total + 1\n"
+                   "    End While\n"
+                   "End For\n"
+                   "For k = 0 To n Do\n"
+                   "    For j = 0 To 3 Do\n"
+                   "        Assign total = total + k * 2\n"
+                   "    End For\n"
+                   "End For\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::REDUCE_STRENGTH, &stats);
+    EXPECT_TRUE(hasLine(code, "induction_1 = 3 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "induction_2 = 2 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + induction_1 + induction_2 ;")) << code;
+    // Directly in the body the multiply stays, and so does one by a variable
+    EXPECT_TRUE(hasLine(code, "total = total + i * 3 ;")) << code;
+    EXPECT_TRUE(hasLine(code, "if ( i * n > 5 ) {")) << code;
+    // The steps come last in the outer body
+    EXPECT_TRUE(hasLine(code, "induction_1 = induction_1 + 3 ;")) << code;
+    EXPECT_LT(code.find("if ( i * n"), code.find("induction_1 = induction_1 + 3 ;")) << code;
+    // 1000000001 * 4 leaves an int, and n is unknown
+    EXPECT_TRUE(hasLine(code, "while (total < k * 4 ) {")) << code;
+    EXPECT_TRUE(hasLine(code, "total = total + k * 2 ;")) << code;
+    EXPECT_EQ(stats.reducedMultiplications, 2);
+    EXPECT_EQ(stats.inductionVariables, 2);
+}
+
+// Test stepping pointers through rows, only where the loop bounds keep them inside the array
+TEST(OptimizerTest, ReduceArrayIndexing) {
+    string input = "Declare n As Integer\n"
+                   "Declare grid As Array Of Integer[3][4]\n"
+                   "Declare arr As Array Of Integer[4]\n"
+                   "Read n\n"
+                   "For i = 0 To 2 Do\n"
+                   "    For j = 0 To 3 Do\n"
+                   "        Assign grid[i][j] = i + j\n"
+                   "        Assign arr[j] = arr[j] + grid[i][j]\n"
+                   "    End For\n"
+                   "End For\n"
+                   "For j = 0 To 4 Do\n"
+                   "    Print grid[0][j]\n"
+                   "End For\n"
+                   "For j = 0 To n Do\n"
+                   "    Read grid[1][j]\n"
+                   "End For\n"
+                   "For j = 1 To 3 Do\n"
+                   "    Print grid[n][j] grid[2][j]\n"
+                   "End For\n";
+    OptimizerStats stats;
+    string code = optimizeInput(input, Optimizer::REDUCE_STRENGTH, &stats);
+    EXPECT_TRUE(hasLine(code, "pointer_1 = &grid[i][0] ;")) << code;
+    EXPECT_TRUE(hasLine(code, "pointer_1[0] = i + j ;")) << code;
+    EXPECT_TRUE(hasLine(code, "arr[j] = arr[j] + pointer_1[0] ;")) << code;
+    EXPECT_TRUE(hasLine(code, "pointer_1 = pointer_1 + 1 ;")) << code;
+    // j reaches past the end of a row, n is unknown, and so is the row n
+    EXPECT_TRUE(hasLine(code, "cout << grid[0][j] << endl;")) << code;
+    EXPECT_TRUE(hasLine(code, "cin >> grid[1][j];")) << code;
+    EXPECT_TRUE(hasLine(code, "pointer_2 = &grid[2][1] ;")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << grid[n][j] << \" \" << pointer_2[0] << endl;")) << code;
+    EXPECT_TRUE(hasLine(code, "int* pointer_2;")) << code;
+    EXPECT_EQ(stats.pointers, 2);
+    EXPECT_EQ(stats.pointerAccesses, 3);
+}
+
+// Without the pass the tree is left as parsed
+TEST(OptimizerTest, NoFold) {
+    string input = "Declare x As Integer\n"
+                   "Declare y As Integer\n"
+                   "Assign x = 5\n"
+                   "Assign y = x + 5 * 3\n";
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    string expected = CodeGenerator().generateCode(parser.parse());
+    EXPECT_EQ(optimizeInput(input, 0), expected);
+    EXPECT_TRUE(hasLine(expected, "y = x + 5 * 3 ;"));
+}
+
+// Test that pointers are declared with their C++ type and take the address of the row
+// by the array's name alone, Print items included
+TEST(OptimizerTest, DeclarePointersAsCppTypes) {
+    string input = "Declare n As Integer\n"
+                   "Declare total As Integer\n"
+                   "Declare grid As Array Of Integer[3][4]\n"
+                   "Read n\n"
+                   "Assign total = 0\n"
+                   "For i = 0 To 2 Do\n"
+                   "    For j = 0 To 3 Do\n"
+                   "        Assign grid[i][j] = i + j * n\n"
+                   "        Assign total = total + grid[i][j]\n"
+                   "    End For\n"
+                   "    For j = 0 To 3 Do\n"
+                   "        Print grid[i][j]\n"
+                   "    End For\n"
+                   "End For\n";
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    Optimizer optimizer(Optimizer::REDUCE_STRENGTH);
+    optimizer.optimize(ast, tokenizer.identifierTable());
+
+    size_t declared = 0;
+    size_t addresses = 0;
+    vector<const Node*> stack = { &ast };
+    while (!stack.empty()) {
+        const Node& node = *stack.back();
+        stack.pop_back();
+        if (node.type == NodeType::DECLARATION && node.children[1].token.type == TokenType::KEYWORD) {
+            EXPECT_EQ(node.children[1].token.lexeme, "int*");
+            declared++;
+        }
+        if (node.type == NodeType::UNARY_EXPRESSION && node.token.lexeme == "&") {
+            // & [ [ grid, i ], 0 ]
+            const Node& array = node.children[0].children[0].children[0];
+            EXPECT_EQ(array.token.lexeme, "grid");
+            EXPECT_TRUE(array.children.empty());
+            addresses++;
+        }
+        for (const Node& child : node.children) {
+            stack.push_back(&child);
+        }
+    }
+    EXPECT_EQ(declared, 2);
+    EXPECT_EQ(addresses, 2);
+
+    CodeGenerator generator;
+    string code = generator.generateCode(ast);
+    EXPECT_TRUE(hasLine(code, "int* pointer_2;")) << code;
+    EXPECT_TRUE(hasLine(code, "cout << pointer_2[0] << endl;")) << code;
+}
+
+// Test that every name in the rewritten tree, temporaries and folded Booleans included,
+// carries its id from the tokenizer's table
+TEST(OptimizerTest, InternTemporaryNames) {
+    string input = "Declare n As Integer\n"
+                   "Declare total As Integer\n"
+                   "Declare grid As Array Of Integer[3][4]\n"
+                   "Read n\n"
+                   "Assign total = 0\n"
+                   "For i = 0 To 2 Do\n"
+                   "    For j = 0 To 3 Do\n"
+                   "        Assign grid[i][j] = i * 4 + n * n\n"
+                   "        Assign total = total + grid[i][j]\n"
+                   "    End For\n"
+                   "End For\n"
+                   "While total > n * 2 And 1 < 2 Do\n"
+                   "    Assign total = total - 1\n"
+                   "End While\n";
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    Optimizer optimizer(Optimizer::allPasses);
+    optimizer.optimize(ast, tokenizer.identifierTable());
+    EXPECT_GT(optimizer.stats().temporaries, 0);
+    EXPECT_GT(optimizer.stats().pointers, 0);
+
+    const IdentifierTable& identifiers = tokenizer.identifierTable();
+    vector<const Node*> stack = { &ast };
+    while (!stack.empty()) {
+        const Node& node = *stack.back();
+        stack.pop_back();
+        if (node.token.type == TokenType::IDENTIFIER) {
+            ASSERT_LT(node.token.id, identifiers.distinctCount()) << node.token.lexeme;
+            EXPECT_EQ(identifiers.name(node.token.id), node.token.lexeme);
+        }
+        for (const Node& child : node.children) {
+            stack.push_back(&child);
+        }
+    }
+}
@@ -94,11 +94,12 @@ TEST(ParserTest, ParseIfStatement) {
     EXPECT_EQ(ifNode.type, NodeType::IF_STATEMENT);
     ASSERT_EQ(ifNode.children.size(), 3); // Condition, If Block, Else Block
 
-    // Check the condition
-    Node condition = ifNode.children[0];
+    // Check the condition: one binary node inside the expression slot
+    Node condition = ifNode.children[0].children[0];
+    EXPECT_EQ(condition.type, NodeType::BINARY_EXPRESSION);
+    EXPECT_EQ(condition.token.lexeme, ">");
     EXPECT_EQ(condition.children[0].token.lexeme, "x");
-    EXPECT_EQ(condition.children[1].token.lexeme, ">");
-    EXPECT_EQ(condition.children[2].token.lexeme, "0");
+    EXPECT_EQ(condition.children[1].token.lexeme, "0");
 
     // Check the if block
     Node ifBlock = ifNode.children[1];
@@ -128,11 +129,12 @@ TEST(ParserTest, ParseForLoop) {
     EXPECT_EQ(forNode.type, NodeType::FOR_LOOP);
     ASSERT_EQ(forNode.children.size(), 3); // Start Condition, End Condition, For Block
 
-    // Check start condition
+    // Check start condition: an assignment to the loop variable
     Node startCondition = forNode.children[0];
+    EXPECT_EQ(startCondition.type, NodeType::ASSIGNMENT);
     EXPECT_EQ(startCondition.children[0].token.lexeme, "i");
     EXPECT_EQ(startCondition.children[1].token.lexeme, "=");
-    EXPECT_EQ(startCondition.children[2].token.lexeme, "0");
+    EXPECT_EQ(startCondition.children[2].children[0].token.lexeme, "0");
 
     // Check end condition
     Node endCondition = forNode.children[1];
@@ -162,13 +164,536 @@ TEST(ParserTest, ParseWhileLoop) {
     ASSERT_EQ(whileNode.children.size(), 2); // Condition, While Block
 
     // Check the condition
-    Node condition = whileNode.children[0];
+    Node condition = whileNode.children[0].children[0];
+    EXPECT_EQ(condition.type, NodeType::BINARY_EXPRESSION);
+    EXPECT_EQ(condition.token.lexeme, "<");
     EXPECT_EQ(condition.children[0].token.lexeme, "x");
-    EXPECT_EQ(condition.children[1].token.lexeme, "<");
-    EXPECT_EQ(condition.children[2].token.lexeme, "10");
+    EXPECT_EQ(condition.children[1].token.lexeme, "10");
 
     // Check the while block
     Node whileBlock = whileNode.children[1];
     ASSERT_EQ(whileBlock.children.size(), 1);
     EXPECT_EQ(whileBlock.children[0].children[0].token.lexeme, "x"); // Print x
 }
+
+// Test parsing straight from the tokenizer without a token vector
+TEST(ParserTest, ParseFromTokenStream) {
+    string input = R"(
+        Declare x As Integer
+        While x < 10 Do
+            Assign x = x + 1
+        End While
+    )";
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+
+    Node ast = parser.parse();
+    ASSERT_EQ(ast.children.size(), 2);
+    EXPECT_EQ(ast.children[0].type, NodeType::DECLARATION);
+    EXPECT_EQ(ast.children[0].children[0].token.lexeme, "x");
+
+    Node whileNode = ast.children[1];
+    EXPECT_EQ(whileNode.type, NodeType::WHILE_LOOP);
+    ASSERT_EQ(whileNode.children.size(), 2);
+    EXPECT_EQ(whileNode.children[0].children[0].children[1].token.lexeme, "10");
+    EXPECT_EQ(whileNode.children[1].children[0].type, NodeType::ASSIGNMENT);
+}
+
+// Test parsing from compact token storage
+TEST(ParserTest, ParseFromTokenStore) {
+    string input = R"(
+        For i = 0 To 5 Do
+            Assign arr[i] = i * 2
+        End For
+    )";
+    Tokenizer tokenizer(input);
+    TokenStore store = tokenizer.tokenizeCompact();
+    Parser parser(store);
+
+    Node ast = parser.parse();
+    ASSERT_EQ(ast.children.size(), 1);
+    Node forNode = ast.children[0];
+    EXPECT_EQ(forNode.type, NodeType::FOR_LOOP);
+    ASSERT_EQ(forNode.children.size(), 3);
+    EXPECT_EQ(forNode.children[0].children[0].token.lexeme, "i");
+    EXPECT_EQ(forNode.children[1].children[0].token.lexeme, "5");
+
+    Node assignment = forNode.children[2].children[0];
+    EXPECT_EQ(assignment.type, NodeType::ASSIGNMENT);
+    EXPECT_EQ(assignment.children[0].token.lexeme, "arr");
+    EXPECT_EQ(assignment.children[1].token.lexeme, "i");
+}
+
+// Test that parse errors point at the offending token's line and column
+TEST(ParserTest, ErrorLocation) {
+    string input = "Declare x As Integer\n  Assign x = 1\n    Else";
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+
+    try {
+        parser.parse();
+        FAIL() << "expected a parse error";
+    } catch (const runtime_error& error) {
+        EXPECT_STREQ(error.what(), "Unexpected token: Else at line 3, column 5");
+    }
+
+    // Without the source there is no location to report
+    Parser sourceless(tokenizeInput(input));
+    try {
+        sourceless.parse();
+        FAIL() << "expected a parse error";
+    } catch (const runtime_error& error) {
+        EXPECT_STREQ(error.what(), "Unexpected token: Else");
+    }
+}
+
+// Test that the tree lives in the parser's arena and survives the parser once taken
+TEST(ParserTest, ParseIntoArena) {
+    string input = R"(
+        Declare x As Integer
+        While x < 10 Do
+            If x > 5 Then
+                Print x
+            Else
+                Assign x = x + 1
+            End If
+        End While
+    )";
+    AstArena arena;
+    Node ast(NodeType::BLOCK, Token());
+    {
+        Parser parser(tokenizeInput(input), input);
+        ast = parser.parse();
+        arena = parser.takeArena();
+    }
+
+    // Root(2) + Declare(2) + While(2) + condition(1 + 2) + block(1) + If(3) + condition(1 + 2)
+    // + Print(1) + x + Else(1) + Assign(3) + expression(1 + 2)
+    EXPECT_EQ(arena.nodeCount(), 25);
+    EXPECT_EQ(arena.blockCount(), 1);
+
+    ASSERT_EQ(ast.children.size(), 2);
+    Node& ifNode = ast.children[1].children[1].children[0];
+    EXPECT_EQ(ifNode.type, NodeType::IF_STATEMENT);
+    ASSERT_EQ(ifNode.children.size(), 3);
+    EXPECT_EQ(ifNode.children[1].children[0].children[0].token.lexeme, "x");
+    EXPECT_EQ(ifNode.children[2].children[0].children.back().children[0].children.size(), 2);
+
+    // A list too long for a shared block gets one of its own
+    string many;
+    for (int ind = 0; ind < 1000; ind++) {
+        many += "Print x\n";
+    }
+    Parser parser(tokenizeInput(many));
+    EXPECT_EQ(parser.parse().children.size(), 1000);
+    AstArena manyArena = parser.takeArena();
+    EXPECT_EQ(manyArena.nodeCount(), 2000);
+    EXPECT_EQ(manyArena.blockCount(), 2);
+}
+
+// Check that two trees have the same shape, types and lexemes
+void expectSameTree(const Node& expected, const Node& actual) {
+    EXPECT_EQ(actual.type, expected.type);
+    EXPECT_EQ(actual.token.lexeme, expected.token.lexeme);
+    ASSERT_EQ(actual.children.size(), expected.children.size());
+    for (size_t ind = 0; ind < expected.children.size(); ind++) {
+        expectSameTree(expected.children[ind], actual.children[ind]);
+    }
+}
+
+// Test the flat pre-order encoding and the conversion back to a tree
+TEST(ParserTest, FlatAstRoundTrip) {
+    string input = R"(
+        Declare x As Integer
+        If x > 5 Then
+            Print x, "big"
+        Else
+            Assign x = x + 1
+        End If
+    )";
+    Parser parser(tokenizeInput(input));
+    Node ast = parser.parse();
+    FlatAst flat = FlatAst::fromTree(ast);
+
+    // Root, Declare(x, Integer), If(condition(x > 5), block(Print(x, "big")),
+    // block(Assign(x, =, expression(x + 1))))
+    ASSERT_EQ(flat.size(), 21);
+    EXPECT_EQ(flat.node(0).subtreeSize, 21);
+    EXPECT_EQ(flat.node(1).type, NodeType::DECLARATION);
+    EXPECT_EQ(flat.node(1).subtreeSize, 3);
+    EXPECT_EQ(flat.node(4).type, NodeType::IF_STATEMENT);
+    EXPECT_EQ(flat.node(4).subtreeSize, 17);
+    EXPECT_EQ(flat.token(2).lexeme, "x");
+
+    FlatNodeRef root = flat.root();
+    ASSERT_EQ(root.children.size(), 2);
+    FlatNodeRef ifNode = root.children[1];
+    ASSERT_EQ(ifNode.children.size(), 3);
+    EXPECT_EQ(ifNode.children[1].children[0].children[1].token.lexeme, "big");
+    EXPECT_EQ(ifNode.children[2].children[0].children[2].children[0].children.size(), 2);
+
+    AstArena arena;
+    Node rebuilt = flat.toTree(arena);
+    expectSameTree(ast, rebuilt);
+    EXPECT_EQ(arena.nodeCount(), 20);
+
+    FlatAst parsedFlat = Parser(tokenizeInput(input)).parseFlat();
+    ASSERT_EQ(parsedFlat.size(), flat.size());
+    for (size_t ind = 0; ind < flat.size(); ind++) {
+        EXPECT_EQ(parsedFlat.node(ind).type, flat.node(ind).type);
+        EXPECT_EQ(parsedFlat.node(ind).subtreeSize, flat.node(ind).subtreeSize);
+        EXPECT_EQ(parsedFlat.token(ind).lexeme, flat.token(ind).lexeme);
+    }
+}
+
+// Render an expression tree fully parenthesized, for checking its shape
+string shape(const Node& node) {
+    switch (node.type) {
+        case NodeType::BINARY_EXPRESSION:
+            return "(" + shape(node.children[0]) + " " + string(node.token.lexeme) + " " + shape(node.children[1]) + ")";
+        case NodeType::UNARY_EXPRESSION:
+            return "(" + string(node.token.lexeme) + shape(node.children[0]) + ")";
+        case NodeType::INDEX_EXPRESSION:
+            return shape(node.children[0]) + "[" + shape(node.children[1]) + "]";
+        case NodeType::CALL_EXPRESSION: {
+            string call = shape(node.children[0]) + "(";
+            for (size_t ind = 1; ind < node.children.size(); ind++) {
+                call += (ind > 1 ? ", " : "") + shape(node.children[ind]);
+            }
+            return call + ")";
+        }
+        default:
+            return string(node.token.lexeme);
+    }
+}
+
+// Parse `Assign r = <expression>` and return the shape of the expression
+string parseShape(const string& expression) {
+    string input = "Assign r = " + expression;
+    Parser parser(tokenizeInput(input));
+    Node ast = parser.parse();
+    return shape(ast.children[0].children[2].children[0]);
+}
+
+// Test operator precedence and associativity in expressions
+TEST(ParserTest, ParseExpressionPrecedence) {
+    EXPECT_EQ(parseShape("x + 5 * 3"), "(x + (5 * 3))");
+    EXPECT_EQ(parseShape("(x + 5) * 3"), "((x + 5) * 3)");
+    EXPECT_EQ(parseShape("a - b - c"), "((a - b) - c)");
+    EXPECT_EQ(parseShape("a / b * c"), "((a / b) * c)");
+    EXPECT_EQ(parseShape("-a * b"), "((-a) * b)");
+    EXPECT_EQ(parseShape("x = 3 + 4"), "(x == (3 + 4))");
+    EXPECT_EQ(parseShape("a <> b"), "(a != b)");
+    EXPECT_EQ(parseShape("a < b And c >= d Or e"), "(((a < b) && (c >= d)) || e)");
+    EXPECT_EQ(parseShape("a Or b And c"), "(a || (b && c))");
+    EXPECT_EQ(parseShape("Not x = 3 And y"), "((!(x == 3)) && y)");
+    EXPECT_EQ(parseShape("a && b || c"), "((a && b) || c)");
+    EXPECT_EQ(parseShape("m[i + 1][j] * 2"), "(m[(i + 1)][j] * 2)");
+    EXPECT_EQ(parseShape("f(a, b * 2) + g()"), "(f(a, (b * 2)) + g())");
+}
+
+// Test that a long operator chain parses in one left-leaning pass
+TEST(ParserTest, ParseLongExpressionChain) {
+    string expression = "x0";
+    for (int ind = 1; ind < 20000; ind++) {
+        expression += (ind % 2 ? " + x" : " * x") + to_string(ind);
+    }
+    string input = "Assign r = " + expression;
+    Parser parser(tokenizeInput(input));
+    Node ast = parser.parse();
+
+    // x0 + x1 * x2 + x3 * x4 ...: a left spine of + nodes, each with a * on the right
+    Node node = ast.children[0].children[2].children[0];
+    size_t additions = 0;
+    while (node.type == NodeType::BINARY_EXPRESSION && node.token.lexeme == "+") {
+        additions++;
+        node = node.children[0];
+    }
+    EXPECT_EQ(additions, 10000);
+    EXPECT_EQ(node.token.lexeme, "x0");
+}
+
+// Test that malformed expressions are reported
+TEST(ParserTest, ParseExpressionErrors) {
+    EXPECT_THROW(Parser(tokenizeInput("Assign r = (a + b")).parse(), runtime_error);
+    EXPECT_THROW(Parser(tokenizeInput("Assign r = a +")).parse(), runtime_error);
+    EXPECT_THROW(Parser(tokenizeInput("If a * Then Print a End If")).parse(), runtime_error);
+}
+
+// Test that nesting far deeper than the call stack allows still parses, flattens and prints
+TEST(ParserTest, ParseDeepNesting) {
+    const int depth = 100000;
+    string input;
+    for (int level = 0; level < depth; level++) {
+        input += level % 2 ? "While x > 0 Do\n" : "If x > 0 Then\nPrint x\nElse\n";
+    }
+    for (int level = depth - 1; level >= 0; level--) {
+        input += level % 2 ? "End While\n" : "End If\n";
+    }
+    Parser parser(tokenizeInput(input));
+    Node ast = parser.parse();
+
+    // Each level is the last statement of the block it sits in
+    int levels = 0;
+    Node node = ast;
+    while (!node.children.empty()) {
+        node = node.children.back();
+        if (node.type == NodeType::IF_STATEMENT || node.type == NodeType::WHILE_LOOP) levels++;
+    }
+    EXPECT_EQ(levels, depth);
+
+    // expectSameTree recurses, so compare the flat encodings instead
+    FlatAst flat = FlatAst::fromTree(ast);
+    AstArena arena;
+    FlatAst roundTrip = FlatAst::fromTree(flat.toTree(arena));
+    ASSERT_EQ(roundTrip.size(), flat.size());
+    for (size_t ind = 0; ind < flat.size(); ind++) {
+        ASSERT_EQ(roundTrip.node(ind).type, flat.node(ind).type);
+        ASSERT_EQ(roundTrip.node(ind).subtreeSize, flat.node(ind).subtreeSize);
+        ASSERT_EQ(roundTrip.token(ind).lexeme, flat.token(ind).lexeme);
+    }
+
+    testing::internal::CaptureStdout();
+    printAST(ast);
+    string printed = testing::internal::GetCapturedStdout();
+    EXPECT_EQ(printed.find("\n" + string(2 * (maxIndentLevel + 1), ' ')), string::npos);
+
+    EXPECT_THROW(Parser(tokenizeInput("While x Do\nIf x Then\nEnd While\nEnd If")).parse(), runtime_error);
+    EXPECT_THROW(Parser(tokenizeInput("If x Then\nElse\nElse\nEnd If")).parse(), runtime_error);
+    EXPECT_THROW(Parser(tokenizeInput("For i = 1 To 3 Do\nElse\nEnd For")).parse(), runtime_error);
+    EXPECT_THROW(Parser(tokenizeInput("While x Do\nIf x Then\nEnd If")).parse(), runtime_error);
+}
+
+// Test that recovery reports every error with its location and keeps the good statements
+TEST(ParserTest, RecoverFromErrors) {
+    string input =
+        "Declare x As Integer\n"          // 1
+        "Assign x = \n"                   // 2: missing value
+        "Declare y As Integer\n"          // 3
+        "If x > Then\n"                   // 4: broken header, body still checked
+        "    Print x\n"                   // 5
+        "    Assign = 3\n"                // 6: missing target
+        "End If\n"                        // 7
+        "While y < 3 Do\n"                // 8
+        "    Assign y = y + 1\n"          // 9
+        "End For\n"                       // 10: wrong End
+        "End While\n"                     // 11: stray End
+        "Print y\n"                       // 12
+        "For i = 1 To 3 Do\n"             // 13
+        "    Print i\n";                  // 14: no End For
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    vector<Diagnostic> diagnostics;
+    Node ast = parser.parse(diagnostics);
+
+    vector<string> expected = {
+        "Unexpected token: Declare at line 3, column 1",
+        "Unexpected token: Then at line 4, column 8",
+        "Unexpected token: = at line 6, column 12",
+        "Unexpected token: For at line 10, column 5, expected While",
+        "Unexpected token: End at line 11, column 1",
+        "Unexpected end of input at line 15, column 1, expected End For",
+    };
+    ASSERT_EQ(diagnostics.size(), expected.size());
+    for (size_t ind = 0; ind < expected.size(); ind++) {
+        EXPECT_EQ(diagnostics[ind].message, expected[ind]);
+    }
+    EXPECT_EQ(diagnostics[1].offset, input.find("Then"));
+
+    // The failed Assign and the broken If are dropped, the rest is kept
+    vector<NodeType> types;
+    for (const auto& statement : ast.children) {
+        types.push_back(statement.type);
+    }
+    EXPECT_EQ(types, (vector<NodeType>{ NodeType::DECLARATION, NodeType::DECLARATION, NodeType::WHILE_LOOP,
+                                        NodeType::PRINT, NodeType::FOR_LOOP }));
+
+    // Without recovery the first error is thrown
+    try {
+        Parser(tokenizeInput(input), input).parse();
+        FAIL() << "expected a parse error";
+    } catch (const ParseError& error) {
+        EXPECT_EQ(error.diagnostic.message, expected[0]);
+        EXPECT_EQ(error.diagnostic.offset, input.find("Declare y"));
+    }
+
+    // A Do whose closing While fails is closed by it, not left open under a new While
+    vector<Diagnostic> doDiagnostics;
+    Node doAst = Parser(tokenizeInput("Do\nAssign x = 1\nWhile x <\nPrint x\n")).parse(doDiagnostics);
+    ASSERT_EQ(doDiagnostics.size(), 1);
+    EXPECT_EQ(doDiagnostics[0].message, "Unexpected token: Print");
+    ASSERT_EQ(doAst.children.size(), 1);
+    EXPECT_EQ(doAst.children[0].type, NodeType::PRINT);
+
+    // Statements left open at end of input are reported once, not once per level
+    string unclosed =
+        "Declare x As Integer\nAssign x = 0\n"
+        "Do\nAssign x = x + 1\nWhile x < 3\n"
+        "Do\nAssign x = x - 1\nWhile x > 0\n"
+        "Print x\n";
+    vector<Diagnostic> unclosedDiagnostics;
+    Parser(tokenizeInput(unclosed), unclosed).parse(unclosedDiagnostics);
+    ASSERT_EQ(unclosedDiagnostics.size(), 2);
+    EXPECT_EQ(unclosedDiagnostics[0].offset, unclosed.find("Print x"));
+    EXPECT_EQ(unclosedDiagnostics[1].offset, unclosed.size());
+
+    // Valid input gives the same tree and no diagnostics
+    string valid = "Declare x As Integer\nIf x > 1 Then\nPrint x\nElse\nAssign x = 2\nEnd If";
+    vector<Diagnostic> none;
+    Parser recovering(tokenizeInput(valid));
+    Parser throwing(tokenizeInput(valid));
+    expectSameTree(throwing.parse(), recovering.parse(none));
+    EXPECT_TRUE(none.empty());
+}
+
+// Test that parsing top-level statements on several threads gives the serial tree and errors
+TEST(ParserTest, ParseInParallel) {
+    string program =
+        "Declare x As Integer\n"
+        "Assign x = 1\n"
+        "If x > 0 Then\n"
+        "    While x < 10 Do\n"
+        "        If x = 5 Then\n"
+        "            Print \"five\"\n"
+        "        Else\n"
+        "            Print x\n"
+        "        End If\n"
+        "        Assign x = x + 1\n"
+        "    End While\n"
+        "End If\n"
+        "For i = 1 To 3 Do\n"
+        "    Print i\n"
+        "End For\n";
+    string input;
+    for (int copy = 0; copy < 100; copy++) {
+        input += program;
+    }
+    vector<Token> tokens = tokenizeInput(input);
+
+    Parser serial(tokens);
+    FlatAst expected = FlatAst::fromTree(serial.parse());
+    for (size_t threads : { 1, 2, 3, 8 }) {
+        Parser parallel(tokens);
+        FlatAst actual = FlatAst::fromTree(parallel.parseParallel(threads, 16));
+        ASSERT_EQ(actual.size(), expected.size()) << threads << " threads";
+        for (size_t ind = 0; ind < expected.size(); ind++) {
+            ASSERT_EQ(actual.node(ind).type, expected.node(ind).type);
+            ASSERT_EQ(actual.node(ind).subtreeSize, expected.node(ind).subtreeSize);
+            ASSERT_EQ(actual.token(ind).offset, expected.token(ind).offset);
+        }
+    }
+
+    // A syntax error anywhere, balanced or not, is reported as the serial parser does
+    for (const string& broken : { input + "Assign = 2\n" + input, input + "End While\n" + input,
+                                  "Print x\n" + program + "If x Then\n" + input }) {
+        vector<Token> brokenTokens = tokenizeInput(broken);
+        string serialError, parallelError;
+        try {
+            Parser(brokenTokens, broken).parse();
+        } catch (const ParseError& error) {
+            serialError = error.what();
+        }
+        try {
+            Parser(brokenTokens, broken).parseParallel(4, 16);
+        } catch (const ParseError& error) {
+            parallelError = error.what();
+        }
+        EXPECT_FALSE(serialError.empty());
+        EXPECT_EQ(parallelError, serialError);
+    }
+}
+
+// Else If, Do ... While and Read come from the grammar table like the other statements
+TEST(ParserTest, ParseGrammarExtensions) {
+    string program =
+        "Declare x As Integer\n"
+        "Read x\n"
+        "If x < 0 Then\n"
+        "    Print \"negative\"\n"
+        "Else If x = 0 Then\n"
+        "    Print \"zero\"\n"
+        "Else If x < 10 Then\n"
+        "    Print \"small\"\n"
+        "Else\n"
+        "    If x > 100 Then\n"
+        "        Print \"big\"\n"
+        "    End If\n"
+        "End If\n"
+        "Do\n"
+        "    While x > 5 Do\n"
+        "        Assign x = x - 1\n"
+        "    End While\n"
+        "    Assign x = x + 2\n"
+        "While x < 20\n"
+        "Print x\n";
+    Parser parser(tokenizeInput(program));
+    Node ast = parser.parse();
+    ASSERT_EQ(ast.children.size(), 5);
+
+    Node read = ast.children[1];
+    EXPECT_EQ(read.type, NodeType::READ);
+    ASSERT_EQ(read.children.size(), 1);
+    EXPECT_EQ(read.children[0].token.lexeme, "x");
+
+    // Each Else If is an If inside the Else block of the one before, closed by one End If
+    Node ifNode = ast.children[2];
+    ASSERT_EQ(ifNode.type, NodeType::IF_STATEMENT);
+    int chain = 0;
+    while (ifNode.children.size() == 3 && ifNode.children[2].children.size() == 1 &&
+           ifNode.children[2].children[0].token.lexeme == "Else If") {
+        ifNode = ifNode.children[2].children[0];
+        EXPECT_EQ(ifNode.type, NodeType::IF_STATEMENT);
+        chain++;
+    }
+    EXPECT_EQ(chain, 2);
+    ASSERT_EQ(ifNode.children.size(), 3);
+    EXPECT_EQ(ifNode.children[0].children[0].children[1].token.lexeme, "10");
+    // An If on the line after Else is nested, with an End If of its own
+    ASSERT_EQ(ifNode.children[2].children.size(), 1);
+    EXPECT_EQ(ifNode.children[2].children[0].token.lexeme, "If");
+
+    // A Do keeps its condition first and its body second, like a While
+    Node doWhile = ast.children[3];
+    ASSERT_EQ(doWhile.type, NodeType::DO_WHILE_LOOP);
+    ASSERT_EQ(doWhile.children.size(), 2);
+    EXPECT_EQ(doWhile.children[0].children[0].token.lexeme, "<");
+    ASSERT_EQ(doWhile.children[1].children.size(), 2);
+    EXPECT_EQ(doWhile.children[1].children[0].type, NodeType::WHILE_LOOP);
+    EXPECT_EQ(ast.children[4].type, NodeType::PRINT);
+
+    // The pre-scan of the parallel parse finds the same statement boundaries
+    string input;
+    for (int copy = 0; copy < 50; copy++) {
+        input += program;
+    }
+    vector<Token> tokens = tokenizeInput(input);
+    FlatAst expected = FlatAst::fromTree(Parser(tokens).parse());
+    Parser parallel(tokens);
+    FlatAst actual = FlatAst::fromTree(parallel.parseParallel(4, 16));
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t ind = 0; ind < expected.size(); ind++) {
+        ASSERT_EQ(actual.node(ind).type, expected.node(ind).type);
+        ASSERT_EQ(actual.token(ind).offset, expected.token(ind).offset);
+    }
+}
+
+// Headers check which keyword they get, not only that it is one
+TEST(ParserTest, ParseKeywordChecks) {
+    vector<pair<string, string>> cases = {
+        { "If x > 1 Do\nPrint x\nEnd If", "Unexpected token: Do at line 1, column 10, expected Then" },
+        { "For i = 1 Do 3 Do\nPrint i\nEnd For", "Unexpected token: Do at line 1, column 11, expected To" },
+        { "Declare x Of Integer", "Unexpected token: Of at line 1, column 11, expected As" },
+        { "While x < 3\nPrint x\nEnd While", "Unexpected token: Print at line 2, column 1, expected Do" },
+        { "Do\nPrint x\nEnd While", "Unexpected token: End at line 3, column 1" },
+        { "Do\nPrint x\n", "Unexpected end of input at line 3, column 1, expected While" },
+        { "If x > 1 Then\nElse\nElse If x Then\nEnd If", "Unexpected token: Else If at line 3, column 1" },
+    };
+    for (const auto& [input, message] : cases) {
+        try {
+            Parser(tokenizeInput(input), input).parse();
+            ADD_FAILURE() << "expected a parse error for " << input;
+        } catch (const ParseError& error) {
+            EXPECT_EQ(error.diagnostic.message, message);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# Ensure the script stops on any error
+set -e
+
+# Define paths for source files and the output executable
+PARSER_SRC="../../src/parser/parser.cpp"
+SEMANTIC_SRC="../../src/semantic/semantic.cpp"
+TEST_SEMANTIC_SRC="test_semantic.cpp"
+OUTPUT_EXEC="semantic_test"
+
+# Define the path to GoogleTest
+GTEST_INCLUDE_PATH="/usr/include/gtest"
+GTEST_LIB_PATH="/usr/lib/x86_64-linux-gnu"
+
+# Step 1: Compile the source files and tests
+echo "Compiling SemanticAnalyzer and test files..."
+g++ -std=c++17 -isystem $GTEST_INCLUDE_PATH -pthread $PARSER_SRC $SEMANTIC_SRC $TEST_SEMANTIC_SRC -lgtest -lgtest_main -o $OUTPUT_EXEC -L$GTEST_LIB_PATH
+
+# Step 2: Run the tests
+echo "Running tests..."
+./$OUTPUT_EXEC
+
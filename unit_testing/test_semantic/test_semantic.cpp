@@ -0,0 +1,168 @@
+#include "../../src/semantic/semantic.h" // Header for the SemanticAnalyzer class
+#include <gtest/gtest.h> // GoogleTest header
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+// Helper function to parse and check a program, returning the semantic error messages
+vector<string> checkProgram(const string& input) {
+    Tokenizer tokenizer(input);
+    Parser parser(tokenizer);
+    Node ast = parser.parse();
+    SemanticAnalyzer analyzer(input);
+    vector<string> messages;
+    for (const Diagnostic& diagnostic : analyzer.analyze(ast)) {
+        messages.push_back(diagnostic.message);
+    }
+    return messages;
+}
+
+// The sample programs are well formed
+TEST(SemanticTest, AcceptSamplePrograms) {
+    for (const string path : { "../../src/pseudocode/pseudocode.txt", "../../src/pseudocode/pseudocode2.txt" }) {
+        ifstream inputFile(path);
+        ASSERT_TRUE(inputFile) << path;
+        stringstream buffer;
+        buffer << inputFile.rdbuf();
+        EXPECT_TRUE(checkProgram(buffer.str()).empty()) << path;
+    }
+}
+
+// Test variables used before they are declared
+TEST(SemanticTest, UndeclaredVariable) {
+    string input = "Declare x As Integer\n"
+                   "Assign x = y + 1\n"
+                   "Print z\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 2);
+    EXPECT_EQ(messages[0], "Undeclared variable: y at line 2, column 12");
+    EXPECT_EQ(messages[1], "Undeclared variable: z at line 3, column 7");
+}
+
+// Test a name declared twice in the same scope
+TEST(SemanticTest, Redeclaration) {
+    string input = "Declare x As Integer\n"
+                   "Declare x As String\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages[0], "Redeclared variable: x at line 2, column 9, first declared at line 1, column 9");
+}
+
+// Test that blocks open scopes: inner declarations shadow outer ones and end with the block
+TEST(SemanticTest, BlockScopes) {
+    string input = "Declare x As Integer\n"
+                   "If x > 1 Then\n"
+                   "    Declare x As String\n"
+                   "    Declare y As Integer\n"
+                   "    Assign x = \"inner\"\n"
+                   "Else\n"
+                   "    Declare y As String\n"
+                   "End If\n"
+                   "Assign x = 2\n"
+                   "Assign y = 3\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages[0], "Undeclared variable: y at line 10, column 8");
+}
+
+// Test assigning a value of the wrong type
+TEST(SemanticTest, AssignmentTypeMismatch) {
+    string input = "Declare x As Integer\n"
+                   "Declare str As String\n"
+                   "Declare concatResult As String\n"
+                   "Declare arr As Array Of Integer[5]\n"
+                   "Assign concatResult = str + \" \" + str\n"
+                   "Assign concatResult = x\n"
+                   "Assign arr[1] = str\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 2);
+    EXPECT_EQ(messages[0], "Type mismatch: cannot assign Integer to String concatResult at line 6, column 8");
+    EXPECT_EQ(messages[1], "Type mismatch: cannot assign String to Integer arr at line 7, column 8");
+}
+
+// Test operators, conditions and indices with operands of the wrong type
+TEST(SemanticTest, OperandTypes) {
+    string input = "Declare x As Integer\n"
+                   "Declare str As String\n"
+                   "Declare arr As Array Of Integer[5]\n"
+                   "Assign x = x + str\n"
+                   "If x Then\n"
+                   "    Print arr[str]\n"
+                   "End If\n"
+                   "While str < x Do\n"
+                   "End While\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 4);
+    EXPECT_EQ(messages[0], "Type mismatch: Integer + String at line 4, column 14");
+    EXPECT_EQ(messages[1], "Condition is Integer, expected Boolean at line 5, column 4");
+    EXPECT_EQ(messages[2], "Index is String, expected Integer at line 6, column 15");
+    EXPECT_EQ(messages[3], "Type mismatch: String < Integer at line 8, column 11");
+}
+
+// Test that a For declares its loop variable for the body only
+TEST(SemanticTest, ForLoopVariable) {
+    string input = "For k = 0 To 3 Do\n"
+                   "    Print k\n"
+                   "End For\n"
+                   "Print k\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages[0], "Undeclared variable: k at line 4, column 7");
+}
+
+// Test that a Do condition sees the names in scope after the body, not the body's own
+TEST(SemanticTest, DoWhileConditionScope) {
+    string input = "Declare n As Integer\n"
+                   "Do\n"
+                   "    Declare k As Integer\n"
+                   "    Assign n = n + 1\n"
+                   "While k < n\n";
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages[0], "Undeclared variable: k at line 5, column 7");
+}
+
+// Deep nesting and long operator chains are walked without recursion
+TEST(SemanticTest, DeepNestingAndLongExpressions) {
+    const int depth = 20000;
+    string input = "Declare x As Integer\n";
+    for (int level = 0; level < depth; level++) {
+        input += "If x < 1 Then\n";
+    }
+    input += "Assign x = 1";
+    for (int term = 0; term < depth; term++) {
+        input += " + x";
+    }
+    input += "\nPrint missing\n";
+    for (int level = 0; level < depth; level++) {
+        input += "End If\n";
+    }
+    auto messages = checkProgram(input);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages[0], "Undeclared variable: missing at line 20003, column 7");
+}
+
+// Many names, shadowed at several depths, keep resolving to the innermost declaration
+TEST(SemanticTest, SymbolTableGrowthAndShadowing) {
+    SymbolTable symbols;
+    symbols.pushScope();
+    Token name = { TokenType::IDENTIFIER, "v", 0, 0 };
+    for (uint32_t key = 0; key < 5000; key++) {
+        EXPECT_EQ(symbols.declare(key, name, { ValueType::INTEGER, 0 }), nullptr);
+    }
+    symbols.pushScope();
+    for (uint32_t key = 0; key < 5000; key += 2) {
+        EXPECT_EQ(symbols.declare(key, name, { ValueType::STRING, 0 }), nullptr);
+    }
+    EXPECT_NE(symbols.declare(10, name, { ValueType::BOOLEAN, 0 }), nullptr);
+    EXPECT_EQ(symbols.lookup(10)->type.element, ValueType::STRING);
+    EXPECT_EQ(symbols.lookup(11)->type.element, ValueType::INTEGER);
+    EXPECT_EQ(symbols.lookup(5000), nullptr);
+    symbols.popScope();
+    for (uint32_t key = 0; key < 5000; key++) {
+        ASSERT_NE(symbols.lookup(key), nullptr);
+        EXPECT_EQ(symbols.lookup(key)->type.element, ValueType::INTEGER);
+    }
+    symbols.popScope();
+    EXPECT_EQ(symbols.lookup(0), nullptr);
+}
@@ -38,7 +38,7 @@ TEST(TokenizerTest, TokenizeIdentifier) {
     auto tokens = tokenizer.tokenize();
 
     // Verify the total number of tokens
-    ASSERT_EQ(tokens.size(), 65); 
+    ASSERT_EQ(tokens.size(), 69); 
 
     // Verify keywords and identifiers
     EXPECT_EQ(tokens[0].type, TokenType::DECLARE);    // Declare
@@ -52,70 +52,74 @@ TEST(TokenizerTest, TokenizeIdentifier) {
     EXPECT_EQ(tokens[7].type, TokenType::ARRAY);      // Array
     EXPECT_EQ(tokens[8].type, TokenType::KEYWORD);    // Of
     EXPECT_EQ(tokens[9].type, TokenType::INTEGER);    // Integer
-    EXPECT_EQ(tokens[10].type, TokenType::NUMBER);    // 5
+    EXPECT_EQ(tokens[10].type, TokenType::PUNCTUATION); // [
+    EXPECT_EQ(tokens[11].type, TokenType::NUMBER);    // 5
+    EXPECT_EQ(tokens[12].type, TokenType::PUNCTUATION); // ]
 
     // Verify assignments
-    EXPECT_EQ(tokens[11].type, TokenType::ASSIGN);    // Assign
-    EXPECT_EQ(tokens[12].type, TokenType::IDENTIFIER); // x
-    EXPECT_EQ(tokens[13].type, TokenType::OPERATOR);  // =
-    EXPECT_EQ(tokens[14].type, TokenType::NUMBER);    // 5
+    EXPECT_EQ(tokens[13].type, TokenType::ASSIGN);    // Assign
+    EXPECT_EQ(tokens[14].type, TokenType::IDENTIFIER); // x
+    EXPECT_EQ(tokens[15].type, TokenType::OPERATOR);  // =
+    EXPECT_EQ(tokens[16].type, TokenType::NUMBER);    // 5
 
     // Verify print statement
-    EXPECT_EQ(tokens[15].type, TokenType::PRINT);     // Print
-    EXPECT_EQ(tokens[16].type, TokenType::STRINGVAL); // Hello
+    EXPECT_EQ(tokens[17].type, TokenType::PRINT);     // Print
+    EXPECT_EQ(tokens[18].type, TokenType::STRINGVAL); // Hello
 
     // Verify conditional keywords
-    EXPECT_EQ(tokens[17].type, TokenType::IF);        // If
-    EXPECT_EQ(tokens[18].type, TokenType::IDENTIFIER); // x
-    EXPECT_EQ(tokens[19].type, TokenType::OPERATOR);  // >
-    EXPECT_EQ(tokens[20].type, TokenType::NUMBER);    // 0
-    EXPECT_EQ(tokens[21].type, TokenType::KEYWORD);   // Then
-
-    EXPECT_EQ(tokens[22].type, TokenType::ASSIGN);    // Assign
-    EXPECT_EQ(tokens[23].type, TokenType::IDENTIFIER); // x
-    EXPECT_EQ(tokens[24].type, TokenType::OPERATOR);  // =
+    EXPECT_EQ(tokens[19].type, TokenType::IF);        // If
+    EXPECT_EQ(tokens[20].type, TokenType::IDENTIFIER); // x
+    EXPECT_EQ(tokens[21].type, TokenType::OPERATOR);  // >
+    EXPECT_EQ(tokens[22].type, TokenType::NUMBER);    // 0
+    EXPECT_EQ(tokens[23].type, TokenType::KEYWORD);   // Then
+
+    EXPECT_EQ(tokens[24].type, TokenType::ASSIGN);    // Assign
     EXPECT_EQ(tokens[25].type, TokenType::IDENTIFIER); // x
-    EXPECT_EQ(tokens[26].type, TokenType::OPERATOR);  // +
-    EXPECT_EQ(tokens[27].type, TokenType::NUMBER);    // 1
+    EXPECT_EQ(tokens[26].type, TokenType::OPERATOR);  // =
+    EXPECT_EQ(tokens[27].type, TokenType::IDENTIFIER); // x
+    EXPECT_EQ(tokens[28].type, TokenType::OPERATOR);  // +
+    EXPECT_EQ(tokens[29].type, TokenType::NUMBER);    // 1
 
-    EXPECT_EQ(tokens[28].type, TokenType::ELSE);      // Else
-    EXPECT_EQ(tokens[29].type, TokenType::ASSIGN);    // Assign
-    EXPECT_EQ(tokens[30].type, TokenType::IDENTIFIER); // x
-    EXPECT_EQ(tokens[31].type, TokenType::OPERATOR);  // =
-    EXPECT_EQ(tokens[32].type, TokenType::NUMBER);    // 0
+    EXPECT_EQ(tokens[30].type, TokenType::ELSE);      // Else
+    EXPECT_EQ(tokens[31].type, TokenType::ASSIGN);    // Assign
+    EXPECT_EQ(tokens[32].type, TokenType::IDENTIFIER); // x
+    EXPECT_EQ(tokens[33].type, TokenType::OPERATOR);  // =
+    EXPECT_EQ(tokens[34].type, TokenType::NUMBER);    // 0
 
-    EXPECT_EQ(tokens[33].type, TokenType::END);       // End
-    EXPECT_EQ(tokens[34].type, TokenType::IF);        // If
+    EXPECT_EQ(tokens[35].type, TokenType::END);       // End
+    EXPECT_EQ(tokens[36].type, TokenType::IF);        // If
 
     // Verify loops
-    EXPECT_EQ(tokens[35].type, TokenType::FOR);       // For
-    EXPECT_EQ(tokens[36].type, TokenType::IDENTIFIER); // i
-    EXPECT_EQ(tokens[37].type, TokenType::OPERATOR);  // =
-    EXPECT_EQ(tokens[38].type, TokenType::NUMBER);    // 0
-    EXPECT_EQ(tokens[39].type, TokenType::KEYWORD);   // To
-    EXPECT_EQ(tokens[40].type, TokenType::NUMBER);    // 5
-    EXPECT_EQ(tokens[41].type, TokenType::KEYWORD);   // Do
-
-    EXPECT_EQ(tokens[42].type, TokenType::ASSIGN);    // Assign
-    EXPECT_EQ(tokens[43].type, TokenType::IDENTIFIER); // arr
-    EXPECT_EQ(tokens[44].type, TokenType::IDENTIFIER); // i
-    EXPECT_EQ(tokens[45].type, TokenType::OPERATOR);  // =
-    EXPECT_EQ(tokens[46].type, TokenType::IDENTIFIER); // i
-    EXPECT_EQ(tokens[47].type, TokenType::OPERATOR);  // *
-    EXPECT_EQ(tokens[48].type, TokenType::NUMBER);    // 2
-
-    EXPECT_EQ(tokens[49].type, TokenType::END);       // End
-    EXPECT_EQ(tokens[50].type, TokenType::FOR);       // For
+    EXPECT_EQ(tokens[37].type, TokenType::FOR);       // For
+    EXPECT_EQ(tokens[38].type, TokenType::IDENTIFIER); // i
+    EXPECT_EQ(tokens[39].type, TokenType::OPERATOR);  // =
+    EXPECT_EQ(tokens[40].type, TokenType::NUMBER);    // 0
+    EXPECT_EQ(tokens[41].type, TokenType::KEYWORD);   // To
+    EXPECT_EQ(tokens[42].type, TokenType::NUMBER);    // 5
+    EXPECT_EQ(tokens[43].type, TokenType::KEYWORD);   // Do
+
+    EXPECT_EQ(tokens[44].type, TokenType::ASSIGN);    // Assign
+    EXPECT_EQ(tokens[45].type, TokenType::IDENTIFIER); // arr
+    EXPECT_EQ(tokens[46].type, TokenType::PUNCTUATION); // [
+    EXPECT_EQ(tokens[47].type, TokenType::IDENTIFIER); // i
+    EXPECT_EQ(tokens[48].type, TokenType::PUNCTUATION); // ]
+    EXPECT_EQ(tokens[49].type, TokenType::OPERATOR);  // =
+    EXPECT_EQ(tokens[50].type, TokenType::IDENTIFIER); // i
+    EXPECT_EQ(tokens[51].type, TokenType::OPERATOR);  // *
+    EXPECT_EQ(tokens[52].type, TokenType::NUMBER);    // 2
+
+    EXPECT_EQ(tokens[53].type, TokenType::END);       // End
+    EXPECT_EQ(tokens[54].type, TokenType::FOR);       // For
 
     // Verify while loop
-    EXPECT_EQ(tokens[51].type, TokenType::WHILE);     // While
-    EXPECT_EQ(tokens[52].type, TokenType::IDENTIFIER); // x
-    EXPECT_EQ(tokens[53].type, TokenType::OPERATOR);  // <
-    EXPECT_EQ(tokens[54].type, TokenType::NUMBER);    // 10
-    EXPECT_EQ(tokens[55].type, TokenType::KEYWORD);   // Do
+    EXPECT_EQ(tokens[55].type, TokenType::WHILE);     // While
+    EXPECT_EQ(tokens[56].type, TokenType::IDENTIFIER); // x
+    EXPECT_EQ(tokens[57].type, TokenType::OPERATOR);  // <
+    EXPECT_EQ(tokens[58].type, TokenType::NUMBER);    // 10
+    EXPECT_EQ(tokens[59].type, TokenType::KEYWORD);   // Do
 
-    EXPECT_EQ(tokens[62].type, TokenType::END);       // End
-    EXPECT_EQ(tokens[63].type, TokenType::WHILE);     // While
+    EXPECT_EQ(tokens[66].type, TokenType::END);       // End
+    EXPECT_EQ(tokens[67].type, TokenType::WHILE);     // While
 }
 
 // Test tokenizeOperator() method
@@ -183,3 +187,252 @@ TEST(TokenizerTest, HandleWhitespace) {
     EXPECT_EQ(tokens[3].type, TokenType::INTEGER);
 }
 
+
+// Test that lexemes are views into the input buffer rather than copies
+TEST(TokenizerTest, LexemesReferToInput) {
+    string input = "Print \"Hello, World!\" x1";
+    Tokenizer tokenizer(input);
+    auto tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 4); // Print, string, x1, END_OF_FILE
+    EXPECT_EQ(tokens[0].lexeme.data(), input.data());
+    EXPECT_EQ(tokens[1].lexeme.data(), input.data() + 7);
+    EXPECT_EQ(tokens[1].lexeme, "Hello, World!");
+    EXPECT_EQ(tokens[2].lexeme.data(), input.data() + input.size() - 2);
+    EXPECT_EQ(tokens[2].lexeme, "x1");
+}
+
+// Test keyword matching with and without case sensitivity
+TEST(TokenizerTest, KeywordCase) {
+    string input = "Declare arr As Array of Integer[5] declare Ends";
+
+    Tokenizer exact(input);
+    auto tokens = exact.tokenize();
+    ASSERT_EQ(tokens.size(), 12);
+    EXPECT_EQ(tokens[3].type, TokenType::ARRAY);       // Array
+    EXPECT_EQ(tokens[4].type, TokenType::IDENTIFIER);  // of
+    EXPECT_EQ(tokens[9].type, TokenType::IDENTIFIER);  // declare
+    EXPECT_EQ(tokens[10].type, TokenType::IDENTIFIER); // Ends
+
+    Tokenizer ignoreCase(input, true);
+    tokens = ignoreCase.tokenize();
+    ASSERT_EQ(tokens.size(), 12);
+    EXPECT_EQ(tokens[4].type, TokenType::KEYWORD);     // of
+    EXPECT_EQ(tokens[4].lexeme, "of");
+    EXPECT_EQ(tokens[9].type, TokenType::DECLARE);     // declare
+    EXPECT_EQ(tokens[10].type, TokenType::IDENTIFIER); // Ends
+}
+
+// Test whitespace runs, identifiers and strings longer than one SIMD block
+TEST(TokenizerTest, LongRuns) {
+    string input;
+    vector<string> lexemes;
+    for (size_t length = 1; length <= 70; length++) {
+        string identifier = "v" + string(length - 1, length % 2 ? 'Z' : '7');
+        string text = string(length, length % 3 ? 'a' : ' ');
+        input += string(length, length % 2 ? ' ' : '\t') + identifier + "\n\"" + text + "\"";
+        lexemes.push_back(identifier);
+        lexemes.push_back(text);
+    }
+
+    Tokenizer tokenizer(input);
+    auto tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), lexemes.size() + 1);
+    for (size_t ind = 0; ind < lexemes.size(); ind++) {
+        EXPECT_EQ(tokens[ind].type, ind % 2 ? TokenType::STRINGVAL : TokenType::IDENTIFIER);
+        EXPECT_EQ(tokens[ind].lexeme, lexemes[ind]);
+    }
+}
+
+// Test pulling tokens on demand through a TokenStream
+TEST(TokenizerTest, TokenStream) {
+    string input = "Assign x = 5";
+    Tokenizer tokenizer(input);
+    TokenStream stream(tokenizer);
+
+    EXPECT_EQ(stream.peek(1).lexeme, "x");
+    EXPECT_EQ(stream.peek(3).type, TokenType::NUMBER);
+    EXPECT_THROW(stream.peek(TokenStream::lookaheadSize), out_of_range);
+
+    EXPECT_EQ(stream.next().type, TokenType::ASSIGN);
+    EXPECT_EQ(stream.next().lexeme, "x");
+    EXPECT_EQ(stream.peek(2).type, TokenType::END_OF_FILE);
+    EXPECT_EQ(stream.next().lexeme, "=");
+    EXPECT_EQ(stream.next().lexeme, "5");
+    EXPECT_EQ(stream.next().type, TokenType::END_OF_FILE);
+    EXPECT_EQ(stream.next().type, TokenType::END_OF_FILE);
+}
+
+// Test that identifiers get dense ids shared by every occurrence
+TEST(TokenizerTest, InternIdentifiers) {
+    string input = "Assign x = y + x\nPrint y";
+    Tokenizer tokenizer(input);
+    auto tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 9);
+    EXPECT_EQ(tokens[0].id, Token::noId);  // Assign
+    EXPECT_EQ(tokens[1].id, 0u);           // x
+    EXPECT_EQ(tokens[2].id, Token::noId);  // =
+    EXPECT_EQ(tokens[3].id, 1u);           // y
+    EXPECT_EQ(tokens[5].id, 0u);           // x
+    EXPECT_EQ(tokens[7].id, 1u);           // y
+
+    const IdentifierTable& identifiers = tokenizer.identifierTable();
+    EXPECT_EQ(identifiers.distinctCount(), 2);
+    EXPECT_EQ(identifiers.totalCount(), 4);
+    EXPECT_EQ(identifiers.name(1), "y");
+}
+
+// Test that interning survives the table growing past its initial size
+TEST(TokenizerTest, InternManyIdentifiers) {
+    string input;
+    for (int ind = 0; ind < 1000; ind++) {
+        input += "v" + to_string(ind) + " v" + to_string(ind % 10) + " ";
+    }
+    Tokenizer tokenizer(input);
+    auto tokens = tokenizer.tokenize();
+
+    const IdentifierTable& identifiers = tokenizer.identifierTable();
+    EXPECT_EQ(identifiers.distinctCount(), 1000);
+    EXPECT_EQ(identifiers.totalCount(), 2000);
+    for (int ind = 0; ind < 1000; ind++) {
+        EXPECT_EQ(identifiers.name(tokens[2 * ind].id), "v" + to_string(ind));
+        EXPECT_EQ(tokens[2 * ind + 1].id, tokens[2 * (ind % 10)].id);
+    }
+}
+
+// Test compact struct-of-arrays token storage against the token vector
+TEST(TokenizerTest, TokenizeCompact) {
+    string input = "Declare x As Integer\nAssign x = 5\n\nPrint \"\" x";
+    auto tokens = Tokenizer(input).tokenize();
+    Tokenizer tokenizer(input);
+    TokenStore store = tokenizer.tokenizeCompact();
+
+    ASSERT_EQ(store.size(), tokens.size());
+    for (size_t ind = 0; ind < tokens.size(); ind++) {
+        EXPECT_EQ(store.type(ind), tokens[ind].type);
+        EXPECT_EQ(store.lexeme(ind), tokens[ind].lexeme);
+        EXPECT_EQ(store.id(ind), tokens[ind].id);
+    }
+    EXPECT_EQ(store.line(0), 1);   // Declare
+    EXPECT_EQ(store.line(4), 2);   // Assign
+    EXPECT_EQ(store.line(8), 4);   // Print
+    EXPECT_EQ(store.line(9), 4);   // ""
+    EXPECT_LT(store.memoryBytes(), tokens.size() * sizeof(Token));
+}
+
+// Test maximal-munch operators and punctuation
+TEST(TokenizerTest, TokenizeCompoundOperators) {
+    string input = "If a<=b && c >= d || e == f Then g[i] = h(1, 2)";
+    Tokenizer tokenizer(input);
+    auto tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 25);
+    EXPECT_EQ(tokens[2].lexeme, "<=");
+    EXPECT_EQ(tokens[4].lexeme, "&&");
+    EXPECT_EQ(tokens[6].lexeme, ">=");
+    EXPECT_EQ(tokens[8].lexeme, "||");
+    EXPECT_EQ(tokens[10].lexeme, "==");
+    EXPECT_EQ(tokens[17].lexeme, "=");
+    for (size_t ind : { 2, 4, 6, 8, 10, 17 }) {
+        EXPECT_EQ(tokens[ind].type, TokenType::OPERATOR);
+    }
+
+    EXPECT_EQ(tokens[14].lexeme, "[");
+    EXPECT_EQ(tokens[16].lexeme, "]");
+    EXPECT_EQ(tokens[19].lexeme, "(");
+    EXPECT_EQ(tokens[21].lexeme, ",");
+    EXPECT_EQ(tokens[23].lexeme, ")");
+    for (size_t ind : { 14, 16, 19, 21, 23 }) {
+        EXPECT_EQ(tokens[ind].type, TokenType::PUNCTUATION);
+    }
+}
+
+// Test token offsets and their lazy line/column lookup
+TEST(TokenizerTest, SourceLocations) {
+    string input = "Declare Integer x\r\n\n  Print \"a\nb\" , x\nx";
+    Tokenizer tokenizer(input);
+    auto tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 9);
+    for (const Token& token : tokens) {
+        EXPECT_EQ(token.offset, token.lexeme.empty() ? input.size() : token.lexeme.data() - input.data());
+    }
+
+    LineTable lines(input);
+    SourceLocation location = lines.locate(tokens[2].offset);  // x
+    EXPECT_EQ(location.line, 1);
+    EXPECT_EQ(location.column, 17);
+    location = lines.locate(tokens[3].offset);  // Print
+    EXPECT_EQ(location.line, 3);
+    EXPECT_EQ(location.column, 3);
+    location = lines.locate(tokens[6].offset);  // x after the two-line string
+    EXPECT_EQ(location.line, 4);
+    EXPECT_EQ(location.column, 6);
+    location = lines.locate(tokens[7].offset);  // x on the last line
+    EXPECT_EQ(location.line, 5);
+    EXPECT_EQ(location.column, 1);
+
+    // Long input so the 16-byte newline scan is exercised, not just the tail loop
+    string longInput;
+    for (int ind = 0; ind < 100; ind++) {
+        longInput += string(ind % 37, ' ') + "x\n";
+    }
+    LineTable longLines(longInput);
+    size_t offset = 0;
+    for (int ind = 0; ind < 100; ind++) {
+        offset += ind % 37;
+        EXPECT_EQ(longLines.lineOf(offset), ind + 1);
+        EXPECT_EQ(longLines.locate(offset).column, ind % 37 + 1);
+        offset += 2;
+    }
+}
+
+// Test that chunked parallel tokenization matches the serial path, with strings spanning chunk cuts
+TEST(TokenizerTest, TokenizeParallel) {
+    string input;
+    for (int ind = 0; ind < 200; ind++) {
+        input += "Declare Integer x" + to_string(ind % 7) + "\n";
+        input += "Print \"line one\nline two " + to_string(ind) + "\nline three\" , y\n";
+        input += "Assign x" + to_string(ind % 7) + " = x" + to_string(ind % 5) + " + 1\n";
+    }
+    input += "Print \"unterminated\n";
+
+    Tokenizer serialTokenizer(input);
+    auto serial = serialTokenizer.tokenize();
+
+    for (size_t threads : { 2, 3, 8 }) {
+        Tokenizer parallelTokenizer(input);
+        auto parallel = parallelTokenizer.tokenizeParallel(threads, 16);
+
+        ASSERT_EQ(parallel.size(), serial.size());
+        for (size_t ind = 0; ind < serial.size(); ind++) {
+            EXPECT_EQ(parallel[ind].type, serial[ind].type);
+            EXPECT_EQ(parallel[ind].lexeme, serial[ind].lexeme);
+            EXPECT_EQ(parallel[ind].lexeme.data(), serial[ind].lexeme.data());
+            EXPECT_EQ(parallel[ind].id, serial[ind].id);
+            EXPECT_EQ(parallel[ind].offset, serial[ind].offset);
+        }
+        EXPECT_EQ(parallelTokenizer.identifierTable().distinctCount(), serialTokenizer.identifierTable().distinctCount());
+        EXPECT_EQ(parallelTokenizer.identifierTable().totalCount(), serialTokenizer.identifierTable().totalCount());
+        EXPECT_EQ(parallelTokenizer.nextToken().type, TokenType::END_OF_FILE);
+    }
+}
+
+// Test that "Else If" on one line is one token and an If on the next line is not
+TEST(TokenizerTest, TokenizeElseIf) {
+    string input = "Else If x\nElse\tif y\nElse\nIf z\nElse Iffy";
+    Tokenizer tokenizer(input, true);
+    auto tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 10);
+    EXPECT_EQ(tokens[0].type, TokenType::ELSE);
+    EXPECT_EQ(tokens[0].lexeme, "Else If");
+    EXPECT_EQ(tokens[2].type, TokenType::ELSE);
+    EXPECT_EQ(tokens[2].lexeme, "Else\tif");
+    EXPECT_EQ(tokens[4].lexeme, "Else");
+    EXPECT_EQ(tokens[5].type, TokenType::IF);
+    EXPECT_EQ(tokens[7].lexeme, "Else");
+    EXPECT_EQ(tokens[8].type, TokenType::IDENTIFIER);
+}